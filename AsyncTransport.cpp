@@ -0,0 +1,227 @@
+#include "AsyncTransport.h"
+#include "CurlHandlePool.h"
+#include <curl/curl.h>
+
+// A request currently attached to the multi handle
+struct AsyncTransport::Transfer
+{
+    PooledHandle *handle;
+    JsonFrameBody body; // CURLOPT_POSTFIELDS points into it until the transfer ends
+    FrameBuffer response;
+    JsonFrameExtractor extractor;
+    TransportCallback callback;
+};
+
+AsyncTransport::AsyncTransport(const std::string &apiKey, size_t maxInFlight, long timeoutMs)
+    : pool_(new CurlHandlePool(apiKey, maxInFlight, timeoutMs)),
+      multi_(nullptr),
+      maxInFlight_(maxInFlight == 0 ? 1 : maxInFlight),
+      inFlight_(0),
+      stop_(false)
+{
+    // The pool constructor has run curl_global_init, multi handles are safe now
+    multi_ = curl_multi_init();
+    loop_ = std::thread(&AsyncTransport::run, this);
+}
+
+AsyncTransport::~AsyncTransport()
+{
+    stop_ = true;
+    curl_multi_wakeup(static_cast<CURLM *>(multi_));
+    if (loop_.joinable())
+        loop_.join();
+    curl_multi_cleanup(static_cast<CURLM *>(multi_));
+}
+
+void AsyncTransport::submit(const std::string &url, const FrameBuffer &request, TransportCallback callback)
+{
+    submitAfter(std::chrono::milliseconds(0), url, request, std::move(callback));
+}
+
+void AsyncTransport::submitAfter(std::chrono::milliseconds delay, const std::string &url,
+                                 const FrameBuffer &request, TransportCallback callback)
+{
+    Request queued;
+    queued.url = url;
+    queued.body.build(request);
+    queued.callback = std::move(callback);
+
+    bool accepted = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!stop_)
+        {
+            if (delay.count() <= 0)
+                pending_.push_back(std::move(queued));
+            else
+                delayed_.emplace(std::chrono::steady_clock::now() + delay, std::move(queued));
+            accepted = true;
+        }
+    }
+    if (!accepted)
+    {
+        // Transport is shutting down, fail immediately
+        queued.callback(false, FrameBuffer());
+        return;
+    }
+    // Starts the request, or lets the loop shorten its poll timeout to the new due time
+    curl_multi_wakeup(static_cast<CURLM *>(multi_));
+}
+
+std::future<TransportResult> AsyncTransport::submit(const std::string &url, const FrameBuffer &request)
+{
+    auto promise = std::make_shared<std::promise<TransportResult>>();
+    std::future<TransportResult> future = promise->get_future();
+    submit(url, request, [promise](bool ok, const FrameBuffer &response)
+           {
+               TransportResult result;
+               result.ok = ok;
+               result.frame = response;
+               promise->set_value(std::move(result)); });
+    return future;
+}
+
+size_t AsyncTransport::inFlight() const
+{
+    return inFlight_;
+}
+
+// Move delayed requests whose time has come to the back of the FIFO
+void AsyncTransport::promoteDelayed()
+{
+    auto now = std::chrono::steady_clock::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!delayed_.empty() && delayed_.begin()->first <= now)
+    {
+        pending_.push_back(std::move(delayed_.begin()->second));
+        delayed_.erase(delayed_.begin());
+    }
+}
+
+// Move queued requests onto the multi handle while there is window left
+void AsyncTransport::startPending()
+{
+    CURLM *multi = static_cast<CURLM *>(multi_);
+    while (inFlight_ < maxInFlight_)
+    {
+        Request request;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_.empty())
+                return;
+            request = std::move(pending_.front());
+            pending_.pop_front();
+        }
+
+        PooledHandle *handle = pool_->tryAcquire();
+        if (!handle)
+        {
+            request.callback(false, FrameBuffer());
+            continue;
+        }
+
+        // The response hex is decoded into the transfer's frame as curl delivers it
+        Transfer *transfer = new Transfer;
+        transfer->handle = handle;
+        transfer->body = request.body;
+        transfer->extractor.reset(transfer->response);
+        transfer->callback = std::move(request.callback);
+
+        CURL *curl = handle->curl;
+        curl_easy_setopt(curl, CURLOPT_URL, request.url.c_str());
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, transfer->body.data);
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(transfer->body.size));
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, JsonFrameExtractor::curlWrite);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer->extractor);
+        curl_easy_setopt(curl, CURLOPT_PRIVATE, transfer);
+
+        if (curl_multi_add_handle(multi, curl) != CURLM_OK)
+        {
+            finishTransfer(transfer, false);
+            continue;
+        }
+        active_.insert(transfer);
+        ++inFlight_;
+    }
+}
+
+void AsyncTransport::finishTransfer(Transfer *transfer, bool ok)
+{
+    ok = ok && transfer->extractor.found();
+    if (!ok)
+        transfer->response.size = 0;
+
+    TransportCallback callback = std::move(transfer->callback);
+    pool_->release(transfer->handle);
+
+    // Callbacks may submit follow-up requests (e.g. retries), so run them last
+    callback(ok, transfer->response);
+    delete transfer;
+}
+
+// ========== Event loop ==========
+void AsyncTransport::run()
+{
+    CURLM *multi = static_cast<CURLM *>(multi_);
+    while (!stop_)
+    {
+        promoteDelayed();
+        startPending();
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        CURLMsg *msg;
+        int remaining = 0;
+        while ((msg = curl_multi_info_read(multi, &remaining)))
+        {
+            if (msg->msg != CURLMSG_DONE)
+                continue;
+            CURL *curl = msg->easy_handle;
+            CURLcode result = msg->data.result;
+            Transfer *transfer = nullptr;
+            curl_easy_getinfo(curl, CURLINFO_PRIVATE, &transfer);
+            curl_multi_remove_handle(multi, curl);
+            active_.erase(transfer);
+            --inFlight_;
+            finishTransfer(transfer, result == CURLE_OK);
+        }
+
+        // Sleeps until socket activity, a curl timeout, the next delayed
+        // request or curl_multi_wakeup()
+        int timeoutMs = 1000;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!delayed_.empty())
+            {
+                auto untilDue = std::chrono::duration_cast<std::chrono::milliseconds>(
+                                    delayed_.begin()->first - std::chrono::steady_clock::now())
+                                    .count() +
+                                1;
+                if (untilDue < timeoutMs)
+                    timeoutMs = untilDue < 0 ? 0 : static_cast<int>(untilDue);
+            }
+        }
+        curl_multi_poll(multi, nullptr, 0, timeoutMs, nullptr);
+    }
+
+    // Fail everything still outstanding so no caller waits forever
+    for (Transfer *transfer : active_)
+    {
+        curl_multi_remove_handle(multi, transfer->handle->curl);
+        --inFlight_;
+        finishTransfer(transfer, false);
+    }
+    active_.clear();
+
+    std::deque<Request> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        abandoned.swap(pending_);
+        for (auto &entry : delayed_)
+            abandoned.push_back(std::move(entry.second));
+        delayed_.clear();
+    }
+    for (auto &request : abandoned)
+        request.callback(false, FrameBuffer());
+}
@@ -0,0 +1,83 @@
+#ifndef ASYNC_TRANSPORT_H
+#define ASYNC_TRANSPORT_H
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include "JsonFrame.h"
+#include "ModbusFrame.h"
+
+class CurlHandlePool;
+
+// Completion callback, invoked on the transport's event loop thread. On ok,
+// response holds the RTU frame received (size 0 if its hex was undecodable);
+// it is only valid during the call.
+typedef std::function<void(bool ok, const FrameBuffer &response)> TransportCallback;
+
+struct TransportResult
+{
+    bool ok = false;
+    FrameBuffer frame;
+};
+
+// Non-blocking HTTP transport driven by a single curl_multi event loop.
+// Any number of requests may be submitted; up to maxInFlight of them are on
+// the wire at once, the rest wait in a FIFO queue.
+class AsyncTransport
+{
+public:
+    AsyncTransport(const std::string &apiKey, size_t maxInFlight, long timeoutMs);
+    ~AsyncTransport();
+
+    AsyncTransport(const AsyncTransport &) = delete;
+    AsyncTransport &operator=(const AsyncTransport &) = delete;
+
+    // Queue a frame for POSTing to url, callback fires once with the outcome
+    void submit(const std::string &url, const FrameBuffer &request, TransportCallback callback);
+
+    // Same, but the request is only started once delay has elapsed (retry backoff
+    // without blocking the event loop)
+    void submitAfter(std::chrono::milliseconds delay, const std::string &url, const FrameBuffer &request,
+                     TransportCallback callback);
+
+    // Future based convenience wrapper around submit()
+    std::future<TransportResult> submit(const std::string &url, const FrameBuffer &request);
+
+    size_t inFlight() const;
+
+private:
+    struct Request
+    {
+        std::string url;
+        JsonFrameBody body; // Encoded by the submitting thread
+        TransportCallback callback;
+    };
+    struct Transfer;
+
+    void run();
+    void promoteDelayed();
+    void startPending();
+    void finishTransfer(Transfer *transfer, bool ok);
+
+    std::unique_ptr<CurlHandlePool> pool_;
+    void *multi_; // CURLM, kept opaque so callers need not include curl.h
+    size_t maxInFlight_;
+
+    mutable std::mutex mutex_;
+    std::deque<Request> pending_;
+    std::multimap<std::chrono::steady_clock::time_point, Request> delayed_;
+    std::set<Transfer *> active_; // Only touched by the event loop thread
+    std::atomic<size_t> inFlight_;
+    std::atomic<bool> stop_;
+    std::thread loop_;
+};
+
+#endif
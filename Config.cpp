@@ -65,6 +65,11 @@ uint8_t Config::getDefaultSlaveAddress() const
         return 0x11; // Default fallback
     }
 
+    return parseSlaveAddress(value);
+}
+
+uint8_t Config::parseSlaveAddress(const std::string &value)
+{
     // Handle hex format (0x11 or 11)
     if (value.substr(0, 2) == "0x" || value.substr(0, 2) == "0X")
     {
@@ -76,6 +81,403 @@ uint8_t Config::getDefaultSlaveAddress() const
     }
 }
 
+std::vector<DeviceConfig> Config::getFleetDevices() const
+{
+    std::vector<DeviceConfig> devices;
+    std::stringstream list(getValue("FLEET", "devices"));
+    std::string item;
+    while (std::getline(list, item, ','))
+    {
+        size_t start = item.find_first_not_of(" \t");
+        if (start == std::string::npos)
+            continue;
+        size_t end = item.find_last_not_of(" \t");
+        std::string address = item.substr(start, end - start + 1);
+
+        DeviceConfig device;
+        device.slaveAddress = parseSlaveAddress(address);
+        std::string section = "DEVICE_" + address;
+        device.readUrl = getValue(section, "read_url");
+        device.writeUrl = getValue(section, "write_url");
+        if (device.readUrl.empty())
+            device.readUrl = getReadUrl();
+        if (device.writeUrl.empty())
+            device.writeUrl = getWriteUrl();
+        device.transport = getValue(section, "transport");
+        if (device.transport.empty())
+            device.transport = getTransportType();
+        device.host = getValue(section, "host");
+        if (device.host.empty())
+            device.host = getTransportHost();
+        std::string port = getValue(section, "port");
+        device.port = port.empty() ? getTransportPort() : static_cast<uint16_t>(std::stoul(port));
+        devices.push_back(device);
+    }
+
+    if (devices.empty())
+    {
+        devices.push_back(DeviceConfig{getDefaultSlaveAddress(), getReadUrl(), getWriteUrl(),
+                                       getTransportType(), getTransportHost(), getTransportPort()});
+    }
+    return devices;
+}
+
+size_t Config::getFleetWorkerThreads() const
+{
+    std::string value = getValue("FLEET", "worker_threads");
+    if (value.empty())
+    {
+        return 4; // Default fallback
+    }
+    return static_cast<size_t>(std::stoul(value));
+}
+
+std::string Config::getTransportType() const
+{
+    std::string value = getValue("TRANSPORT", "type");
+    if (value.empty())
+    {
+        return "http"; // Default fallback
+    }
+    return value;
+}
+
+std::string Config::getTransportHost() const
+{
+    return getValue("TRANSPORT", "host");
+}
+
+uint16_t Config::getTransportPort() const
+{
+    std::string value = getValue("TRANSPORT", "port");
+    if (value.empty())
+    {
+        return 502; // Default fallback
+    }
+    return static_cast<uint16_t>(std::stoul(value));
+}
+
+long Config::getTransportTimeoutMs() const
+{
+    std::string value = getValue("TRANSPORT", "timeout_ms");
+    if (value.empty())
+    {
+        return 3000; // Default fallback
+    }
+    return std::stol(value);
+}
+
+size_t Config::getTransportWindow() const
+{
+    std::string value = getValue("TRANSPORT", "window");
+    if (value.empty())
+    {
+        return 8; // Default fallback
+    }
+    return static_cast<size_t>(std::stoul(value));
+}
+
+bool Config::getTransportCoalesceReads() const
+{
+    std::string value = getValue("TRANSPORT", "coalesce_reads");
+    if (value.empty())
+    {
+        return true; // Default fallback
+    }
+    return value == "true" || value == "1" || value == "yes";
+}
+
+size_t Config::getHttpPoolSize() const
+{
+    std::string value = getValue("HTTP", "pool_size");
+    if (value.empty())
+    {
+        return 4; // Default fallback
+    }
+    return static_cast<size_t>(std::stoul(value));
+}
+
+long Config::getHttpTimeoutMs() const
+{
+    std::string value = getValue("HTTP", "timeout_ms");
+    if (value.empty())
+    {
+        return 10000; // Default fallback
+    }
+    return std::stol(value);
+}
+
+size_t Config::getHttpMaxInFlight() const
+{
+    std::string value = getValue("HTTP", "max_in_flight");
+    if (value.empty())
+    {
+        return 32; // Default fallback
+    }
+    return static_cast<size_t>(std::stoul(value));
+}
+
+uint16_t Config::getPollMaxRegisterGap() const
+{
+    std::string value = getValue("POLLING", "max_register_gap");
+    if (value.empty())
+    {
+        return 0; // Default fallback: only merge adjacent registers
+    }
+    return static_cast<uint16_t>(std::stoul(value));
+}
+
+long Config::getPollIntervalMs() const
+{
+    std::string value = getValue("POLLING", "poll_interval_ms");
+    if (value.empty())
+    {
+        return 5000; // Default fallback
+    }
+    return std::stol(value);
+}
+
+long Config::getParameterIntervalMs(const std::string &parameterName) const
+{
+    std::string value = getValue("POLLING", parameterName + "_interval_ms");
+    if (value.empty())
+    {
+        return 0; // Poll every cycle
+    }
+    return std::stol(value);
+}
+
+std::string Config::getParameterDeadband(const std::string &parameterName) const
+{
+    return getValue("POLLING", parameterName + "_deadband");
+}
+
+long Config::getParameterHeartbeatMs(const std::string &parameterName) const
+{
+    std::string value = getValue("POLLING", parameterName + "_heartbeat_ms");
+    if (value.empty())
+    {
+        return 0; // No heartbeat
+    }
+    return std::stol(value);
+}
+
+size_t Config::getBufferCapacity() const
+{
+    std::string value = getValue("BUFFER", "capacity");
+    if (value.empty())
+    {
+        return 30; // Default fallback
+    }
+    return static_cast<size_t>(std::stoul(value));
+}
+
+std::string Config::getBufferOverflowPolicy() const
+{
+    std::string value = getValue("BUFFER", "overflow_policy");
+    if (value.empty())
+    {
+        return "drop_newest"; // Default fallback
+    }
+    return value;
+}
+
+int Config::getRetryMaxAttempts() const
+{
+    std::string value = getValue("RETRY", "max_attempts");
+    if (value.empty())
+    {
+        return 3; // Default fallback
+    }
+    return std::stoi(value);
+}
+
+long Config::getRetryInitialBackoffMs() const
+{
+    std::string value = getValue("RETRY", "initial_backoff_ms");
+    if (value.empty())
+    {
+        return 100; // Default fallback
+    }
+    return std::stol(value);
+}
+
+double Config::getRetryBackoffMultiplier() const
+{
+    std::string value = getValue("RETRY", "backoff_multiplier");
+    if (value.empty())
+    {
+        return 2.0; // Default fallback
+    }
+    return std::stod(value);
+}
+
+long Config::getRetryMaxBackoffMs() const
+{
+    std::string value = getValue("RETRY", "max_backoff_ms");
+    if (value.empty())
+    {
+        return 2000; // Default fallback
+    }
+    return std::stol(value);
+}
+
+double Config::getRetryJitter() const
+{
+    std::string value = getValue("RETRY", "jitter");
+    if (value.empty())
+    {
+        return 0.2; // Default fallback
+    }
+    return std::stod(value);
+}
+
+long Config::getRetryDeadlineMs() const
+{
+    std::string value = getValue("RETRY", "deadline_ms");
+    if (value.empty())
+    {
+        return 5000; // Default fallback
+    }
+    return std::stol(value);
+}
+
+unsigned Config::getBreakerFailureThreshold() const
+{
+    std::string value = getValue("RETRY", "breaker_failure_threshold");
+    if (value.empty())
+    {
+        return 5; // Default fallback
+    }
+    return static_cast<unsigned>(std::stoul(value));
+}
+
+long Config::getBreakerCooldownMs() const
+{
+    std::string value = getValue("RETRY", "breaker_cooldown_ms");
+    if (value.empty())
+    {
+        return 30000; // Default fallback
+    }
+    return std::stol(value);
+}
+
+std::string Config::getRegisterMapFile() const
+{
+    return getValue("REGISTERS", "map_file");
+}
+
+std::string Config::getStoreDirectory() const
+{
+    return getValue("STORE", "directory");
+}
+
+size_t Config::getStoreRecordsPerSegment() const
+{
+    std::string value = getValue("STORE", "records_per_segment");
+    if (value.empty())
+    {
+        return 4096; // Default fallback
+    }
+    return static_cast<size_t>(std::stoul(value));
+}
+
+size_t Config::getStoreMaxSegments() const
+{
+    std::string value = getValue("STORE", "max_segments");
+    if (value.empty())
+    {
+        return 64; // Default fallback
+    }
+    return static_cast<size_t>(std::stoul(value));
+}
+
+long Config::getAggregationWindowMs() const
+{
+    std::string value = getValue("AGGREGATION", "window_ms");
+    if (value.empty())
+    {
+        return 0; // Default fallback: raw samples
+    }
+    return std::stol(value);
+}
+
+std::string Config::getUploadUrl() const
+{
+    return getValue("UPLOAD", "url");
+}
+
+long Config::getUploadIntervalMs() const
+{
+    std::string value = getValue("UPLOAD", "interval_ms");
+    if (value.empty())
+    {
+        return 30000; // Default fallback
+    }
+    return std::stol(value);
+}
+
+bool Config::getUploadCompress() const
+{
+    std::string value = getValue("UPLOAD", "compress");
+    if (value.empty())
+    {
+        return true; // Default fallback
+    }
+    return value == "true" || value == "1" || value == "yes";
+}
+
+int Config::getUploadMaxAttempts() const
+{
+    std::string value = getValue("UPLOAD", "max_attempts");
+    if (value.empty())
+    {
+        return 3; // Default fallback
+    }
+    return std::stoi(value);
+}
+
+size_t Config::getUploadMaxBatchSamples() const
+{
+    std::string value = getValue("UPLOAD", "max_batch_samples");
+    if (value.empty())
+    {
+        return 1000; // Default fallback
+    }
+    return static_cast<size_t>(std::stoul(value));
+}
+
+long Config::getMetricsIntervalMs() const
+{
+    std::string value = getValue("METRICS", "interval_ms");
+    if (value.empty())
+    {
+        return 60000; // Default fallback
+    }
+    return std::stol(value);
+}
+
+std::string Config::getMetricsPrometheusFile() const
+{
+    return getValue("METRICS", "prometheus_file");
+}
+
+bool Config::getMetricsTextDump() const
+{
+    std::string value = getValue("METRICS", "text_dump");
+    if (value.empty())
+    {
+        return false; // Default fallback
+    }
+    return value == "true" || value == "1" || value == "yes";
+}
+
+void Config::setValue(const std::string &section, const std::string &key, const std::string &value)
+{
+    config_[section + "." + key] = value;
+    loaded_ = true;
+}
+
 bool Config::isLoaded() const
 {
     return loaded_;
@@ -3,8 +3,20 @@
 
 #include <string>
 #include <map>
+#include <vector>
 #include <cstdint>
 
+// One inverter polled by the fleet poller
+struct DeviceConfig
+{
+    uint8_t slaveAddress;
+    std::string readUrl;  // Defaults to [ENDPOINTS] read_url
+    std::string writeUrl; // Defaults to [ENDPOINTS] write_url
+    std::string transport; // Defaults to [TRANSPORT] type
+    std::string host;      // Defaults to [TRANSPORT] host
+    uint16_t port = 502;   // Defaults to [TRANSPORT] port
+};
+
 class Config
 {
 public:
@@ -20,6 +32,81 @@ public:
     std::string getWriteUrl() const;
     uint8_t getDefaultSlaveAddress() const;
 
+    // HTTP transport settings (optional, defaults applied when absent)
+    size_t getHttpPoolSize() const;
+    long getHttpTimeoutMs() const;
+    size_t getHttpMaxInFlight() const;
+
+    // Frame transport: http, modbus_tcp or rtu_over_tcp, the gateway address
+    // for the TCP backends and their connect/response timeout
+    std::string getTransportType() const;
+    std::string getTransportHost() const;
+    uint16_t getTransportPort() const;
+    long getTransportTimeoutMs() const;
+    size_t getTransportWindow() const;
+    // Single-flight for concurrent reads of overlapping register ranges
+    bool getTransportCoalesceReads() const;
+
+    // Polling settings
+    uint16_t getPollMaxRegisterGap() const;
+    long getPollIntervalMs() const;
+    // Period for one parameter (<name>_interval_ms), 0 when not configured
+    long getParameterIntervalMs(const std::string &parameterName) const;
+    // Change detection for one parameter: <name>_deadband ("0.5" or "2%", empty
+    // when not configured) and <name>_heartbeat_ms (0 when not configured)
+    std::string getParameterDeadband(const std::string &parameterName) const;
+    long getParameterHeartbeatMs(const std::string &parameterName) const;
+
+    // Sample buffer settings
+    size_t getBufferCapacity() const;
+    std::string getBufferOverflowPolicy() const;
+
+    // Fleet settings: [FLEET] devices lists slave addresses, optional
+    // [DEVICE_<address>] sections override the endpoints and transport of one device.
+    // Falls back to the single default slave when no fleet is configured.
+    std::vector<DeviceConfig> getFleetDevices() const;
+    size_t getFleetWorkerThreads() const;
+
+    // Retry policy and per-device circuit breaker
+    int getRetryMaxAttempts() const;
+    long getRetryInitialBackoffMs() const;
+    double getRetryBackoffMultiplier() const;
+    long getRetryMaxBackoffMs() const;
+    double getRetryJitter() const;
+    long getRetryDeadlineMs() const;
+    unsigned getBreakerFailureThreshold() const;
+    long getBreakerCooldownMs() const;
+
+    // Register map descriptor file, empty for the built-in layout
+    std::string getRegisterMapFile() const;
+
+    // Persistent sample store: directory (empty keeps samples in RAM only),
+    // records per segment file and the segment cap
+    std::string getStoreDirectory() const;
+    size_t getStoreRecordsPerSegment() const;
+    size_t getStoreMaxSegments() const;
+
+    // On-device aggregation window, 0 uploads raw samples
+    long getAggregationWindowMs() const;
+
+    // Batched upload: target URL (empty prints batches instead), period,
+    // zlib compression of the encoded batch, attempts and samples per batch
+    std::string getUploadUrl() const;
+    long getUploadIntervalMs() const;
+    bool getUploadCompress() const;
+    int getUploadMaxAttempts() const;
+    size_t getUploadMaxBatchSamples() const;
+
+    // Metrics export: period, Prometheus text file (empty disables) and
+    // whether a summary is printed every period
+    long getMetricsIntervalMs() const;
+    std::string getMetricsPrometheusFile() const;
+    bool getMetricsTextDump() const;
+
+    // Override one value in memory, e.g. to point the endpoints at a local
+    // simulator. Marks the configuration as loaded.
+    void setValue(const std::string &section, const std::string &key, const std::string &value);
+
     // Check if configuration is loaded
     bool isLoaded() const;
 
@@ -36,6 +123,7 @@ private:
     std::string trim(const std::string &str);
     std::string getValue(const std::string &section, const std::string &key) const;
     void parseLine(const std::string &line, std::string &currentSection);
+    static uint8_t parseSlaveAddress(const std::string &value);
 };
 
 #endif
@@ -0,0 +1,131 @@
+#include "CurlHandlePool.h"
+
+// ========== CURL callback ==========
+static size_t write_callback(void *contents, size_t size, size_t nmemb, void *userp)
+{
+    ((std::string *)userp)->append((char *)contents, size * nmemb);
+    return size * nmemb;
+}
+
+static void globalInit()
+{
+    // curl_global_init is not thread-safe, make sure it only ever runs once
+    static std::once_flag flag;
+    std::call_once(flag, []()
+                   { curl_global_init(CURL_GLOBAL_DEFAULT); });
+}
+
+CurlHandlePool::CurlHandlePool(const std::string &apiKey, size_t maxHandles, long timeoutMs,
+                               const std::string &contentType)
+    : maxHandles_(maxHandles == 0 ? 1 : maxHandles), timeoutMs_(timeoutMs)
+{
+    globalInit();
+
+    headers_ = curl_slist_append(headers_, ("Content-Type: " + contentType).c_str());
+    headers_ = curl_slist_append(headers_, ("Authorization: " + apiKey).c_str());
+    // Larger bodies would otherwise wait for a 100 Continue the server may never send
+    headers_ = curl_slist_append(headers_, "Expect:");
+
+    share_ = curl_share_init();
+    if (share_)
+    {
+        curl_share_setopt(share_, CURLSHOPT_LOCKFUNC, &CurlHandlePool::lockShare);
+        curl_share_setopt(share_, CURLSHOPT_UNLOCKFUNC, &CurlHandlePool::unlockShare);
+        curl_share_setopt(share_, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share_, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT);
+    }
+}
+
+CurlHandlePool::~CurlHandlePool()
+{
+    for (auto &handle : handles_)
+    {
+        if (handle->curl)
+            curl_easy_cleanup(handle->curl);
+    }
+    if (share_)
+        curl_share_cleanup(share_);
+    curl_slist_free_all(headers_);
+}
+
+std::unique_ptr<PooledHandle> CurlHandlePool::createHandle()
+{
+    std::unique_ptr<PooledHandle> handle(new PooledHandle());
+    handle->curl = curl_easy_init();
+    if (!handle->curl)
+        return nullptr;
+
+    // Options that never change between requests are set once here
+    CURL *curl = handle->curl;
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers_);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &handle->response);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L); // Required when used from several threads
+    if (timeoutMs_ > 0)
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeoutMs_);
+    if (share_)
+        curl_easy_setopt(curl, CURLOPT_SHARE, share_);
+
+    handle->body.reserve(64);
+    handle->response.reserve(256);
+    return handle;
+}
+
+PooledHandle *CurlHandlePool::acquire()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (idle_.empty())
+    {
+        if (handles_.size() < maxHandles_)
+        {
+            auto handle = createHandle();
+            if (!handle)
+                return nullptr;
+            handles_.push_back(std::move(handle));
+            return handles_.back().get();
+        }
+        available_.wait(lock);
+    }
+    PooledHandle *handle = idle_.back();
+    idle_.pop_back();
+    return handle;
+}
+
+PooledHandle *CurlHandlePool::tryAcquire()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (idle_.empty())
+    {
+        if (handles_.size() >= maxHandles_)
+            return nullptr;
+        auto handle = createHandle();
+        if (!handle)
+            return nullptr;
+        handles_.push_back(std::move(handle));
+        return handles_.back().get();
+    }
+    PooledHandle *handle = idle_.back();
+    idle_.pop_back();
+    return handle;
+}
+
+void CurlHandlePool::release(PooledHandle *handle)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        idle_.push_back(handle);
+    }
+    available_.notify_one();
+}
+
+void CurlHandlePool::lockShare(CURL *, curl_lock_data data, curl_lock_access, void *userp)
+{
+    static_cast<CurlHandlePool *>(userp)->shareLocks_[data].lock();
+}
+
+void CurlHandlePool::unlockShare(CURL *, curl_lock_data data, void *userp)
+{
+    static_cast<CurlHandlePool *>(userp)->shareLocks_[data].unlock();
+}
@@ -0,0 +1,81 @@
+#ifndef CURL_HANDLE_POOL_H
+#define CURL_HANDLE_POOL_H
+
+#include <curl/curl.h>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// A long-lived easy handle together with the buffers reused across requests.
+// Responses go to `response` unless the caller installs its own
+// CURLOPT_WRITEFUNCTION/WRITEDATA per request (ProtocolAdapter streams them).
+struct PooledHandle
+{
+    CURL *curl = nullptr;
+    std::string body;     // Request body, rebuilt in place for every request
+    std::string response; // Response body, cleared (capacity kept) for every request
+};
+
+// Pool of libcurl easy handles shared by all threads using one ProtocolAdapter.
+// Handles keep their connection alive between requests and share a DNS and
+// connection cache, so only the first request to a host pays the handshake.
+class CurlHandlePool
+{
+public:
+    CurlHandlePool(const std::string &apiKey, size_t maxHandles, long timeoutMs,
+                   const std::string &contentType = "application/json");
+    ~CurlHandlePool();
+
+    CurlHandlePool(const CurlHandlePool &) = delete;
+    CurlHandlePool &operator=(const CurlHandlePool &) = delete;
+
+    // Borrow a handle, blocking while all maxHandles are in use
+    PooledHandle *acquire();
+    // Non-blocking variant for event loops, returns nullptr when exhausted
+    PooledHandle *tryAcquire();
+    void release(PooledHandle *handle);
+
+    // RAII helper returning the handle to the pool on scope exit
+    class Lease
+    {
+    public:
+        explicit Lease(CurlHandlePool &pool) : pool_(pool), handle_(pool.acquire()) {}
+        ~Lease()
+        {
+            if (handle_)
+                pool_.release(handle_);
+        }
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+
+        PooledHandle *operator->() const { return handle_; }
+        PooledHandle *get() const { return handle_; }
+
+    private:
+        CurlHandlePool &pool_;
+        PooledHandle *handle_;
+    };
+
+private:
+    std::unique_ptr<PooledHandle> createHandle();
+
+    std::mutex mutex_;
+    std::condition_variable available_;
+    std::vector<std::unique_ptr<PooledHandle>> handles_;
+    std::vector<PooledHandle *> idle_;
+    size_t maxHandles_;
+    long timeoutMs_;
+
+    // Built once and shared read-only by every handle
+    curl_slist *headers_ = nullptr;
+    CURLSH *share_ = nullptr;
+    std::mutex shareLocks_[CURL_LOCK_DATA_LAST];
+
+    static void lockShare(CURL *, curl_lock_data data, curl_lock_access, void *userp);
+    static void unlockShare(CURL *, curl_lock_data data, void *userp);
+};
+
+#endif
@@ -0,0 +1,26 @@
+#include "DataBuffer.h"
+
+OverflowPolicy parseOverflowPolicy(const std::string &name, OverflowPolicy fallback)
+{
+    if (name == "drop_oldest")
+        return OverflowPolicy::DROP_OLDEST;
+    if (name == "drop_newest")
+        return OverflowPolicy::DROP_NEWEST;
+    if (name == "block")
+        return OverflowPolicy::BLOCK;
+    return fallback;
+}
+
+const char *overflowPolicyName(OverflowPolicy policy)
+{
+    switch (policy)
+    {
+    case OverflowPolicy::DROP_OLDEST:
+        return "drop_oldest";
+    case OverflowPolicy::DROP_NEWEST:
+        return "drop_newest";
+    case OverflowPolicy::BLOCK:
+        return "block";
+    }
+    return "unknown";
+}
@@ -0,0 +1,114 @@
+#ifndef DATA_BUFFER_H
+#define DATA_BUFFER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+#include "PollingConfig.h"
+#include "RingBuffer.h"
+
+// What append() does when the buffer is full
+enum class OverflowPolicy
+{
+    DROP_OLDEST, // Evict the oldest buffered sample to make room
+    DROP_NEWEST, // Discard the sample being appended
+    BLOCK        // Wait until the uploader has drained some samples
+};
+
+OverflowPolicy parseOverflowPolicy(const std::string &name, OverflowPolicy fallback);
+const char *overflowPolicyName(OverflowPolicy policy);
+
+// Lock-free sample buffer between pollers and the uploader
+template <typename Ring>
+class BasicDataBuffer
+{
+public:
+    explicit BasicDataBuffer(size_t cap, OverflowPolicy policy = OverflowPolicy::DROP_NEWEST)
+        : ring_(cap), policy_(policy), dropped_(0) {}
+
+    bool hasSpace() const
+    {
+        return ring_.size() < ring_.capacity();
+    }
+
+    // Returns false if the new sample was not stored (DROP_NEWEST on a full buffer)
+    bool append(Sample s)
+    {
+        int spins = 0;
+        while (!ring_.tryPush(std::move(s)))
+        {
+            switch (policy_)
+            {
+            case OverflowPolicy::DROP_NEWEST:
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            case OverflowPolicy::DROP_OLDEST:
+            {
+                Sample evicted;
+                if (ring_.tryPop(evicted))
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+            case OverflowPolicy::BLOCK:
+                // Short spin first, then back off so a slow uploader is not starved
+                if (++spins < 64)
+                    std::this_thread::yield();
+                else
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                break;
+            }
+        }
+        return true;
+    }
+
+    // Hand every buffered sample to fn(Sample &) in place; returns the count
+    template <typename Fn>
+    size_t drain(Fn fn)
+    {
+        return ring_.consume(fn);
+    }
+
+    // Move every buffered sample into out (cleared first, capacity reused)
+    size_t drainInto(std::vector<Sample> &out)
+    {
+        out.clear();
+        return ring_.consume([&out](Sample &s)
+                             { out.push_back(std::move(s)); });
+    }
+
+    // Append every buffered sample to a struct-of-arrays batch (cleared first)
+    size_t drainInto(SampleBatch &out)
+    {
+        out.clear();
+        return ring_.consume([&out](Sample &s)
+                             { out.append(s); });
+    }
+
+    std::vector<Sample> flush()
+    {
+        std::vector<Sample> out;
+        drainInto(out);
+        return out;
+    }
+
+    size_t size() const { return ring_.size(); }
+    size_t capacity() const { return ring_.capacity(); }
+    OverflowPolicy policy() const { return policy_; }
+    uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    Ring ring_;
+    OverflowPolicy policy_;
+    std::atomic<uint64_t> dropped_;
+};
+
+// Single poller thread feeding the uploader
+typedef BasicDataBuffer<SpscRingBuffer<Sample>> DataBuffer;
+
+// Several poller threads feeding one uploader
+typedef BasicDataBuffer<MpscRingBuffer<Sample>> SharedDataBuffer;
+
+#endif
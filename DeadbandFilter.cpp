@@ -0,0 +1,51 @@
+#include "DeadbandFilter.h"
+#include <cmath>
+
+DeadbandFilter::DeadbandFilter(const PollingConfig &config)
+    : config_(config), passed_(0), suppressed_(0) {}
+
+bool DeadbandFilter::apply(Sample &sample)
+{
+    uint64_t passed = 0;
+    uint64_t suppressed = 0;
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+    {
+        ParameterType param = static_cast<ParameterType>(i);
+        ParameterMask bit = parameterBit(param);
+        if (!(sample.present & bit))
+            continue;
+
+        const Deadband &deadband = config_.getParameterDeadband(param);
+        float value = sample.values[i];
+        if (deadband.enabled() && (hasReported_ & bit))
+        {
+            float delta = std::fabs(value - reported_[i]);
+            float limit = deadband.mode == DeadbandMode::PERCENT ? std::fabs(reported_[i]) * deadband.threshold / 100.0f
+                                                                 : deadband.threshold;
+            bool changed = delta > 0.0f && delta >= limit;
+            bool silent = deadband.heartbeat.count() > 0 &&
+                          sample.timestamp - reportedAt_[i] >= deadband.heartbeat.count();
+            if (!changed && !silent)
+            {
+                sample.present &= static_cast<ParameterMask>(~bit);
+                sample.values[i] = 0.0f;
+                suppressed++;
+                continue;
+            }
+        }
+
+        reported_[i] = value;
+        reportedAt_[i] = sample.timestamp;
+        hasReported_ |= bit;
+        passed++;
+    }
+
+    passed_ += passed;
+    suppressed_ += suppressed;
+    return sample.present != 0;
+}
+
+void DeadbandFilter::reset()
+{
+    hasReported_ = 0;
+}
@@ -0,0 +1,44 @@
+#ifndef DEADBAND_FILTER_H
+#define DEADBAND_FILTER_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "PollingConfig.h"
+
+// Report-by-exception stage between a device's poller and its buffer.
+//
+// A polled value of a parameter with a deadband is kept only if it differs
+// from the last value kept by at least the deadband, or if nothing was kept
+// for the parameter's heartbeat period; otherwise it is cleared from the
+// sample. Comparing against the last kept value (not the last polled one)
+// means a slow drift is still reported once it adds up. Parameters without a
+// deadband pass through untouched.
+//
+// One filter per device, used by one poll at a time.
+class DeadbandFilter
+{
+public:
+    explicit DeadbandFilter(const PollingConfig &config);
+
+    // Clears suppressed values from sample (timestamp in ms, monotonic).
+    // False when no value is left, i.e. there is nothing to store.
+    bool apply(Sample &sample);
+
+    // The next value of every parameter is reported
+    void reset();
+
+    uint64_t passedCount() const { return passed_; }         // Values kept
+    uint64_t suppressedCount() const { return suppressed_; } // Values inside their deadband
+
+private:
+    const PollingConfig &config_;
+    std::array<float, PARAMETER_COUNT> reported_{};        // Last value kept
+    std::array<long long, PARAMETER_COUNT> reportedAt_{}; // Its sample timestamp
+    ParameterMask hasReported_ = 0;
+
+    std::atomic<uint64_t> passed_;
+    std::atomic<uint64_t> suppressed_;
+};
+
+#endif
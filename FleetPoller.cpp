@@ -0,0 +1,190 @@
+#include "FleetPoller.h"
+#include "Metrics.h"
+#include <cstdio>
+#include <iostream>
+
+DeviceContext::DeviceContext(uint8_t slave, const Endpoint &endpoint, const PollingConfig &config,
+                             std::chrono::milliseconds pollInterval, uint16_t maxRegisterGap,
+                             size_t bufferCapacity, OverflowPolicy overflowPolicy)
+    : slaveAddress(slave),
+      inverter(slave, endpoint),
+      planner(config, maxRegisterGap),
+      scheduler(config, pollInterval),
+      filter(config),
+      buffer(bufferCapacity, overflowPolicy),
+      busy(false),
+      polls(0),
+      failures(0),
+      skipped(0) {}
+
+void DeviceContext::reportBufferState() const
+{
+    if (aggregator)
+        Metrics::getInstance().setBufferState(slaveAddress, aggregator->size(), aggregator->capacity(),
+                                              aggregator->droppedCount());
+    else if (store)
+        Metrics::getInstance().setBufferState(slaveAddress, store->size(), store->capacity(),
+                                              store->droppedCount());
+    else
+        Metrics::getInstance().setBufferState(slaveAddress, buffer.size(), buffer.capacity(),
+                                              buffer.droppedCount());
+}
+
+FleetPoller::FleetPoller(const PollingConfig &config, std::chrono::milliseconds pollInterval,
+                         size_t workerThreads, size_t bufferCapacity,
+                         OverflowPolicy overflowPolicy, uint16_t maxRegisterGap)
+    : config_(config),
+      pollInterval_(pollInterval),
+      bufferCapacity_(bufferCapacity),
+      overflowPolicy_(overflowPolicy),
+      maxRegisterGap_(maxRegisterGap),
+      workers_(workerThreads) {}
+
+FleetPoller::~FleetPoller()
+{
+    stop();
+}
+
+void FleetPoller::setStore(const std::string &directory, size_t recordsPerSegment, size_t maxSegments)
+{
+    storeDirectory_ = directory;
+    storeRecordsPerSegment_ = recordsPerSegment;
+    storeMaxSegments_ = maxSegments;
+}
+
+void FleetPoller::setAggregation(std::chrono::milliseconds window)
+{
+    aggregationWindow_ = window;
+}
+
+void FleetPoller::addDevice(uint8_t slaveAddress, const Endpoint &endpoint)
+{
+    devices_.emplace_back(new DeviceContext(slaveAddress, endpoint, config_, pollInterval_,
+                                            maxRegisterGap_, bufferCapacity_, overflowPolicy_));
+    DeviceContext &device = *devices_.back();
+    // Windows are small and few, they are kept in memory only
+    if (aggregationWindow_.count() > 0)
+    {
+        device.aggregator.reset(new WindowAggregator(aggregationWindow_, bufferCapacity_));
+        return;
+    }
+    if (storeDirectory_.empty())
+        return;
+
+    char name[16];
+    std::snprintf(name, sizeof(name), "slave_0x%02x", slaveAddress);
+    device.store.reset(new SampleStore(storeDirectory_ + "/" + name, storeRecordsPerSegment_, storeMaxSegments_));
+    if (!device.store->open())
+    {
+        std::cerr << "Sample store unavailable for slave 0x" << std::hex << static_cast<int>(slaveAddress)
+                  << std::dec << ", buffering in memory\n";
+        device.store.reset();
+    }
+}
+
+void FleetPoller::start()
+{
+    dispatcher_ = std::thread(&FleetPoller::dispatchLoop, this);
+}
+
+void FleetPoller::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (dispatcher_.joinable())
+        dispatcher_.join();
+    workers_.shutdown();
+}
+
+size_t FleetPoller::deviceCount() const
+{
+    return devices_.size();
+}
+
+DeviceContext &FleetPoller::device(size_t index)
+{
+    return *devices_[index];
+}
+
+void FleetPoller::pollDevice(DeviceContext &device)
+{
+    PollScheduler::TimePoint deadline = device.scheduler.nextDeadline();
+    ParameterMask due = device.scheduler.takeDue();
+    // A device behind an open circuit breaker is skipped until its cooldown ends
+    if (due != 0 && !device.inverter.isAvailable())
+        device.skipped++;
+    else if (due != 0)
+    {
+        Metrics &metrics = Metrics::getInstance();
+        auto started = PollScheduler::Clock::now();
+        Sample sample;
+        // Absolute time: stored samples outlive this process and its scheduler
+        sample.timestamp = device.scheduler.epochMs(deadline);
+        bool ok = device.planner.execute(device.inverter, sample, due);
+        metrics.recordPoll(device.slaveAddress, ok, Metrics::elapsedUs(started));
+        if (ok && device.aggregator)
+        {
+            // Aggregation sees every value, deadbands only thin out raw samples
+            device.aggregator->add(sample);
+        }
+        else if (ok)
+        {
+            // A poll whose values all stayed inside their deadbands stores nothing;
+            // the in-memory buffer still takes the sample if the store cannot
+            if (device.filter.apply(sample) && (!device.store || !device.store->append(sample)))
+                device.buffer.append(std::move(sample));
+        }
+        else
+        {
+            std::cerr << "Poll failed for some parameters on slave 0x" << std::hex
+                      << static_cast<int>(device.slaveAddress) << std::dec << "\n";
+            device.failures++;
+        }
+        device.polls++;
+        device.reportBufferState();
+    }
+    device.scheduler.complete(PollScheduler::Clock::now());
+
+    // Hand the device back to the dispatcher
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        device.busy.store(false, std::memory_order_release);
+    }
+    wake_.notify_one();
+}
+
+void FleetPoller::dispatchLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_)
+    {
+        auto now = PollScheduler::Clock::now();
+        auto earliest = PollScheduler::TimePoint::max();
+
+        for (auto &devicePtr : devices_)
+        {
+            DeviceContext &device = *devicePtr;
+            if (device.busy.load(std::memory_order_acquire))
+                continue;
+            auto deadline = device.scheduler.nextDeadline();
+            if (deadline <= now)
+            {
+                device.busy.store(true, std::memory_order_release);
+                DeviceContext *target = &device;
+                workers_.submit([this, target]()
+                                { pollDevice(*target); });
+            }
+            else if (deadline < earliest)
+                earliest = deadline;
+        }
+
+        // Sleep until the next deadline or until a busy device is released
+        if (earliest == PollScheduler::TimePoint::max())
+            wake_.wait(lock);
+        else
+            wake_.wait_until(lock, earliest);
+    }
+}
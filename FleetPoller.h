@@ -0,0 +1,105 @@
+#ifndef FLEET_POLLER_H
+#define FLEET_POLLER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "DataBuffer.h"
+#include "DeadbandFilter.h"
+#include "Inverter.h"
+#include "PollPlanner.h"
+#include "PollScheduler.h"
+#include "PollingConfig.h"
+#include "SampleStore.h"
+#include "WindowAggregator.h"
+#include "WorkerPool.h"
+
+// Everything the fleet keeps per inverter
+struct DeviceContext
+{
+    DeviceContext(uint8_t slave, const Endpoint &endpoint, const PollingConfig &config,
+                  std::chrono::milliseconds pollInterval, uint16_t maxRegisterGap,
+                  size_t bufferCapacity, OverflowPolicy overflowPolicy);
+
+    uint8_t slaveAddress;
+    Inverter inverter;
+    PollPlanner planner;
+    PollScheduler scheduler;
+    DeadbandFilter filter; // Drops values inside their deadband before they are buffered
+    DataBuffer buffer; // One poll in flight per device, so a single producer at a time
+    std::unique_ptr<SampleStore> store; // Replaces the buffer when persistence is enabled
+    std::unique_ptr<WindowAggregator> aggregator; // Replaces both with window statistics when enabled
+
+    std::atomic<bool> busy;          // A poll task is queued or running
+    std::atomic<uint64_t> polls;     // Completed poll ticks
+    std::atomic<uint64_t> failures;  // Ticks with at least one failed read
+    std::atomic<uint64_t> skipped;   // Ticks skipped while the circuit breaker was open
+
+    // Publish occupancy and drops of whichever of buffer/store holds the samples
+    void reportBufferState() const;
+};
+
+// Polls many inverters concurrently with a fixed worker pool.
+//
+// A dispatcher thread sleeps until the earliest device deadline and queues
+// one poll task per due device; a device is never polled twice at once, so
+// a slow inverter only delays itself.
+class FleetPoller
+{
+public:
+    FleetPoller(const PollingConfig &config, std::chrono::milliseconds pollInterval,
+                size_t workerThreads, size_t bufferCapacity,
+                OverflowPolicy overflowPolicy = OverflowPolicy::DROP_NEWEST,
+                uint16_t maxRegisterGap = 0);
+    ~FleetPoller();
+
+    FleetPoller(const FleetPoller &) = delete;
+    FleetPoller &operator=(const FleetPoller &) = delete;
+
+    // Keep samples in a SampleStore under <directory>/slave_0x<addr> instead of
+    // the in-memory buffer; applies to devices added afterwards
+    void setStore(const std::string &directory, size_t recordsPerSegment, size_t maxSegments);
+
+    // Aggregate each device's samples into windows of this length instead of
+    // buffering them; applies to devices added afterwards
+    void setAggregation(std::chrono::milliseconds window);
+
+    // Devices must be added before start()
+    void addDevice(uint8_t slaveAddress, const Endpoint &endpoint);
+
+    void start();
+    void stop();
+
+    size_t deviceCount() const;
+    DeviceContext &device(size_t index);
+
+private:
+    void dispatchLoop();
+    void pollDevice(DeviceContext &device);
+
+    const PollingConfig &config_;
+    std::chrono::milliseconds pollInterval_;
+    size_t bufferCapacity_;
+    OverflowPolicy overflowPolicy_;
+    uint16_t maxRegisterGap_;
+    std::string storeDirectory_;
+    size_t storeRecordsPerSegment_ = 0;
+    size_t storeMaxSegments_ = 0;
+    std::chrono::milliseconds aggregationWindow_{0};
+
+    std::vector<std::unique_ptr<DeviceContext>> devices_;
+    WorkerPool workers_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread dispatcher_;
+};
+
+#endif
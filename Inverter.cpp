@@ -1,136 +1,322 @@
 #include "Inverter.h"
+#include "Config.h"
+#include "RegisterCodec.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 
-Inverter::Inverter() : modbusHandler_() {}
+// ModbusHandler is constructed first and loads config.ini if needed
+Inverter::Inverter() : modbusHandler_(), slaveAddress_(Config::getInstance().getDefaultSlaveAddress())
+{
+    resolveRegisters(RegisterMap::getInstance());
+}
 
-// Individual register read operations
-bool Inverter::getACVoltage(float &voltage)
+Inverter::Inverter(uint8_t slaveAddress) : modbusHandler_(), slaveAddress_(slaveAddress)
 {
-    std::vector<uint16_t> values;
-    if (!modbusHandler_.readRegisters(REG_AC_VOLTAGE, 1, values, SLAVE_ADDRESS))
-        return false;
-    voltage = values[0] / GAIN_10;
-    return true;
+    resolveRegisters(RegisterMap::getInstance());
 }
 
-bool Inverter::getACCurrent(float &current)
+Inverter::Inverter(uint8_t slaveAddress, const Endpoint &endpoint)
+    : modbusHandler_(endpoint), slaveAddress_(slaveAddress)
 {
-    std::vector<uint16_t> values;
-    if (!modbusHandler_.readRegisters(REG_AC_CURRENT, 1, values, SLAVE_ADDRESS))
-        return false;
-    current = values[0] / GAIN_10;
-    return true;
+    resolveRegisters(RegisterMap::getInstance());
 }
 
-bool Inverter::getACFrequency(float &frequency)
+Inverter::Inverter(uint8_t slaveAddress, const Endpoint &endpoint, const RegisterMap &registerMap)
+    : modbusHandler_(endpoint), slaveAddress_(slaveAddress)
 {
-    std::vector<uint16_t> values;
-    if (!modbusHandler_.readRegisters(REG_AC_FREQUENCY, 1, values, SLAVE_ADDRESS))
-        return false;
-    frequency = values[0] / GAIN_100;
-    return true;
+    resolveRegisters(registerMap);
 }
 
-bool Inverter::getPV1Voltage(float &voltage)
+void Inverter::resolveRegisters(const RegisterMap &registerMap)
 {
-    std::vector<uint16_t> values;
-    if (!modbusHandler_.readRegisters(REG_PV1_VOLTAGE, 1, values, SLAVE_ADDRESS))
-        return false;
-    voltage = values[0] / GAIN_10;
-    return true;
+    std::vector<ParameterType> readable;
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+    {
+        registers_[i] = registerMap.find(parameterName(static_cast<ParameterType>(i)));
+        scales_[i] = registers_[i] ? 1.0f / registers_[i]->gain : 1.0f;
+        if (registers_[i] && registers_[i]->readable())
+            readable.push_back(static_cast<ParameterType>(i));
+    }
+    if (!readable.empty() && spanOf(readable.data(), readable.size(), blockStart_, blockRegs_) &&
+        blockRegs_ > MODBUS_MAX_READ_REGISTERS)
+        blockRegs_ = 0;
+    cacheHits_ = 0;
+    cacheMisses_ = 0;
+    writtenIn_.fill(0);
+    writeGeneration_ = 0;
+}
+
+// ========== Mapped parameters ==========
+bool Inverter::spanOf(const ParameterType *params, size_t count, uint16_t &start, uint16_t &numRegs) const
+{
+    uint32_t first = 0xFFFF, end = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const RegisterDescriptor *reg = registers_[parameterIndex(params[i])];
+        if (!reg || !reg->readable())
+        {
+            std::cerr << "Error: " << parameterName(params[i]) << " is not readable in the register map" << std::endl;
+            return false;
+        }
+        first = std::min<uint32_t>(first, reg->address);
+        end = std::max<uint32_t>(end, static_cast<uint32_t>(reg->address) + reg->width());
+    }
+    start = static_cast<uint16_t>(first);
+    numRegs = static_cast<uint16_t>(std::min<uint32_t>(end - first, 0xFFFF));
+    return count > 0;
+}
+
+ParameterMask Inverter::decodeBlock(uint16_t start, const std::vector<uint16_t> &regs, Sample &decoded) const
+{
+    ParameterMask mask = 0;
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+    {
+        const RegisterDescriptor *reg = registers_[i];
+        if (!reg || !reg->readable() || reg->address < start ||
+            static_cast<size_t>(reg->address - start) + reg->width() > regs.size())
+            continue;
+        decodeRun(reg->format, &regs[reg->address - start], &scales_[i], 1, &decoded.values[i]);
+        mask |= parameterBit(static_cast<ParameterType>(i));
+    }
+    decoded.present |= mask;
+    return mask;
 }
 
-bool Inverter::getPV2Voltage(float &voltage)
+bool Inverter::readBlock(uint16_t start, uint16_t numRegs, Sample &decoded)
 {
-    std::vector<uint16_t> values;
-    if (!modbusHandler_.readRegisters(REG_PV2_VOLTAGE, 1, values, SLAVE_ADDRESS))
+    uint64_t generation = writeGeneration_;
+    std::vector<uint16_t> regs;
+    if (!modbusHandler_.readRegisters(start, numRegs, regs, slaveAddress_) || regs.size() < numRegs)
         return false;
-    voltage = values[0] / GAIN_10;
+    cacheValues(decoded, decodeBlock(start, regs, decoded), generation);
     return true;
 }
 
-bool Inverter::getPV1Current(float &current)
+bool Inverter::readCached(const ParameterType *params, float *values, size_t count, MaxAge maxAge)
 {
-    std::vector<uint16_t> values;
-    if (!modbusHandler_.readRegisters(REG_PV1_CURRENT, 1, values, SLAVE_ADDRESS))
-        return false;
-    current = values[0] / GAIN_10;
+    Clock::time_point oldest = Clock::now() - maxAge;
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!cache_.hasValue(params[i]) || cachedAt_[parameterIndex(params[i])] < oldest)
+            return false;
+    }
+    for (size_t i = 0; i < count; ++i)
+        values[i] = cache_.getValue(params[i]);
     return true;
 }
 
-bool Inverter::getPV2Current(float &current)
+void Inverter::cacheValues(const Sample &sample, ParameterMask params, uint64_t readGeneration)
 {
-    std::vector<uint16_t> values;
-    if (!modbusHandler_.readRegisters(REG_PV2_CURRENT, 1, values, SLAVE_ADDRESS))
+    Clock::time_point now = Clock::now();
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+    {
+        if ((params & (1u << i)) && writtenIn_[i] <= readGeneration)
+        {
+            cache_.setValue(static_cast<ParameterType>(i), sample.values[i]);
+            cachedAt_[i] = now;
+        }
+    }
+}
+
+void Inverter::invalidateCache()
+{
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    cache_.present = 0;
+}
+
+// After a write the device may have clamped or rejected the value, so it is
+// read back on the next access instead of cached. Reads still in flight
+// started under an older generation and are not cached for these registers.
+void Inverter::invalidateRegisters(uint16_t start, size_t numRegs)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex_);
+    uint64_t generation = ++writeGeneration_;
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+    {
+        const RegisterDescriptor *reg = registers_[i];
+        if (reg && reg->address < start + numRegs && static_cast<size_t>(reg->address) + reg->width() > start)
+        {
+            cache_.present &= static_cast<ParameterMask>(~(1u << i));
+            writtenIn_[i] = generation;
+        }
+    }
+}
+
+bool Inverter::readParameter(ParameterType param, float &value, MaxAge maxAge)
+{
+    return readParameters(&param, &value, 1, maxAge);
+}
+
+bool Inverter::readParameters(const ParameterType *params, float *values, size_t count, MaxAge maxAge)
+{
+    if (maxAge.count() > 0)
+    {
+        if (readCached(params, values, count, maxAge))
+        {
+            cacheHits_++;
+            return true;
+        }
+        cacheMisses_++;
+    }
+
+    uint16_t start, numRegs;
+    if (!spanOf(params, count, start, numRegs))
         return false;
-    current = values[0] / GAIN_10;
+    // A miss refreshes every parameter of the map in the same round trip
+    if (maxAge.count() > 0 && blockRegs_ > 0)
+    {
+        start = blockStart_;
+        numRegs = blockRegs_;
+    }
+
+    Sample decoded;
+    if (numRegs <= MODBUS_MAX_READ_REGISTERS)
+    {
+        if (!readBlock(start, numRegs, decoded))
+            return false;
+    }
+    else
+    {
+        // Registers too far apart for one read
+        for (size_t i = 0; i < count; ++i)
+        {
+            const RegisterDescriptor *reg = registers_[parameterIndex(params[i])];
+            if (!readBlock(reg->address, reg->width(), decoded))
+                return false;
+        }
+    }
+    for (size_t i = 0; i < count; ++i)
+        values[i] = decoded.getValue(params[i]);
     return true;
 }
 
-bool Inverter::getTemperature(float &temperature)
+bool Inverter::writeParameter(ParameterType param, float value)
 {
-    std::vector<uint16_t> values;
-    if (!modbusHandler_.readRegisters(REG_TEMPERATURE, 1, values, SLAVE_ADDRESS))
+    const RegisterDescriptor *reg = registers_[parameterIndex(param)];
+    if (!reg || !reg->writable())
+    {
+        std::cerr << "Error: " << parameterName(param) << " is not writable in the register map" << std::endl;
         return false;
-    temperature = values[0] / GAIN_10;
-    return true;
+    }
+
+    uint16_t words[2];
+    if (!RegisterMap::encodeRaw(reg->format, std::llround(value * reg->gain), words))
+    {
+        std::cerr << "Error: " << value << " is out of range for " << reg->name << std::endl;
+        return false;
+    }
+    bool ok = reg->width() == 1 ? modbusHandler_.writeRegister(reg->address, words[0], slaveAddress_)
+                                : modbusHandler_.writeRegisters(reg->address, std::vector<uint16_t>(words, words + 2),
+                                                                slaveAddress_);
+    invalidateRegisters(reg->address, reg->width());
+    return ok;
+}
+
+// Individual register read operations
+bool Inverter::getACVoltage(float &voltage, MaxAge maxAge)
+{
+    return readParameter(ParameterType::AC_VOLTAGE, voltage, maxAge);
+}
+
+bool Inverter::getACCurrent(float &current, MaxAge maxAge)
+{
+    return readParameter(ParameterType::AC_CURRENT, current, maxAge);
+}
+
+bool Inverter::getACFrequency(float &frequency, MaxAge maxAge)
+{
+    return readParameter(ParameterType::AC_FREQUENCY, frequency, maxAge);
+}
+
+bool Inverter::getPV1Voltage(float &voltage, MaxAge maxAge)
+{
+    return readParameter(ParameterType::PV1_VOLTAGE, voltage, maxAge);
+}
+
+bool Inverter::getPV2Voltage(float &voltage, MaxAge maxAge)
+{
+    return readParameter(ParameterType::PV2_VOLTAGE, voltage, maxAge);
+}
+
+bool Inverter::getPV1Current(float &current, MaxAge maxAge)
+{
+    return readParameter(ParameterType::PV1_CURRENT, current, maxAge);
+}
+
+bool Inverter::getPV2Current(float &current, MaxAge maxAge)
+{
+    return readParameter(ParameterType::PV2_CURRENT, current, maxAge);
+}
+
+bool Inverter::getTemperature(float &temperature, MaxAge maxAge)
+{
+    return readParameter(ParameterType::TEMPERATURE, temperature, maxAge);
 }
 
-bool Inverter::getExportPowerPercent(int &exportPercent)
+bool Inverter::getExportPowerPercent(int &exportPercent, MaxAge maxAge)
 {
-    std::vector<uint16_t> values;
-    if (!modbusHandler_.readRegisters(REG_EXPORT_POWER_PERCENT, 1, values, SLAVE_ADDRESS))
+    float value;
+    if (!readParameter(ParameterType::EXPORT_POWER_PERCENT, value, maxAge))
         return false;
-    exportPercent = static_cast<int>(values[0] / GAIN_1);
+    exportPercent = static_cast<int>(value);
     return true;
 }
 
-bool Inverter::getOutputPower(int &power)
+bool Inverter::getOutputPower(int &power, MaxAge maxAge)
 {
-    std::vector<uint16_t> values;
-    if (!modbusHandler_.readRegisters(REG_OUTPUT_POWER, 1, values, SLAVE_ADDRESS))
+    float value;
+    if (!readParameter(ParameterType::OUTPUT_POWER, value, maxAge))
         return false;
-    power = static_cast<int>(values[0] / GAIN_1);
+    power = static_cast<int>(value);
     return true;
 }
 
 // Combined read operations for efficiency
-bool Inverter::getACMeasurements(float &voltage, float &current, float &frequency)
+bool Inverter::getACMeasurements(float &voltage, float &current, float &frequency, MaxAge maxAge)
 {
-    std::vector<uint16_t> values;
-    if (!modbusHandler_.readRegisters(REG_AC_VOLTAGE, 3, values, SLAVE_ADDRESS))
+    const ParameterType params[] = {ParameterType::AC_VOLTAGE, ParameterType::AC_CURRENT, ParameterType::AC_FREQUENCY};
+    float values[3];
+    if (!readParameters(params, values, 3, maxAge))
         return false;
-    voltage = values[0] / GAIN_10;
-    current = values[1] / GAIN_10;
-    frequency = values[2] / GAIN_100;
+    voltage = values[0];
+    current = values[1];
+    frequency = values[2];
     return true;
 }
 
-bool Inverter::getPVMeasurements(float &pv1Voltage, float &pv2Voltage, float &pv1Current, float &pv2Current)
+bool Inverter::getPVMeasurements(float &pv1Voltage, float &pv2Voltage, float &pv1Current, float &pv2Current,
+                                 MaxAge maxAge)
 {
-    std::vector<uint16_t> values;
-    if (!modbusHandler_.readRegisters(REG_PV1_VOLTAGE, 4, values, SLAVE_ADDRESS))
+    const ParameterType params[] = {ParameterType::PV1_VOLTAGE, ParameterType::PV2_VOLTAGE,
+                                    ParameterType::PV1_CURRENT, ParameterType::PV2_CURRENT};
+    float values[4];
+    if (!readParameters(params, values, 4, maxAge))
         return false;
-    pv1Voltage = values[0] / GAIN_10;
-    pv2Voltage = values[1] / GAIN_10;
-    pv1Current = values[2] / GAIN_10;
-    pv2Current = values[3] / GAIN_10;
+    pv1Voltage = values[0];
+    pv2Voltage = values[1];
+    pv1Current = values[2];
+    pv2Current = values[3];
     return true;
 }
 
-bool Inverter::getSystemStatus(float &temperature, int &exportPercent, int &outputPower)
+bool Inverter::getSystemStatus(float &temperature, int &exportPercent, int &outputPower, MaxAge maxAge)
 {
-    std::vector<uint16_t> values;
-    if (!modbusHandler_.readRegisters(REG_TEMPERATURE, 3, values, SLAVE_ADDRESS))
+    const ParameterType params[] = {ParameterType::TEMPERATURE, ParameterType::EXPORT_POWER_PERCENT,
+                                    ParameterType::OUTPUT_POWER};
+    float values[3];
+    if (!readParameters(params, values, 3, maxAge))
         return false;
-    temperature = values[0] / GAIN_10;
-    exportPercent = static_cast<int>(values[1] / GAIN_1);
-    outputPower = static_cast<int>(values[2] / GAIN_1);
+    temperature = values[0];
+    exportPercent = static_cast<int>(values[1]);
+    outputPower = static_cast<int>(values[2]);
     return true;
 }
 
 // Write operations
-bool Inverter::setExportPowerPercent(int value)
+int Inverter::clampExportPercent(int value)
 {
     // Clamp the value to valid range (0-100)
     int clampedValue = value;
@@ -145,11 +331,68 @@ bool Inverter::setExportPowerPercent(int value)
         std::cerr << "Warning: Export power percentage " << value
                   << " is out of range. Clamped to " << clampedValue << std::endl;
     }
+    return clampedValue;
+}
+
+bool Inverter::setExportPowerPercent(int value)
+{
+    return writeParameter(ParameterType::EXPORT_POWER_PERCENT, static_cast<float>(clampExportPercent(value)));
+}
 
-    return modbusHandler_.writeRegister(REG_EXPORT_POWER_PERCENT, static_cast<uint16_t>(clampedValue * GAIN_1), SLAVE_ADDRESS);
+bool Inverter::setRegisters(uint16_t startReg, const std::vector<uint16_t> &values)
+{
+    bool ok = modbusHandler_.writeRegisters(startReg, values, slaveAddress_);
+    invalidateRegisters(startReg, values.size());
+    return ok;
+}
+
+bool Inverter::setExportPowerPercentAndGetStatus(int value, float &temperature, int &exportPercent, int &outputPower)
+{
+    const ParameterType params[] = {ParameterType::TEMPERATURE, ParameterType::EXPORT_POWER_PERCENT,
+                                    ParameterType::OUTPUT_POWER};
+    const RegisterDescriptor *reg = registers_[parameterIndex(ParameterType::EXPORT_POWER_PERCENT)];
+    uint16_t start, numRegs;
+    if (!reg || !reg->writable() || !spanOf(params, 3, start, numRegs))
+    {
+        std::cerr << "Error: Register map does not allow a combined export power write and status read" << std::endl;
+        return false;
+    }
+
+    uint16_t words[2];
+    if (numRegs > MODBUS_MAX_READ_WRITE_REGISTERS ||
+        !RegisterMap::encodeRaw(reg->format, std::llround(clampExportPercent(value) * reg->gain), words))
+    {
+        // Status registers too far apart for FC23: write, then read back
+        return setExportPowerPercent(value) && getSystemStatus(temperature, exportPercent, outputPower);
+    }
+
+    // The device applies the write before the read, so the values read back are current
+    std::vector<uint16_t> regs;
+    bool ok = modbusHandler_.readWriteRegisters(start, numRegs, regs, reg->address,
+                                                std::vector<uint16_t>(words, words + reg->width()), slaveAddress_) &&
+              regs.size() >= numRegs;
+    invalidateRegisters(reg->address, reg->width());
+    if (!ok)
+        return false;
+    Sample decoded;
+    cacheValues(decoded, decodeBlock(start, regs, decoded), writeGeneration_);
+    temperature = decoded.getValue(ParameterType::TEMPERATURE);
+    exportPercent = static_cast<int>(decoded.getValue(ParameterType::EXPORT_POWER_PERCENT));
+    outputPower = static_cast<int>(decoded.getValue(ParameterType::OUTPUT_POWER));
+    return true;
 }
 
 ModbusHandler &Inverter::getModbusHandler()
 {
     return modbusHandler_;
 }
+
+uint8_t Inverter::getSlaveAddress() const
+{
+    return slaveAddress_;
+}
+
+bool Inverter::isAvailable() const
+{
+    return !modbusHandler_.isCircuitOpen(slaveAddress_);
+}
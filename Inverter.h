@@ -2,56 +2,111 @@
 #define INVERTER_H
 
 #include "ModbusHandler.h"
+#include "PollingConfig.h"
+#include "RegisterMap.h"
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <vector>
 
+// Every read also refreshes a per-parameter register cache. Callers that can
+// live with slightly old data pass maxAge: values at most that old are served
+// from memory, and a miss refreshes the whole register block of the map in
+// one read, so the next queries for any parameter hit. A zero maxAge (the
+// default) always reads the device.
 class Inverter
 {
 public:
+    // Slave address from [DEVICE] default_slave_address, endpoints from config.ini
     Inverter();
+    explicit Inverter(uint8_t slaveAddress);
+    Inverter(uint8_t slaveAddress, const Endpoint &endpoint);
+    // Register layout of another model; registerMap must outlive the inverter
+    Inverter(uint8_t slaveAddress, const Endpoint &endpoint, const RegisterMap &registerMap);
 
-    // Individual register read operations
-    bool getACVoltage(float &voltage);              // Register 0: Vac1/L1 Phase voltage
-    bool getACCurrent(float &current);              // Register 1: Iac1/L1 Phase current
-    bool getACFrequency(float &frequency);          // Register 2: Fac1/L1 Phase frequency
-    bool getPV1Voltage(float &voltage);             // Register 3: Vpv1/PV1 input voltage
-    bool getPV2Voltage(float &voltage);             // Register 4: Vpv2/PV2 input voltage
-    bool getPV1Current(float &current);             // Register 5: Ipv1/PV1 input current
-    bool getPV2Current(float &current);             // Register 6: Ipv2/PV2 input current
-    bool getTemperature(float &temperature);        // Register 7: Inverter internal temperature
-    bool getExportPowerPercent(int &exportPercent); // Register 8: Export power percentage
-    bool getOutputPower(int &power);                // Register 9: Inverter current output power
+    typedef std::chrono::milliseconds MaxAge;
+
+    // Individual register read operations (registers of the built-in layout)
+    bool getACVoltage(float &voltage, MaxAge maxAge = MaxAge(0));              // Register 0: Vac1/L1 Phase voltage
+    bool getACCurrent(float &current, MaxAge maxAge = MaxAge(0));              // Register 1: Iac1/L1 Phase current
+    bool getACFrequency(float &frequency, MaxAge maxAge = MaxAge(0));          // Register 2: Fac1/L1 Phase frequency
+    bool getPV1Voltage(float &voltage, MaxAge maxAge = MaxAge(0));             // Register 3: Vpv1/PV1 input voltage
+    bool getPV2Voltage(float &voltage, MaxAge maxAge = MaxAge(0));             // Register 4: Vpv2/PV2 input voltage
+    bool getPV1Current(float &current, MaxAge maxAge = MaxAge(0));             // Register 5: Ipv1/PV1 input current
+    bool getPV2Current(float &current, MaxAge maxAge = MaxAge(0));             // Register 6: Ipv2/PV2 input current
+    bool getTemperature(float &temperature, MaxAge maxAge = MaxAge(0));        // Register 7: Inverter internal temperature
+    bool getExportPowerPercent(int &exportPercent, MaxAge maxAge = MaxAge(0)); // Register 8: Export power percentage
+    bool getOutputPower(int &power, MaxAge maxAge = MaxAge(0));                // Register 9: Inverter current output power
 
     // Combined read operations for efficiency
-    bool getACMeasurements(float &voltage, float &current, float &frequency);
-    bool getPVMeasurements(float &pv1Voltage, float &pv2Voltage, float &pv1Current, float &pv2Current);
-    bool getSystemStatus(float &temperature, int &exportPercent, int &outputPower);
+    bool getACMeasurements(float &voltage, float &current, float &frequency, MaxAge maxAge = MaxAge(0));
+    bool getPVMeasurements(float &pv1Voltage, float &pv2Voltage, float &pv1Current, float &pv2Current,
+                           MaxAge maxAge = MaxAge(0));
+    bool getSystemStatus(float &temperature, int &exportPercent, int &outputPower, MaxAge maxAge = MaxAge(0));
+
+    // Any mapped parameter, scaled by its gain. Several parameters are read in
+    // one transaction when they fit into a single block.
+    bool readParameter(ParameterType param, float &value, MaxAge maxAge = MaxAge(0));
+    bool readParameters(const ParameterType *params, float *values, size_t count, MaxAge maxAge = MaxAge(0));
+    bool writeParameter(ParameterType param, float value);
+
+    // Taken before issuing a read whose values are passed to cacheValues
+    uint64_t writeGeneration() const { return writeGeneration_; }
+    // Store freshly decoded values (e.g. from a PollPlanner cycle) in the cache.
+    // Values of registers written after readGeneration was taken are dropped,
+    // since the read may have returned what the device held before the write.
+    void cacheValues(const Sample &sample, ParameterMask params, uint64_t readGeneration);
+    void invalidateCache();
+    uint64_t cacheHits() const { return cacheHits_; }
+    uint64_t cacheMisses() const { return cacheMisses_; } // maxAge reads that went to the device
 
     // Write operations
     bool setExportPowerPercent(int value); // Register 8: Set export power percentage
+    // Contiguous setpoints starting at startReg, applied together in one transaction (FC16)
+    bool setRegisters(uint16_t startReg, const std::vector<uint16_t> &values);
+    // Set the export power percentage and read back registers 7-9 in one round trip (FC23)
+    bool setExportPowerPercentAndGetStatus(int value, float &temperature, int &exportPercent, int &outputPower);
 
     // Direct access to Modbus operations if needed
     ModbusHandler &getModbusHandler();
+    uint8_t getSlaveAddress() const;
+    // False while the circuit breaker is rejecting requests to this device
+    bool isAvailable() const;
 
 private:
+    // Export power percentage limited to 0-100, with a warning when clamped
+    static int clampExportPercent(int value);
+
+    typedef std::chrono::steady_clock Clock;
+
+    // Registers covering all params (readable ones only) as one read block
+    bool spanOf(const ParameterType *params, size_t count, uint16_t &start, uint16_t &numRegs) const;
+    // Read a block, decode every readable mapped parameter inside it and cache them
+    bool readBlock(uint16_t start, uint16_t numRegs, Sample &decoded);
+    ParameterMask decodeBlock(uint16_t start, const std::vector<uint16_t> &regs, Sample &decoded) const;
+    bool readCached(const ParameterType *params, float *values, size_t count, MaxAge maxAge);
+    void invalidateRegisters(uint16_t start, size_t numRegs);
+
     ModbusHandler modbusHandler_;
+    uint8_t slaveAddress_;
+    // Descriptor of each ParameterType, null when the map lacks it
+    std::array<const RegisterDescriptor *, PARAMETER_COUNT> registers_;
+    std::array<float, PARAMETER_COUNT> scales_; // Reciprocal gains
+    // Span of all readable mapped parameters, refreshed on a cache miss; zero
+    // registers when it does not fit one read
+    uint16_t blockStart_ = 0;
+    uint16_t blockRegs_ = 0;
+
+    std::mutex cacheMutex_;
+    Sample cache_;                                           // present marks cached parameters
+    std::array<Clock::time_point, PARAMETER_COUNT> cachedAt_; // Completion time of the read
+    std::array<uint64_t, PARAMETER_COUNT> writtenIn_;         // Generation of the last write
+    std::atomic<uint64_t> writeGeneration_;
+    std::atomic<uint64_t> cacheHits_;
+    std::atomic<uint64_t> cacheMisses_;
 
-    // Device-specific constants - Register addresses
-    static const uint8_t SLAVE_ADDRESS = 0x11;
-    static const uint16_t REG_AC_VOLTAGE = 0;           // Vac1/L1 Phase voltage (gain: 10, unit: V)
-    static const uint16_t REG_AC_CURRENT = 1;           // Iac1/L1 Phase current (gain: 10, unit: A)
-    static const uint16_t REG_AC_FREQUENCY = 2;         // Fac1/L1 Phase frequency (gain: 100, unit: Hz)
-    static const uint16_t REG_PV1_VOLTAGE = 3;          // Vpv1/PV1 input voltage (gain: 10, unit: V)
-    static const uint16_t REG_PV2_VOLTAGE = 4;          // Vpv2/PV2 input voltage (gain: 10, unit: V)
-    static const uint16_t REG_PV1_CURRENT = 5;          // Ipv1/PV1 input current (gain: 10, unit: A)
-    static const uint16_t REG_PV2_CURRENT = 6;          // Ipv2/PV2 input current (gain: 10, unit: A)
-    static const uint16_t REG_TEMPERATURE = 7;          // Inverter internal temperature (gain: 10, unit: °C)
-    static const uint16_t REG_EXPORT_POWER_PERCENT = 8; // Export power percentage (gain: 1, unit: %)
-    static const uint16_t REG_OUTPUT_POWER = 9;         // Inverter current output power (gain: 1, unit: W)
-
-    // Gain constants for proper scaling
-    static constexpr float GAIN_10 = 10.0f;
-    static constexpr float GAIN_100 = 100.0f;
-    static constexpr float GAIN_1 = 1.0f;
+    void resolveRegisters(const RegisterMap &registerMap);
 };
 
 #endif
@@ -0,0 +1,772 @@
+#include "InverterSimServer.h"
+#include "ModbusCRC.h"
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+    // Power-on register values (raw, before gain)
+    const uint16_t DEFAULT_REGISTERS[InverterSimServer::REGISTER_COUNT] = {
+        2300, // 0 AC voltage      x10
+        52,   // 1 AC current      x10
+        5000, // 2 AC frequency    x100
+        3500, // 3 PV1 voltage     x10
+        3400, // 4 PV2 voltage     x10
+        80,   // 5 PV1 current     x10
+        75,   // 6 PV2 current     x10
+        425,  // 7 Temperature     x10
+        20,   // 8 Export power %  (writable)
+        1200  // 9 Output power W
+    };
+
+    bool sendAll(int fd, const char *data, size_t len)
+    {
+        while (len > 0)
+        {
+            ssize_t sent = ::send(fd, data, len, MSG_NOSIGNAL);
+            if (sent <= 0)
+                return false;
+            data += sent;
+            len -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    // Takes one from a pending fault count, false once it is used up
+    bool takeOne(std::atomic<unsigned> &pending)
+    {
+        unsigned count = pending.load();
+        while (count > 0 && !pending.compare_exchange_weak(count, count - 1))
+        {
+        }
+        return count > 0;
+    }
+
+    // Case-insensitive header lookup within the header block
+    std::string headerValue(const std::string &headers, const char *name)
+    {
+        std::string lower(headers);
+        std::transform(lower.begin(), lower.end(), lower.begin(),
+                       [](unsigned char c)
+                       { return static_cast<char>(std::tolower(c)); });
+        std::string needle = std::string("\r\n") + name + ":";
+        size_t pos = lower.find(needle);
+        if (pos == std::string::npos)
+            return "";
+        pos += needle.size();
+        size_t end = headers.find("\r\n", pos);
+        std::string value = headers.substr(pos, end - pos);
+        size_t start = value.find_first_not_of(" \t");
+        return start == std::string::npos ? "" : value.substr(start);
+    }
+}
+
+// ========== Lifecycle ==========
+InverterSimServer::InverterSimServer(const SimOptions &options)
+    : latencyUs_(options.latencyUs),
+      jitterUs_(options.jitterUs),
+      exceptionRate_(options.exceptionRate),
+      injectedException_(options.injectedException),
+      crcErrorRate_(options.crcErrorRate),
+      requests_(0),
+      connections_(0),
+      uploads_(0),
+      failUploads_(0),
+      rejectUploads_(0),
+      rejectStatus_(413),
+      running_(false)
+{
+    listeners_[0].protocol = TransportType::HTTP;
+    listeners_[0].port = options.port;
+    listeners_[1].protocol = TransportType::MODBUS_TCP;
+    listeners_[1].port = options.modbusTcpPort;
+    listeners_[2].protocol = TransportType::RTU_OVER_TCP;
+    listeners_[2].port = options.rtuOverTcpPort;
+    resetRegisters();
+    for (uint16_t i = 0; i < REGISTER_COUNT; ++i)
+        writable_[i] = i == WRITABLE_REGISTER;
+}
+
+InverterSimServer::~InverterSimServer()
+{
+    stop();
+}
+
+bool InverterSimServer::listen(Listener &listener)
+{
+    listener.fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listener.fd < 0)
+    {
+        std::cerr << "SIM: socket() failed: " << std::strerror(errno) << std::endl;
+        return false;
+    }
+    int reuse = 1;
+    ::setsockopt(listener.fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(listener.port);
+    if (::bind(listener.fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 ||
+        ::listen(listener.fd, 64) < 0)
+    {
+        std::cerr << "SIM: cannot listen on port " << listener.port << ": " << std::strerror(errno) << std::endl;
+        ::close(listener.fd);
+        listener.fd = -1;
+        return false;
+    }
+
+    // Report the port actually bound when an ephemeral one was requested
+    socklen_t len = sizeof(addr);
+    ::getsockname(listener.fd, reinterpret_cast<sockaddr *>(&addr), &len);
+    listener.port = ntohs(addr.sin_port);
+    return true;
+}
+
+bool InverterSimServer::start()
+{
+    for (Listener &listener : listeners_)
+    {
+        if (!listen(listener))
+        {
+            for (Listener &opened : listeners_)
+            {
+                if (opened.fd >= 0)
+                    ::close(opened.fd);
+                opened.fd = -1;
+            }
+            return false;
+        }
+    }
+
+    running_ = true;
+    for (Listener &listener : listeners_)
+        listener.thread = std::thread(&InverterSimServer::acceptLoop, this, &listener);
+    return true;
+}
+
+void InverterSimServer::stop()
+{
+    if (!running_.exchange(false))
+        return;
+
+    for (Listener &listener : listeners_)
+    {
+        ::shutdown(listener.fd, SHUT_RDWR);
+        if (listener.thread.joinable())
+            listener.thread.join();
+        ::close(listener.fd);
+        listener.fd = -1;
+    }
+
+    std::vector<std::thread> threads;
+    {
+        std::lock_guard<std::mutex> lock(clientsMutex_);
+        for (int fd : clientFds_)
+            ::shutdown(fd, SHUT_RDWR);
+        threads.swap(clientThreads_);
+    }
+    for (auto &t : threads)
+        t.join();
+}
+
+uint16_t InverterSimServer::port() const
+{
+    return listeners_[0].port;
+}
+
+uint16_t InverterSimServer::modbusTcpPort() const
+{
+    return listeners_[1].port;
+}
+
+uint16_t InverterSimServer::rtuOverTcpPort() const
+{
+    return listeners_[2].port;
+}
+
+Endpoint InverterSimServer::endpoint(TransportType transport) const
+{
+    Endpoint endpoint{"sim", readUrl(), writeUrl()};
+    endpoint.transport = transport;
+    endpoint.host = "127.0.0.1";
+    endpoint.port = transport == TransportType::RTU_OVER_TCP ? rtuOverTcpPort() : modbusTcpPort();
+    return endpoint;
+}
+
+std::string InverterSimServer::readUrl() const
+{
+    return "http://127.0.0.1:" + std::to_string(port()) + "/api/inverter/read";
+}
+
+std::string InverterSimServer::writeUrl() const
+{
+    return "http://127.0.0.1:" + std::to_string(port()) + "/api/inverter/write";
+}
+
+std::string InverterSimServer::uploadUrl() const
+{
+    return "http://127.0.0.1:" + std::to_string(port()) + "/api/upload";
+}
+
+// ========== Tuning ==========
+void InverterSimServer::setLatency(long latencyUs, long jitterUs)
+{
+    latencyUs_ = latencyUs;
+    jitterUs_ = jitterUs;
+}
+
+void InverterSimServer::setExceptionRate(double rate, uint8_t code)
+{
+    injectedException_ = code;
+    exceptionRate_ = rate;
+}
+
+void InverterSimServer::setCrcErrorRate(double rate)
+{
+    crcErrorRate_ = rate;
+}
+
+uint16_t InverterSimServer::getRegister(uint16_t addr) const
+{
+    return addr < REGISTER_COUNT ? registers_[addr].load() : 0;
+}
+
+void InverterSimServer::setRegister(uint16_t addr, uint16_t value)
+{
+    if (addr < REGISTER_COUNT)
+        registers_[addr] = value;
+}
+
+void InverterSimServer::resetRegisters()
+{
+    for (uint16_t i = 0; i < REGISTER_COUNT; ++i)
+        registers_[i] = DEFAULT_REGISTERS[i];
+}
+
+void InverterSimServer::setWritable(uint16_t addr, bool writable)
+{
+    if (addr < REGISTER_COUNT)
+        writable_[addr] = writable;
+}
+
+uint64_t InverterSimServer::requestCount() const
+{
+    return requests_.load();
+}
+
+uint64_t InverterSimServer::connectionCount() const
+{
+    return connections_.load();
+}
+
+// ========== Upload sink ==========
+uint64_t InverterSimServer::uploadCount() const
+{
+    return uploads_.load();
+}
+
+std::string InverterSimServer::lastUpload() const
+{
+    std::lock_guard<std::mutex> lock(uploadMutex_);
+    return lastUpload_;
+}
+
+void InverterSimServer::failNextUploads(unsigned count)
+{
+    failUploads_ = count;
+}
+
+void InverterSimServer::rejectNextUploads(unsigned count, int status)
+{
+    rejectStatus_ = status;
+    rejectUploads_ = count;
+}
+
+bool InverterSimServer::handleUpload(int fd, const std::string &body, bool keepAlive)
+{
+    const char *status = "200 OK";
+    if (takeOne(failUploads_))
+    {
+        status = "503 Service Unavailable";
+    }
+    else if (takeOne(rejectUploads_))
+    {
+        switch (rejectStatus_.load())
+        {
+        case 400:
+            status = "400 Bad Request";
+            break;
+        case 401:
+            status = "401 Unauthorized";
+            break;
+        case 403:
+            status = "403 Forbidden";
+            break;
+        case 404:
+            status = "404 Not Found";
+            break;
+        case 422:
+            status = "422 Unprocessable Entity";
+            break;
+        default:
+            status = "413 Payload Too Large";
+            break;
+        }
+    }
+    else
+    {
+        {
+            std::lock_guard<std::mutex> lock(uploadMutex_);
+            lastUpload_ = body;
+        }
+        uploads_++;
+    }
+
+    std::string head = std::string("HTTP/1.1 ") + status + "\r\nContent-Length: 0" +
+                       (keepAlive ? "\r\n\r\n" : "\r\nConnection: close\r\n\r\n");
+    return sendAll(fd, head.data(), head.size()) && keepAlive;
+}
+
+// ========== Modbus behaviour ==========
+void InverterSimServer::buildException(uint8_t slave, uint8_t function, uint8_t code, FrameBuffer &response)
+{
+    response.data[0] = slave;
+    response.data[1] = static_cast<uint8_t>(function | 0x80);
+    response.data[2] = code;
+    response.size = 3;
+    ModbusFrame::appendCRC(response);
+}
+
+void InverterSimServer::buildReadResponse(uint8_t slave, uint8_t function, uint16_t addr, uint16_t count,
+                                          FrameBuffer &response)
+{
+    response.data[0] = slave;
+    response.data[1] = function;
+    response.data[2] = static_cast<uint8_t>(count * 2);
+    for (uint16_t i = 0; i < count; ++i)
+    {
+        uint16_t reg = registers_[addr + i].load(std::memory_order_relaxed);
+        response.data[3 + 2 * i] = static_cast<uint8_t>(reg >> 8);
+        response.data[4 + 2 * i] = static_cast<uint8_t>(reg & 0xFF);
+    }
+    response.size = 3 + 2u * count;
+    ModbusFrame::appendCRC(response);
+}
+
+// Every register must exist and be writable, and the export percentage stay within 0-100
+uint8_t InverterSimServer::checkWrite(uint16_t addr, uint16_t count, const uint8_t *values) const
+{
+    if (static_cast<uint32_t>(addr) + count > REGISTER_COUNT)
+        return 0x02;
+    for (uint16_t i = 0; i < count; ++i)
+    {
+        uint16_t reg = static_cast<uint16_t>(addr + i);
+        uint16_t value = static_cast<uint16_t>((values[2 * i] << 8) | values[2 * i + 1]);
+        if (!writable_[reg].load(std::memory_order_relaxed))
+            return 0x02;
+        if (reg == WRITABLE_REGISTER && value > 100)
+            return 0x03;
+    }
+    return 0;
+}
+
+void InverterSimServer::applyWrite(uint16_t addr, uint16_t count, const uint8_t *values)
+{
+    for (uint16_t i = 0; i < count; ++i)
+        registers_[addr + i] = static_cast<uint16_t>((values[2 * i] << 8) | values[2 * i + 1]);
+}
+
+void InverterSimServer::handleFrame(const FrameBuffer &request, FrameBuffer &response)
+{
+    response.size = 0;
+
+    // A frame whose length does not match its function code, or with a bad CRC, is invalid
+    size_t expectedLength;
+    if (request.size < 4 || !ModbusFrame::rtuRequestLength(request.data, request.size, expectedLength) ||
+        expectedLength != request.size ||
+        ModbusCRC::compute(request.data, request.size - 2) != ModbusFrame::receivedCRC(request.data, request.size))
+    {
+        // Unknown functions still get an Illegal Function answer
+        if (request.size == 8 &&
+            ModbusCRC::compute(request.data, request.size - 2) == ModbusFrame::receivedCRC(request.data, request.size))
+            buildException(request.data[0], request.data[1], 0x01, response);
+        return;
+    }
+
+    uint8_t slave = request.data[0];
+    uint8_t function = request.data[1];
+    uint16_t addr = static_cast<uint16_t>((request.data[2] << 8) | request.data[3]);
+    uint16_t value = static_cast<uint16_t>((request.data[4] << 8) | request.data[5]);
+    std::lock_guard<std::mutex> lock(bankMutex_);
+
+    if (function == 0x03)
+    {
+        uint16_t count = value;
+        if (count == 0 || count > MODBUS_MAX_READ_REGISTERS)
+            return buildException(slave, function, 0x03, response);
+        if (static_cast<uint32_t>(addr) + count > REGISTER_COUNT)
+            return buildException(slave, function, 0x02, response);
+        buildReadResponse(slave, function, addr, count, response);
+    }
+    else if (function == 0x06)
+    {
+        if (uint8_t code = checkWrite(addr, 1, request.data + 4))
+            return buildException(slave, function, code, response);
+
+        applyWrite(addr, 1, request.data + 4);
+        // A successful write echoes the request
+        std::memcpy(response.data, request.data, request.size);
+        response.size = request.size;
+    }
+    else if (function == 0x10)
+    {
+        uint16_t count = value;
+        if (count == 0 || count > MODBUS_MAX_WRITE_REGISTERS || request.data[6] != count * 2)
+            return buildException(slave, function, 0x03, response);
+        if (uint8_t code = checkWrite(addr, count, request.data + 7))
+            return buildException(slave, function, code, response);
+
+        applyWrite(addr, count, request.data + 7);
+        // Echo of slave, function, start address and quantity
+        std::memcpy(response.data, request.data, 6);
+        response.size = 6;
+        ModbusFrame::appendCRC(response);
+    }
+    else if (function == 0x17)
+    {
+        uint16_t readCount = value;
+        uint16_t writeAddr = static_cast<uint16_t>((request.data[6] << 8) | request.data[7]);
+        uint16_t writeCount = static_cast<uint16_t>((request.data[8] << 8) | request.data[9]);
+        if (readCount == 0 || readCount > MODBUS_MAX_READ_REGISTERS || writeCount == 0 ||
+            writeCount > MODBUS_MAX_READ_WRITE_REGISTERS || request.data[10] != writeCount * 2)
+            return buildException(slave, function, 0x03, response);
+        if (static_cast<uint32_t>(addr) + readCount > REGISTER_COUNT)
+            return buildException(slave, function, 0x02, response);
+        if (uint8_t code = checkWrite(writeAddr, writeCount, request.data + 11))
+            return buildException(slave, function, code, response);
+
+        // The write is performed before the read
+        applyWrite(writeAddr, writeCount, request.data + 11);
+        buildReadResponse(slave, function, addr, readCount, response);
+    }
+    else
+    {
+        buildException(slave, function, 0x01, response);
+    }
+}
+
+// ========== Serving ==========
+void InverterSimServer::acceptLoop(Listener *listener)
+{
+    while (running_)
+    {
+        int fd = ::accept(listener->fd, nullptr, nullptr);
+        if (fd < 0)
+        {
+            if (!running_)
+                break;
+            continue;
+        }
+        int noDelay = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        connections_++;
+
+        std::lock_guard<std::mutex> lock(clientsMutex_);
+        if (!running_)
+        {
+            ::close(fd);
+            break;
+        }
+        clientFds_.push_back(fd);
+        if (listener->protocol == TransportType::HTTP)
+            clientThreads_.emplace_back(&InverterSimServer::serveConnection, this, fd);
+        else
+            clientThreads_.emplace_back(&InverterSimServer::serveRawConnection, this, fd, listener->protocol);
+    }
+}
+
+void InverterSimServer::serveConnection(int fd)
+{
+    std::random_device seed;
+    uint32_t rngState = seed() | 1u;
+    std::string buffer;
+    char chunk[4096];
+
+    bool open = true;
+    while (open)
+    {
+        // Serve every complete request already buffered (pipelining tolerated)
+        while (open && buffer.find("\r\n\r\n") != std::string::npos)
+        {
+            size_t before = buffer.size();
+            open = handleRequest(fd, buffer, rngState);
+            if (open && buffer.size() == before)
+                break; // Body incomplete, need more bytes
+        }
+        if (!open)
+            break;
+
+        ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0)
+            break;
+        buffer.append(chunk, static_cast<size_t>(received));
+    }
+
+    std::lock_guard<std::mutex> lock(clientsMutex_);
+    clientFds_.erase(std::remove(clientFds_.begin(), clientFds_.end(), fd), clientFds_.end());
+    ::close(fd);
+}
+
+bool InverterSimServer::handleRequest(int fd, std::string &buffer, uint32_t &rngState)
+{
+    size_t headerEnd = buffer.find("\r\n\r\n");
+    std::string headers = buffer.substr(0, headerEnd + 2);
+    std::string lengthValue = headerValue(headers, "content-length");
+    size_t contentLength = lengthValue.empty() ? 0 : std::stoul(lengthValue);
+    size_t total = headerEnd + 4 + contentLength;
+    if (buffer.size() < total)
+        return true; // Wait for the rest of the body
+
+    std::string body = buffer.substr(headerEnd + 4, contentLength);
+    buffer.erase(0, total);
+
+    std::string connection = headerValue(headers, "connection");
+    bool keepAlive = connection.find("close") == std::string::npos &&
+                     connection.find("Close") == std::string::npos;
+
+    size_t methodEnd = headers.find(' ');
+    size_t pathEnd = headers.find(' ', methodEnd + 1);
+    std::string method = headers.substr(0, methodEnd);
+    std::string path = headers.substr(methodEnd + 1, pathEnd - methodEnd - 1);
+
+    if (method == "POST" && path == "/api/upload")
+        return handleUpload(fd, body, keepAlive);
+
+    if (method != "POST" || (path != "/api/inverter/read" && path != "/api/inverter/write"))
+    {
+        const char notFound[] = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+        return sendAll(fd, notFound, sizeof(notFound) - 1) && keepAlive;
+    }
+
+    requests_++;
+    simulateDelay(rngState);
+
+    FrameBuffer request, response;
+    std::string frameHex;
+    if (extractRequestFrame(body, frameHex) &&
+        ModbusFrame::decodeHex(frameHex.data(), frameHex.size(), request))
+    {
+        // The write endpoint only takes writes (FC23 included), the read endpoint only reads
+        bool writeEndpoint = path == "/api/inverter/write";
+        uint8_t function = request.size >= 2 ? request.data[1] : 0;
+        bool isWrite = function == 0x06 || function == 0x10 || function == 0x17;
+        if (request.size >= 2 && (writeEndpoint ? !isWrite : function != 0x03))
+        {
+            if (request.size >= 4)
+                buildException(request.data[0], function, 0x01, response);
+        }
+        else
+        {
+            handleFrame(request, response);
+        }
+
+        injectFaults(request, response, true, rngState);
+    }
+
+    HexFrame hex;
+    ModbusFrame::encodeHex(response, hex);
+
+    std::string reply;
+    reply.reserve(160 + hex.size);
+    reply += "{\"frame\":\"";
+    reply.append(hex.data, hex.size);
+    reply += "\"}";
+
+    std::string head = "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nContent-Length: " +
+                       std::to_string(reply.size()) +
+                       (keepAlive ? "\r\n\r\n" : "\r\nConnection: close\r\n\r\n");
+    head += reply;
+    return sendAll(fd, head.data(), head.size()) && keepAlive;
+}
+
+// ========== Raw Modbus serving ==========
+void InverterSimServer::serveRawConnection(int fd, TransportType protocol)
+{
+    std::random_device seed;
+    uint32_t rngState = seed() | 1u;
+    std::string buffer;
+    char chunk[1024];
+    ReplyQueue replies;
+
+    bool open = true;
+    while (open)
+    {
+        // Answer every complete frame already buffered (pipelined requests)
+        size_t before;
+        do
+        {
+            before = buffer.size();
+            open = handleRawRequest(fd, protocol, buffer, rngState, replies);
+        } while (open && !buffer.empty() && buffer.size() != before);
+
+        // A gateway answers each transaction once its slave is done, in any order
+        auto now = std::chrono::steady_clock::now();
+        while (open && !replies.empty() && replies.begin()->first <= now)
+        {
+            open = sendAll(fd, replies.begin()->second.data(), replies.begin()->second.size());
+            replies.erase(replies.begin());
+        }
+        if (!open)
+            break;
+
+        if (!replies.empty())
+        {
+            auto waitNs = std::chrono::duration_cast<std::chrono::nanoseconds>(replies.begin()->first - now).count();
+            timespec wait{static_cast<time_t>(waitNs / 1000000000), static_cast<long>(waitNs % 1000000000)};
+            pollfd pfd{fd, POLLIN, 0};
+            if (::ppoll(&pfd, 1, &wait, nullptr) <= 0)
+                continue;
+        }
+
+        ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0)
+            break;
+        buffer.append(chunk, static_cast<size_t>(received));
+    }
+
+    std::lock_guard<std::mutex> lock(clientsMutex_);
+    clientFds_.erase(std::remove(clientFds_.begin(), clientFds_.end(), fd), clientFds_.end());
+    ::close(fd);
+}
+
+// Consumes at most one frame from buffer; false closes the connection
+bool InverterSimServer::handleRawRequest(int fd, TransportType protocol, std::string &buffer, uint32_t &rngState,
+                                         ReplyQueue &replies)
+{
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(buffer.data());
+    FrameBuffer request, response;
+    size_t consumed;
+
+    if (protocol == TransportType::MODBUS_TCP)
+    {
+        if (buffer.size() < 7)
+            return true;
+        uint16_t protocolId = static_cast<uint16_t>((data[2] << 8) | data[3]);
+        size_t length = static_cast<size_t>((data[4] << 8) | data[5]); // Unit id + PDU
+        if (protocolId != 0 || length < 2 || length + 2 > MODBUS_MAX_ADU)
+            return false;
+        consumed = 6 + length;
+        if (buffer.size() < consumed)
+            return true;
+        std::memcpy(request.data, data + 6, length);
+        request.size = length;
+        ModbusFrame::appendCRC(request);
+    }
+    else
+    {
+        size_t length;
+        if (!ModbusFrame::rtuRequestLength(data, buffer.size(), length) || length > MODBUS_MAX_ADU)
+            return false; // Unknown function: the frame boundary is lost
+        if (length == 0 || buffer.size() < length)
+            return true;
+        consumed = length;
+        std::memcpy(request.data, data, length);
+        request.size = length;
+    }
+
+    // A serial line is busy for the whole exchange; Modbus TCP requests overlap
+    requests_++;
+    long delayUs = drawDelayUs(rngState);
+    if (protocol == TransportType::RTU_OVER_TCP && delayUs > 0)
+        std::this_thread::sleep_for(std::chrono::microseconds(delayUs));
+    handleFrame(request, response);
+    injectFaults(request, response, protocol == TransportType::RTU_OVER_TCP, rngState);
+
+    std::string reply;
+    if (protocol == TransportType::MODBUS_TCP)
+    {
+        // A frame a gateway cannot answer ends the connection
+        if (response.size < 4)
+            return false;
+        size_t length = response.size - 2;
+        reply.assign(buffer, 0, 4); // Transaction and protocol id echoed
+        reply += static_cast<char>(length >> 8);
+        reply += static_cast<char>(length & 0xFF);
+        reply.append(reinterpret_cast<const char *>(response.data), length);
+        replies.emplace(std::chrono::steady_clock::now() + std::chrono::microseconds(delayUs), std::move(reply));
+        buffer.erase(0, consumed);
+        return true;
+    }
+
+    // An RTU slave stays silent on an invalid frame
+    reply.assign(reinterpret_cast<const char *>(response.data), response.size);
+    buffer.erase(0, consumed);
+    return reply.empty() || sendAll(fd, reply.data(), reply.size());
+}
+
+// Fault injection applies to frames that would otherwise be answered
+void InverterSimServer::injectFaults(const FrameBuffer &request, FrameBuffer &response, bool corruptCrc,
+                                     uint32_t &rngState)
+{
+    if (response.size > 0 && nextUniform(rngState) < exceptionRate_.load(std::memory_order_relaxed))
+        buildException(request.data[0], request.data[1], injectedException_.load(), response);
+    if (corruptCrc && response.size > 0 && nextUniform(rngState) < crcErrorRate_.load(std::memory_order_relaxed))
+        response.data[response.size - 1] ^= 0xFF;
+}
+
+long InverterSimServer::drawDelayUs(uint32_t &rngState)
+{
+    long delayUs = latencyUs_.load(std::memory_order_relaxed);
+    long jitterUs = jitterUs_.load(std::memory_order_relaxed);
+    if (jitterUs > 0)
+        delayUs += static_cast<long>(nextUniform(rngState) * jitterUs);
+    return delayUs;
+}
+
+void InverterSimServer::simulateDelay(uint32_t &rngState)
+{
+    long delayUs = drawDelayUs(rngState);
+    if (delayUs > 0)
+        std::this_thread::sleep_for(std::chrono::microseconds(delayUs));
+}
+
+// xorshift32, mapped to [0, 1)
+double InverterSimServer::nextUniform(uint32_t &rngState)
+{
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 17;
+    rngState ^= rngState << 5;
+    return rngState / 4294967296.0;
+}
+
+// Accepts {"frame":"..."} with optional whitespace around the colon
+bool InverterSimServer::extractRequestFrame(const std::string &body, std::string &frameHex)
+{
+    size_t pos = body.find("\"frame\"");
+    if (pos == std::string::npos)
+        return false;
+    pos = body.find(':', pos + 7);
+    if (pos == std::string::npos)
+        return false;
+    pos = body.find_first_not_of(" \t\r\n", pos + 1);
+    if (pos == std::string::npos || body[pos] != '"')
+        return false;
+    size_t end = body.find('"', pos + 1);
+    if (end == std::string::npos)
+        return false;
+    frameHex.assign(body, pos + 1, end - pos - 1);
+    return true;
+}
@@ -0,0 +1,151 @@
+#ifndef INVERTER_SIM_SERVER_H
+#define INVERTER_SIM_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ModbusFrame.h"
+#include "ProtocolAdapter.h"
+
+// Behaviour knobs of the simulated inverter
+struct SimOptions
+{
+    uint16_t port = 0;                // HTTP API, 0 picks a free port
+    uint16_t modbusTcpPort = 0;       // Raw Modbus TCP (MBAP), 0 picks a free port
+    uint16_t rtuOverTcpPort = 0;      // Raw RTU frames over TCP, 0 picks a free port
+    long latencyUs = 0;               // Fixed delay added to every request
+    long jitterUs = 0;                // Extra uniformly distributed delay in [0, jitterUs]
+    double exceptionRate = 0.0;       // Fraction of valid requests answered with injectedException
+    uint8_t injectedException = 0x06; // Slave Device Busy
+    double crcErrorRate = 0.0;        // Fraction of responses sent with a corrupted CRC
+};
+
+// Local stand-in for the Inverter SIM HTTP API.
+//
+// Serves POST /api/inverter/read and /api/inverter/write with the same
+// {"frame":"<hex>"} contract over HTTP/1.1 keep-alive. Registers 0-9 are
+// simulated; by default only register 8 (export power percent, 0-100) is
+// writable. FC03, FC06, FC16 and FC23 are supported; a multi-register write
+// is validated as a whole and applied under one lock, so it lands entirely or
+// not at all. Invalid frames get a blank frame, invalid requests a Modbus
+// exception.
+// POST /api/upload accepts encoded sample batches and keeps the last one.
+// The same register bank is also served as a raw Modbus TCP server and an
+// RTU-over-TCP gateway on two further ports.
+class InverterSimServer
+{
+public:
+    static const uint16_t REGISTER_COUNT = 10;
+    static const uint16_t WRITABLE_REGISTER = 8;
+
+    explicit InverterSimServer(const SimOptions &options = SimOptions());
+    ~InverterSimServer();
+
+    InverterSimServer(const InverterSimServer &) = delete;
+    InverterSimServer &operator=(const InverterSimServer &) = delete;
+
+    // Bind to 127.0.0.1 and start serving in the background
+    bool start();
+    void stop();
+
+    uint16_t port() const;
+    uint16_t modbusTcpPort() const;
+    uint16_t rtuOverTcpPort() const;
+    // Endpoint reaching this SIM over the given transport
+    Endpoint endpoint(TransportType transport = TransportType::HTTP) const;
+    std::string readUrl() const;
+    std::string writeUrl() const;
+    std::string uploadUrl() const;
+
+    // Runtime tuning, safe while serving
+    void setLatency(long latencyUs, long jitterUs);
+    void setExceptionRate(double rate, uint8_t code = 0x06);
+    void setCrcErrorRate(double rate);
+
+    uint16_t getRegister(uint16_t addr) const;
+    void setRegister(uint16_t addr, uint16_t value);
+    void resetRegisters();
+    // Make further registers writable by FC06/FC16/FC23 (tests of multi-register writes)
+    void setWritable(uint16_t addr, bool writable);
+
+    uint64_t requestCount() const;
+    uint64_t connectionCount() const;
+
+    // Upload sink
+    uint64_t uploadCount() const;
+    std::string lastUpload() const;
+    // Answer the next `count` uploads with 503 Service Unavailable
+    void failNextUploads(unsigned count);
+    // Answer the next `count` uploads with a 4xx status (400, 401, 403, 404, 413 or 422)
+    void rejectNextUploads(unsigned count, int status = 413);
+
+    // Modbus behaviour without HTTP: returns the response frame, empty for an invalid frame
+    void handleFrame(const FrameBuffer &request, FrameBuffer &response);
+
+private:
+    struct Listener
+    {
+        TransportType protocol;
+        uint16_t port;
+        int fd = -1;
+        std::thread thread;
+    };
+
+    // Modbus TCP replies waiting out their device think time, by due time
+    typedef std::multimap<std::chrono::steady_clock::time_point, std::string> ReplyQueue;
+
+    bool listen(Listener &listener);
+    void acceptLoop(Listener *listener);
+    void serveConnection(int fd);
+    void serveRawConnection(int fd, TransportType protocol);
+    bool handleRawRequest(int fd, TransportType protocol, std::string &buffer, uint32_t &rngState,
+                          ReplyQueue &replies);
+    void injectFaults(const FrameBuffer &request, FrameBuffer &response, bool corruptCrc, uint32_t &rngState);
+    bool handleRequest(int fd, std::string &buffer, uint32_t &rngState);
+    bool handleUpload(int fd, const std::string &body, bool keepAlive);
+    void buildException(uint8_t slave, uint8_t function, uint8_t code, FrameBuffer &response);
+    // Register access of handleFrame; callers hold bankMutex_
+    void buildReadResponse(uint8_t slave, uint8_t function, uint16_t addr, uint16_t count, FrameBuffer &response);
+    uint8_t checkWrite(uint16_t addr, uint16_t count, const uint8_t *values) const; // Exception code, 0 if valid
+    void applyWrite(uint16_t addr, uint16_t count, const uint8_t *values);
+    long drawDelayUs(uint32_t &rngState);
+    void simulateDelay(uint32_t &rngState);
+
+    static double nextUniform(uint32_t &rngState);
+    static bool extractRequestFrame(const std::string &body, std::string &frameHex);
+
+    std::atomic<uint16_t> registers_[REGISTER_COUNT];
+    std::atomic<bool> writable_[REGISTER_COUNT];
+    std::mutex bankMutex_; // Makes multi-register requests atomic
+
+    std::atomic<long> latencyUs_;
+    std::atomic<long> jitterUs_;
+    std::atomic<double> exceptionRate_;
+    std::atomic<uint8_t> injectedException_;
+    std::atomic<double> crcErrorRate_;
+
+    std::atomic<uint64_t> requests_;
+    std::atomic<uint64_t> connections_;
+
+    std::atomic<uint64_t> uploads_;
+    std::atomic<unsigned> failUploads_;
+    std::atomic<unsigned> rejectUploads_;
+    std::atomic<int> rejectStatus_;
+    mutable std::mutex uploadMutex_;
+    std::string lastUpload_;
+
+    Listener listeners_[3]; // HTTP, Modbus TCP, RTU over TCP
+    std::atomic<bool> running_;
+
+    std::mutex clientsMutex_;
+    std::vector<int> clientFds_;
+    std::vector<std::thread> clientThreads_;
+};
+
+#endif
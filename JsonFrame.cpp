@@ -0,0 +1,140 @@
+#include "JsonFrame.h"
+#include <cstring>
+
+namespace
+{
+    const char BODY_PREFIX[] = "{\"frame\":\"";
+    const char BODY_SUFFIX[] = "\"}";
+    const char KEY[] = "\"frame\"";
+    const size_t KEY_LENGTH = sizeof(KEY) - 1;
+
+    inline bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+}
+
+// ========== Request body ==========
+void JsonFrameBody::build(const FrameBuffer &frame)
+{
+    char *p = data;
+    std::memcpy(p, BODY_PREFIX, sizeof(BODY_PREFIX) - 1);
+    p += sizeof(BODY_PREFIX) - 1;
+    ModbusFrame::encodeHex(frame.data, frame.size, p);
+    p += frame.size * 2;
+    std::memcpy(p, BODY_SUFFIX, sizeof(BODY_SUFFIX)); // Includes the NUL
+    size = static_cast<size_t>(p - data) + sizeof(BODY_SUFFIX) - 1;
+}
+
+// ========== Response extraction ==========
+void JsonFrameExtractor::reset(FrameBuffer &out)
+{
+    out_ = &out;
+    out_->size = 0;
+    state_ = State::KEY;
+    matched_ = 0;
+    bad_ = false;
+    pending_ = false;
+}
+
+void JsonFrameExtractor::feed(const char *data, size_t size)
+{
+    const char *p = data;
+    const char *end = data + size;
+    while (p < end && state_ != State::DONE)
+    {
+        char c = *p;
+        switch (state_)
+        {
+        case State::KEY:
+            if (matched_ == 0 && c != '"')
+            {
+                // Nothing can match before the next quote
+                const char *quote = static_cast<const char *>(std::memchr(p, '"', static_cast<size_t>(end - p)));
+                p = quote ? quote : end;
+                break;
+            }
+            // Only the first character of the key is a quote, so a mismatch
+            // restarts the match at 0 or, on a quote, at 1
+            if (c == KEY[matched_])
+                matched_++;
+            else
+                matched_ = c == '"' ? 1 : 0;
+            if (matched_ == KEY_LENGTH)
+                state_ = State::COLON;
+            ++p;
+            break;
+        case State::COLON:
+        case State::QUOTE:
+            ++p;
+            if (isSpace(c))
+                break;
+            if (state_ == State::COLON && c == ':')
+                state_ = State::QUOTE;
+            else if (state_ == State::QUOTE && c == '"')
+                state_ = State::VALUE;
+            else
+            {
+                // "frame" was a value or not followed by a string, keep looking
+                state_ = State::KEY;
+                matched_ = c == '"' ? 1 : 0;
+            }
+            break;
+        case State::VALUE:
+            feedValue(p, end);
+            break;
+        case State::DONE:
+            break;
+        }
+    }
+}
+
+// Decodes the hex digits in [p, end) up to the closing quote in bulk
+void JsonFrameExtractor::feedValue(const char *&p, const char *end)
+{
+    const char *quote = static_cast<const char *>(std::memchr(p, '"', static_cast<size_t>(end - p)));
+    const char *stop = quote ? quote : end;
+
+    if (!bad_ && pending_ && p < stop)
+    {
+        char pair[2] = {pendingDigit_, *p++};
+        size_t decoded = 0;
+        if (!ModbusFrame::decodeHex(pair, 2, out_->data + out_->size, sizeof(out_->data) - out_->size, decoded))
+            bad_ = true;
+        out_->size += decoded;
+        pending_ = false;
+    }
+
+    size_t run = static_cast<size_t>(stop - p);
+    size_t even = run & ~static_cast<size_t>(1);
+    if (!bad_)
+    {
+        size_t decoded = 0;
+        if (!ModbusFrame::decodeHex(p, even, out_->data + out_->size, sizeof(out_->data) - out_->size, decoded))
+            bad_ = true;
+        out_->size += decoded;
+        if (run & 1)
+        {
+            pendingDigit_ = p[even];
+            pending_ = true;
+        }
+    }
+    p = stop;
+
+    if (quote)
+    {
+        ++p;
+        state_ = State::DONE;
+        // An odd digit count or bad digit yields a blank frame, like decodeHex does
+        if (pending_)
+            bad_ = true;
+        if (bad_)
+            out_->size = 0;
+    }
+}
+
+size_t JsonFrameExtractor::curlWrite(void *contents, size_t size, size_t nmemb, void *userp)
+{
+    static_cast<JsonFrameExtractor *>(userp)->feed(static_cast<const char *>(contents), size * nmemb);
+    return size * nmemb;
+}
@@ -0,0 +1,62 @@
+#ifndef JSON_FRAME_H
+#define JSON_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include "ModbusFrame.h"
+
+// Request body {"frame":"<hex>"} of the Inverter SIM API, built in place
+// with no heap allocation. NUL-terminated.
+struct JsonFrameBody
+{
+    char data[sizeof("{\"frame\":\"\"}") - 1 + MODBUS_MAX_ADU * 2 + 1];
+    size_t size = 0;
+
+    void build(const FrameBuffer &frame);
+};
+
+// Incremental parser for the API response {"frame":"<hex>", ...}.
+//
+// Chunks are fed as libcurl delivers them and may split the key, the value or
+// a single hex digit pair anywhere. The hex digits are decoded straight into
+// the caller's frame; nothing of the body is buffered. Whitespace around the
+// colon is accepted and everything after the frame value is ignored.
+class JsonFrameExtractor
+{
+public:
+    JsonFrameExtractor() = default;
+    explicit JsonFrameExtractor(FrameBuffer &out) { reset(out); }
+
+    // Start a new response decoded into out (left blank until the value is read)
+    void reset(FrameBuffer &out);
+    void feed(const char *data, size_t size);
+
+    // The frame value has been read up to its closing quote
+    bool found() const { return state_ == State::DONE; }
+    // The value was well-formed hex that fits a frame; otherwise out is blank (size 0)
+    bool valid() const { return found() && !bad_; }
+
+    // CURLOPT_WRITEFUNCTION with the extractor as CURLOPT_WRITEDATA
+    static size_t curlWrite(void *contents, size_t size, size_t nmemb, void *userp);
+
+private:
+    enum class State : uint8_t
+    {
+        KEY,   // Looking for "frame"
+        COLON, // Key matched, expecting ':'
+        QUOTE, // Expecting the value's opening quote
+        VALUE, // Decoding hex digits
+        DONE
+    };
+
+    void feedValue(const char *&p, const char *end);
+
+    FrameBuffer *out_ = nullptr;
+    State state_ = State::KEY;
+    uint8_t matched_ = 0; // Characters of "frame" matched so far
+    bool bad_ = false;
+    bool pending_ = false; // High digit of a pair split across chunks
+    char pendingDigit_ = 0;
+};
+
+#endif
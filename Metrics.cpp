@@ -0,0 +1,495 @@
+#include "Metrics.h"
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+const char *requestTypeName(RequestType type)
+{
+    switch (type)
+    {
+    case RequestType::READ:
+        return "read";
+    case RequestType::WRITE:
+        return "write";
+    default:
+        return "unknown";
+    }
+}
+
+const char *attemptOutcomeName(AttemptOutcome outcome)
+{
+    switch (outcome)
+    {
+    case AttemptOutcome::SUCCESS:
+        return "success";
+    case AttemptOutcome::TRANSPORT_FAILURE:
+        return "transport_failure";
+    case AttemptOutcome::CRC_ERROR:
+        return "crc_error";
+    case AttemptOutcome::MODBUS_EXCEPTION:
+        return "modbus_exception";
+    case AttemptOutcome::PARSE_FAILURE:
+        return "parse_failure";
+    default:
+        return "unknown";
+    }
+}
+
+// ========== LatencyHistogram ==========
+LatencyHistogram::LatencyHistogram()
+{
+    reset();
+}
+
+void LatencyHistogram::record(uint64_t latencyUs)
+{
+    // Smallest i with latencyUs <= 2^i
+    size_t bucket = 0;
+    if (latencyUs > 1)
+        bucket = 64 - static_cast<size_t>(__builtin_clzll(latencyUs - 1));
+    if (bucket >= BUCKETS)
+        bucket = BUCKETS - 1;
+
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sumUs_.fetch_add(latencyUs, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t bucket)
+{
+    return bucket + 1 < BUCKETS ? (1ULL << bucket) : 0;
+}
+
+uint64_t LatencyHistogram::percentileUs(double p) const
+{
+    uint64_t total = count();
+    if (total == 0)
+        return 0;
+    uint64_t rank = static_cast<uint64_t>(p * total);
+    if (rank >= total)
+        rank = total - 1;
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < BUCKETS; ++i)
+    {
+        seen += bucketCount(i);
+        if (seen > rank)
+            return i + 1 < BUCKETS ? bucketUpperBound(i) : bucketUpperBound(BUCKETS - 2);
+    }
+    return bucketUpperBound(BUCKETS - 2);
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto &bucket : buckets_)
+        bucket.store(0, std::memory_order_relaxed);
+    count_.store(0, std::memory_order_relaxed);
+    sumUs_.store(0, std::memory_order_relaxed);
+}
+
+RequestStats::RequestStats() : requests(0), failures(0), rejected(0)
+{
+    for (auto &attempt : attempts)
+        attempt.store(0, std::memory_order_relaxed);
+}
+
+SlaveMetrics::SlaveMetrics()
+    : polls(0), failedPolls(0), hasBuffer(false), bufferSize(0), bufferCapacity(0), droppedSamples(0) {}
+
+// ========== Metrics registry ==========
+Metrics &Metrics::getInstance()
+{
+    static Metrics instance;
+    return instance;
+}
+
+Metrics::Metrics()
+{
+    for (auto &slot : slaves_)
+        slot.store(nullptr, std::memory_order_relaxed);
+}
+
+Metrics::~Metrics()
+{
+    for (auto &slot : slaves_)
+        delete slot.load(std::memory_order_relaxed);
+}
+
+SlaveMetrics &Metrics::slave(uint8_t address)
+{
+    std::atomic<SlaveMetrics *> &slot = slaves_[address];
+    SlaveMetrics *existing = slot.load(std::memory_order_acquire);
+    if (existing)
+        return *existing;
+
+    // First use: publish a new slot, or adopt the one another thread won with
+    SlaveMetrics *created = new SlaveMetrics();
+    if (slot.compare_exchange_strong(existing, created, std::memory_order_acq_rel))
+        return *created;
+    delete created;
+    return *existing;
+}
+
+const SlaveMetrics *Metrics::find(uint8_t slave) const
+{
+    return slaves_[slave].load(std::memory_order_acquire);
+}
+
+void Metrics::recordAttempt(uint8_t slaveAddr, RequestType type, AttemptOutcome outcome, uint64_t latencyUs)
+{
+    RequestStats &stats = slave(slaveAddr).requests[static_cast<size_t>(type)];
+    stats.attempts[static_cast<size_t>(outcome)].fetch_add(1, std::memory_order_relaxed);
+    stats.attemptLatency.record(latencyUs);
+}
+
+void Metrics::recordRequest(uint8_t slaveAddr, RequestType type, bool ok, uint64_t latencyUs)
+{
+    RequestStats &stats = slave(slaveAddr).requests[static_cast<size_t>(type)];
+    stats.requests.fetch_add(1, std::memory_order_relaxed);
+    if (!ok)
+        stats.failures.fetch_add(1, std::memory_order_relaxed);
+    stats.requestLatency.record(latencyUs);
+}
+
+void Metrics::recordRejected(uint8_t slaveAddr, RequestType type)
+{
+    slave(slaveAddr).requests[static_cast<size_t>(type)].rejected.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Metrics::recordPoll(uint8_t slaveAddr, bool ok, uint64_t latencyUs)
+{
+    SlaveMetrics &metrics = slave(slaveAddr);
+    metrics.polls.fetch_add(1, std::memory_order_relaxed);
+    if (!ok)
+        metrics.failedPolls.fetch_add(1, std::memory_order_relaxed);
+    metrics.pollLatency.record(latencyUs);
+}
+
+void Metrics::setBufferState(uint8_t slaveAddr, size_t size, size_t capacity, uint64_t dropped)
+{
+    SlaveMetrics &metrics = slave(slaveAddr);
+    metrics.bufferSize.store(size, std::memory_order_relaxed);
+    metrics.bufferCapacity.store(capacity, std::memory_order_relaxed);
+    metrics.droppedSamples.store(dropped, std::memory_order_relaxed);
+    metrics.hasBuffer.store(true, std::memory_order_relaxed);
+}
+
+void Metrics::reset()
+{
+    for (auto &slot : slaves_)
+    {
+        SlaveMetrics *metrics = slot.load(std::memory_order_acquire);
+        if (!metrics)
+            continue;
+        for (auto &stats : metrics->requests)
+        {
+            for (auto &attempt : stats.attempts)
+                attempt.store(0, std::memory_order_relaxed);
+            stats.requests.store(0, std::memory_order_relaxed);
+            stats.failures.store(0, std::memory_order_relaxed);
+            stats.rejected.store(0, std::memory_order_relaxed);
+            stats.attemptLatency.reset();
+            stats.requestLatency.reset();
+        }
+        metrics->polls.store(0, std::memory_order_relaxed);
+        metrics->failedPolls.store(0, std::memory_order_relaxed);
+        metrics->pollLatency.reset();
+        metrics->droppedSamples.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t Metrics::elapsedUs(std::chrono::steady_clock::time_point start)
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+                                     std::chrono::steady_clock::now() - start)
+                                     .count());
+}
+
+// ========== Rendering ==========
+static std::string slaveLabel(size_t address)
+{
+    char label[8];
+    std::snprintf(label, sizeof(label), "0x%02x", static_cast<unsigned>(address));
+    return label;
+}
+
+std::string Metrics::renderText() const
+{
+    std::ostringstream out;
+    out << "=== Metrics ===\n";
+    for (size_t address = 0; address < MAX_SLAVES; ++address)
+    {
+        const SlaveMetrics *metrics = find(static_cast<uint8_t>(address));
+        if (!metrics)
+            continue;
+
+        out << "slave " << slaveLabel(address) << "\n";
+        for (size_t t = 0; t < REQUEST_TYPE_COUNT; ++t)
+        {
+            const RequestStats &stats = metrics->requests[t];
+            if (stats.requests.load(std::memory_order_relaxed) == 0 && stats.rejected.load(std::memory_order_relaxed) == 0)
+                continue;
+            out << "  " << requestTypeName(static_cast<RequestType>(t)) << ": "
+                << stats.requests.load(std::memory_order_relaxed) << " requests, "
+                << stats.failures.load(std::memory_order_relaxed) << " failed, "
+                << stats.rejected.load(std::memory_order_relaxed) << " rejected | attempts";
+            for (size_t o = 0; o < ATTEMPT_OUTCOME_COUNT; ++o)
+                out << " " << attemptOutcomeName(static_cast<AttemptOutcome>(o)) << "="
+                    << stats.attempts[o].load(std::memory_order_relaxed);
+            out << " | p50<=" << stats.requestLatency.percentileUs(0.50) << "us"
+                << " p99<=" << stats.requestLatency.percentileUs(0.99) << "us\n";
+        }
+        if (metrics->polls.load(std::memory_order_relaxed) > 0)
+        {
+            out << "  poll: " << metrics->polls.load(std::memory_order_relaxed) << " polls, "
+                << metrics->failedPolls.load(std::memory_order_relaxed) << " failed"
+                << " | p50<=" << metrics->pollLatency.percentileUs(0.50) << "us"
+                << " p99<=" << metrics->pollLatency.percentileUs(0.99) << "us\n";
+        }
+        if (metrics->hasBuffer.load(std::memory_order_relaxed))
+        {
+            out << "  buffer: " << metrics->bufferSize.load(std::memory_order_relaxed) << "/"
+                << metrics->bufferCapacity.load(std::memory_order_relaxed) << " samples, "
+                << metrics->droppedSamples.load(std::memory_order_relaxed) << " dropped\n";
+        }
+    }
+    return out.str();
+}
+
+static void renderHistogram(std::ostringstream &out, const std::string &name, const std::string &labels,
+                            const LatencyHistogram &histogram)
+{
+    uint64_t cumulative = 0;
+    for (size_t i = 0; i + 1 < LatencyHistogram::BUCKETS; ++i)
+    {
+        cumulative += histogram.bucketCount(i);
+        out << name << "_bucket{" << labels << ",le=\"" << LatencyHistogram::bucketUpperBound(i) / 1e6
+            << "\"} " << cumulative << "\n";
+    }
+    out << name << "_bucket{" << labels << ",le=\"+Inf\"} " << histogram.count() << "\n";
+    out << name << "_sum{" << labels << "} " << histogram.sumUs() / 1e6 << "\n";
+    out << name << "_count{" << labels << "} " << histogram.count() << "\n";
+}
+
+std::string Metrics::renderPrometheus() const
+{
+    std::ostringstream out;
+
+    out << "# HELP ecowatt_modbus_attempts_total Modbus attempts by outcome\n"
+        << "# TYPE ecowatt_modbus_attempts_total counter\n";
+    for (size_t address = 0; address < MAX_SLAVES; ++address)
+    {
+        const SlaveMetrics *metrics = find(static_cast<uint8_t>(address));
+        if (!metrics)
+            continue;
+        for (size_t t = 0; t < REQUEST_TYPE_COUNT; ++t)
+            for (size_t o = 0; o < ATTEMPT_OUTCOME_COUNT; ++o)
+                out << "ecowatt_modbus_attempts_total{slave=\"" << slaveLabel(address) << "\",type=\""
+                    << requestTypeName(static_cast<RequestType>(t)) << "\",outcome=\""
+                    << attemptOutcomeName(static_cast<AttemptOutcome>(o)) << "\"} "
+                    << metrics->requests[t].attempts[o].load(std::memory_order_relaxed) << "\n";
+    }
+
+    out << "# HELP ecowatt_modbus_requests_total Modbus requests after retries\n"
+        << "# TYPE ecowatt_modbus_requests_total counter\n";
+    for (size_t address = 0; address < MAX_SLAVES; ++address)
+    {
+        const SlaveMetrics *metrics = find(static_cast<uint8_t>(address));
+        if (!metrics)
+            continue;
+        for (size_t t = 0; t < REQUEST_TYPE_COUNT; ++t)
+            out << "ecowatt_modbus_requests_total{slave=\"" << slaveLabel(address) << "\",type=\""
+                << requestTypeName(static_cast<RequestType>(t)) << "\"} "
+                << metrics->requests[t].requests.load(std::memory_order_relaxed) << "\n";
+    }
+
+    out << "# HELP ecowatt_modbus_request_failures_total Modbus requests that failed every attempt\n"
+        << "# TYPE ecowatt_modbus_request_failures_total counter\n";
+    for (size_t address = 0; address < MAX_SLAVES; ++address)
+    {
+        const SlaveMetrics *metrics = find(static_cast<uint8_t>(address));
+        if (!metrics)
+            continue;
+        for (size_t t = 0; t < REQUEST_TYPE_COUNT; ++t)
+            out << "ecowatt_modbus_request_failures_total{slave=\"" << slaveLabel(address) << "\",type=\""
+                << requestTypeName(static_cast<RequestType>(t)) << "\"} "
+                << metrics->requests[t].failures.load(std::memory_order_relaxed) << "\n";
+    }
+
+    out << "# HELP ecowatt_modbus_requests_rejected_total Requests refused by an open circuit breaker\n"
+        << "# TYPE ecowatt_modbus_requests_rejected_total counter\n";
+    for (size_t address = 0; address < MAX_SLAVES; ++address)
+    {
+        const SlaveMetrics *metrics = find(static_cast<uint8_t>(address));
+        if (!metrics)
+            continue;
+        for (size_t t = 0; t < REQUEST_TYPE_COUNT; ++t)
+            out << "ecowatt_modbus_requests_rejected_total{slave=\"" << slaveLabel(address) << "\",type=\""
+                << requestTypeName(static_cast<RequestType>(t)) << "\"} "
+                << metrics->requests[t].rejected.load(std::memory_order_relaxed) << "\n";
+    }
+
+    out << "# HELP ecowatt_modbus_attempt_latency_seconds Latency of single Modbus attempts\n"
+        << "# TYPE ecowatt_modbus_attempt_latency_seconds histogram\n";
+    for (size_t address = 0; address < MAX_SLAVES; ++address)
+    {
+        const SlaveMetrics *metrics = find(static_cast<uint8_t>(address));
+        if (!metrics)
+            continue;
+        for (size_t t = 0; t < REQUEST_TYPE_COUNT; ++t)
+            renderHistogram(out, "ecowatt_modbus_attempt_latency_seconds",
+                            "slave=\"" + slaveLabel(address) + "\",type=\"" +
+                                requestTypeName(static_cast<RequestType>(t)) + "\"",
+                            metrics->requests[t].attemptLatency);
+    }
+
+    out << "# HELP ecowatt_modbus_request_latency_seconds Latency of Modbus requests including retries\n"
+        << "# TYPE ecowatt_modbus_request_latency_seconds histogram\n";
+    for (size_t address = 0; address < MAX_SLAVES; ++address)
+    {
+        const SlaveMetrics *metrics = find(static_cast<uint8_t>(address));
+        if (!metrics)
+            continue;
+        for (size_t t = 0; t < REQUEST_TYPE_COUNT; ++t)
+            renderHistogram(out, "ecowatt_modbus_request_latency_seconds",
+                            "slave=\"" + slaveLabel(address) + "\",type=\"" +
+                                requestTypeName(static_cast<RequestType>(t)) + "\"",
+                            metrics->requests[t].requestLatency);
+    }
+
+    out << "# HELP ecowatt_polls_total Poll ticks per inverter\n"
+        << "# TYPE ecowatt_polls_total counter\n";
+    for (size_t address = 0; address < MAX_SLAVES; ++address)
+    {
+        const SlaveMetrics *metrics = find(static_cast<uint8_t>(address));
+        if (metrics)
+            out << "ecowatt_polls_total{slave=\"" << slaveLabel(address) << "\"} "
+                << metrics->polls.load(std::memory_order_relaxed) << "\n";
+    }
+
+    out << "# HELP ecowatt_poll_failures_total Poll ticks with at least one failed read\n"
+        << "# TYPE ecowatt_poll_failures_total counter\n";
+    for (size_t address = 0; address < MAX_SLAVES; ++address)
+    {
+        const SlaveMetrics *metrics = find(static_cast<uint8_t>(address));
+        if (metrics)
+            out << "ecowatt_poll_failures_total{slave=\"" << slaveLabel(address) << "\"} "
+                << metrics->failedPolls.load(std::memory_order_relaxed) << "\n";
+    }
+
+    out << "# HELP ecowatt_poll_latency_seconds Time spent reading all due parameters in one tick\n"
+        << "# TYPE ecowatt_poll_latency_seconds histogram\n";
+    for (size_t address = 0; address < MAX_SLAVES; ++address)
+    {
+        const SlaveMetrics *metrics = find(static_cast<uint8_t>(address));
+        if (metrics)
+            renderHistogram(out, "ecowatt_poll_latency_seconds", "slave=\"" + slaveLabel(address) + "\"",
+                            metrics->pollLatency);
+    }
+
+    out << "# HELP ecowatt_buffer_samples Samples waiting for upload\n"
+        << "# TYPE ecowatt_buffer_samples gauge\n";
+    for (size_t address = 0; address < MAX_SLAVES; ++address)
+    {
+        const SlaveMetrics *metrics = find(static_cast<uint8_t>(address));
+        if (metrics && metrics->hasBuffer.load(std::memory_order_relaxed))
+            out << "ecowatt_buffer_samples{slave=\"" << slaveLabel(address) << "\"} "
+                << metrics->bufferSize.load(std::memory_order_relaxed) << "\n";
+    }
+
+    out << "# HELP ecowatt_buffer_capacity Sample buffer capacity\n"
+        << "# TYPE ecowatt_buffer_capacity gauge\n";
+    for (size_t address = 0; address < MAX_SLAVES; ++address)
+    {
+        const SlaveMetrics *metrics = find(static_cast<uint8_t>(address));
+        if (metrics && metrics->hasBuffer.load(std::memory_order_relaxed))
+            out << "ecowatt_buffer_capacity{slave=\"" << slaveLabel(address) << "\"} "
+                << metrics->bufferCapacity.load(std::memory_order_relaxed) << "\n";
+    }
+
+    out << "# HELP ecowatt_buffer_dropped_samples_total Samples dropped by the overflow policy\n"
+        << "# TYPE ecowatt_buffer_dropped_samples_total counter\n";
+    for (size_t address = 0; address < MAX_SLAVES; ++address)
+    {
+        const SlaveMetrics *metrics = find(static_cast<uint8_t>(address));
+        if (metrics && metrics->hasBuffer.load(std::memory_order_relaxed))
+            out << "ecowatt_buffer_dropped_samples_total{slave=\"" << slaveLabel(address) << "\"} "
+                << metrics->droppedSamples.load(std::memory_order_relaxed) << "\n";
+    }
+
+    return out.str();
+}
+
+bool Metrics::writePrometheusFile(const std::string &path) const
+{
+    std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+        if (!file.is_open())
+        {
+            std::cerr << "Error: Could not write metrics file: " << tmpPath << std::endl;
+            return false;
+        }
+        file << renderPrometheus();
+        if (!file.good())
+            return false;
+    }
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0)
+    {
+        std::cerr << "Error: Could not replace metrics file: " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// ========== MetricsExporter ==========
+MetricsExporter::MetricsExporter(std::chrono::milliseconds interval, const std::string &prometheusFile,
+                                 bool textDump)
+    : interval_(interval), prometheusFile_(prometheusFile), textDump_(textDump) {}
+
+MetricsExporter::~MetricsExporter()
+{
+    stop();
+}
+
+void MetricsExporter::start()
+{
+    if (interval_.count() <= 0 || (prometheusFile_.empty() && !textDump_))
+        return; // Nothing to export
+    thread_ = std::thread(&MetricsExporter::run, this);
+}
+
+void MetricsExporter::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (thread_.joinable())
+        thread_.join();
+}
+
+void MetricsExporter::exportNow()
+{
+    Metrics &metrics = Metrics::getInstance();
+    if (textDump_)
+        std::cout << metrics.renderText() << std::flush;
+    if (!prometheusFile_.empty())
+        metrics.writePrometheusFile(prometheusFile_);
+}
+
+void MetricsExporter::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto next = std::chrono::steady_clock::now() + interval_;
+    while (!wake_.wait_until(lock, next, [this]()
+                             { return stopping_; }))
+    {
+        lock.unlock();
+        exportNow();
+        lock.lock();
+        next += interval_;
+    }
+}
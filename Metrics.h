@@ -0,0 +1,164 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Modbus request kinds tracked separately
+enum class RequestType : uint8_t
+{
+    READ = 0,
+    WRITE,
+    COUNT
+};
+
+// Result of a single attempt (one HTTP round trip)
+enum class AttemptOutcome : uint8_t
+{
+    SUCCESS = 0,
+    TRANSPORT_FAILURE, // HTTP/curl error or timeout
+    CRC_ERROR,
+    MODBUS_EXCEPTION,
+    PARSE_FAILURE, // Blank, malformed or mismatched response
+    COUNT
+};
+
+static const size_t REQUEST_TYPE_COUNT = static_cast<size_t>(RequestType::COUNT);
+static const size_t ATTEMPT_OUTCOME_COUNT = static_cast<size_t>(AttemptOutcome::COUNT);
+
+const char *requestTypeName(RequestType type);
+const char *attemptOutcomeName(AttemptOutcome outcome);
+
+// Lock-free latency histogram with power-of-two microsecond buckets.
+// Bucket i counts latencies <= 2^i us; the last bucket is unbounded.
+class LatencyHistogram
+{
+public:
+    static const size_t BUCKETS = 25; // 1 us .. ~8.4 s, then +Inf
+
+    LatencyHistogram();
+
+    void record(uint64_t latencyUs);
+
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint64_t sumUs() const { return sumUs_.load(std::memory_order_relaxed); }
+    uint64_t bucketCount(size_t bucket) const { return buckets_[bucket].load(std::memory_order_relaxed); }
+    // Upper bound of a bucket in microseconds, 0 for the unbounded last bucket
+    static uint64_t bucketUpperBound(size_t bucket);
+    // Upper bound of the bucket holding the p-quantile (approximate)
+    uint64_t percentileUs(double p) const;
+
+    void reset();
+
+private:
+    std::atomic<uint64_t> buckets_[BUCKETS];
+    std::atomic<uint64_t> count_;
+    std::atomic<uint64_t> sumUs_;
+};
+
+// Counters for one request type of one slave
+struct RequestStats
+{
+    RequestStats();
+
+    std::atomic<uint64_t> attempts[ATTEMPT_OUTCOME_COUNT];
+    std::atomic<uint64_t> requests; // After retries
+    std::atomic<uint64_t> failures; // Requests that failed every attempt
+    std::atomic<uint64_t> rejected; // Refused by an open circuit breaker
+    LatencyHistogram attemptLatency;
+    LatencyHistogram requestLatency; // Including retries
+};
+
+// Everything recorded for one slave address
+struct SlaveMetrics
+{
+    SlaveMetrics();
+
+    RequestStats requests[REQUEST_TYPE_COUNT];
+
+    std::atomic<uint64_t> polls;
+    std::atomic<uint64_t> failedPolls;
+    LatencyHistogram pollLatency;
+
+    std::atomic<bool> hasBuffer;
+    std::atomic<uint64_t> bufferSize;
+    std::atomic<uint64_t> bufferCapacity;
+    std::atomic<uint64_t> droppedSamples;
+};
+
+// Process-wide metrics registry. Recording is wait-free (relaxed atomics,
+// per-slave slots created on first use), so it is safe on the poll hot path.
+class Metrics
+{
+public:
+    static const size_t MAX_SLAVES = 256;
+
+    static Metrics &getInstance();
+
+    void recordAttempt(uint8_t slave, RequestType type, AttemptOutcome outcome, uint64_t latencyUs);
+    void recordRequest(uint8_t slave, RequestType type, bool ok, uint64_t latencyUs);
+    void recordRejected(uint8_t slave, RequestType type);
+    void recordPoll(uint8_t slave, bool ok, uint64_t latencyUs);
+    void setBufferState(uint8_t slave, size_t size, size_t capacity, uint64_t dropped);
+
+    // Null when nothing was recorded for the slave yet
+    const SlaveMetrics *find(uint8_t slave) const;
+
+    // Human-readable summary and Prometheus text exposition format
+    std::string renderText() const;
+    std::string renderPrometheus() const;
+    // Written to a temporary file and renamed, so scrapers never see a partial file
+    bool writePrometheusFile(const std::string &path) const;
+
+    // Zero every counter (tests and benchmarks)
+    void reset();
+
+    static uint64_t elapsedUs(std::chrono::steady_clock::time_point start);
+
+private:
+    Metrics();
+    ~Metrics();
+    Metrics(const Metrics &) = delete;
+    Metrics &operator=(const Metrics &) = delete;
+
+    SlaveMetrics &slave(uint8_t address);
+
+    std::atomic<SlaveMetrics *> slaves_[MAX_SLAVES];
+};
+
+// Periodically prints the text summary and/or rewrites the Prometheus file
+class MetricsExporter
+{
+public:
+    MetricsExporter(std::chrono::milliseconds interval, const std::string &prometheusFile, bool textDump);
+    ~MetricsExporter();
+
+    MetricsExporter(const MetricsExporter &) = delete;
+    MetricsExporter &operator=(const MetricsExporter &) = delete;
+
+    void start();
+    void stop();
+
+    // One export cycle
+    void exportNow();
+
+private:
+    void run();
+
+    std::chrono::milliseconds interval_;
+    std::string prometheusFile_;
+    bool textDump_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include "ModbusCRC.h"
+
+namespace
+{
+    struct CrcTables
+    {
+        // t[k][b] is the CRC contribution of byte b followed by k zero bytes
+        uint16_t t[8][256];
+    };
+
+    constexpr CrcTables makeTables()
+    {
+        CrcTables tables{};
+        for (int i = 0; i < 256; ++i)
+        {
+            uint16_t crc = static_cast<uint16_t>(i);
+            for (int j = 0; j < 8; ++j)
+                crc = (crc & 0x0001) ? static_cast<uint16_t>((crc >> 1) ^ 0xA001) : static_cast<uint16_t>(crc >> 1);
+            tables.t[0][i] = crc;
+        }
+        for (int k = 1; k < 8; ++k)
+        {
+            for (int i = 0; i < 256; ++i)
+            {
+                uint16_t prev = tables.t[k - 1][i];
+                tables.t[k][i] = static_cast<uint16_t>((prev >> 8) ^ tables.t[0][prev & 0xFF]);
+            }
+        }
+        return tables;
+    }
+
+    constexpr CrcTables CRC_TABLES = makeTables();
+
+    static_assert(CRC_TABLES.t[0][1] == 0xC0C1, "CRC table generation is broken");
+}
+
+uint16_t ModbusCRC::bitwise(const uint8_t *data, size_t len)
+{
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; ++i)
+    {
+        crc ^= data[i];
+        for (int j = 0; j < 8; ++j)
+        {
+            if (crc & 0x0001)
+                crc = (crc >> 1) ^ 0xA001;
+            else
+                crc >>= 1;
+        }
+    }
+    return crc;
+}
+
+uint16_t ModbusCRC::table(const uint8_t *data, size_t len)
+{
+    const uint16_t *t0 = CRC_TABLES.t[0];
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; ++i)
+        crc = static_cast<uint16_t>((crc >> 8) ^ t0[(crc ^ data[i]) & 0xFF]);
+    return crc;
+}
+
+uint16_t ModbusCRC::slicing8(const uint8_t *data, size_t len)
+{
+    const auto &t = CRC_TABLES.t;
+    uint16_t crc = 0xFFFF;
+    while (len >= 8)
+    {
+        // The 16-bit CRC only overlaps the first two bytes of each chunk
+        uint16_t x = static_cast<uint16_t>(crc ^ (data[0] | (data[1] << 8)));
+        crc = static_cast<uint16_t>(t[7][x & 0xFF] ^ t[6][x >> 8] ^
+                                    t[5][data[2]] ^ t[4][data[3]] ^
+                                    t[3][data[4]] ^ t[2][data[5]] ^
+                                    t[1][data[6]] ^ t[0][data[7]]);
+        data += 8;
+        len -= 8;
+    }
+    while (len--)
+        crc = static_cast<uint16_t>((crc >> 8) ^ t[0][(crc ^ *data++) & 0xFF]);
+    return crc;
+}
@@ -0,0 +1,28 @@
+#ifndef MODBUS_CRC_H
+#define MODBUS_CRC_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Modbus CRC-16 (polynomial 0xA001 reflected, initial value 0xFFFF).
+// All variants produce identical results; they differ only in speed.
+class ModbusCRC
+{
+public:
+    // Reference implementation, one bit at a time
+    static uint16_t bitwise(const uint8_t *data, size_t len);
+
+    // One table lookup per byte (256-entry table generated at compile time)
+    static uint16_t table(const uint8_t *data, size_t len);
+
+    // Eight bytes per iteration using eight 256-entry tables
+    static uint16_t slicing8(const uint8_t *data, size_t len);
+
+    // Fastest variant for typical frame sizes, used by ModbusHandler
+    static uint16_t compute(const uint8_t *data, size_t len)
+    {
+        return slicing8(data, len);
+    }
+};
+
+#endif
@@ -0,0 +1,223 @@
+#include "ModbusFrame.h"
+#include "ModbusCRC.h"
+#include <cstring>
+
+namespace
+{
+    const char HEX_DIGITS[] = "0123456789abcdef";
+
+    // Nibble value of an ASCII hex digit, 0xFF for anything else
+    struct HexDecodeTable
+    {
+        uint8_t value[256];
+    };
+
+    constexpr HexDecodeTable makeDecodeTable()
+    {
+        HexDecodeTable table{};
+        for (int i = 0; i < 256; ++i)
+            table.value[i] = 0xFF;
+        for (int i = 0; i < 10; ++i)
+            table.value['0' + i] = static_cast<uint8_t>(i);
+        for (int i = 0; i < 6; ++i)
+        {
+            table.value['a' + i] = static_cast<uint8_t>(10 + i);
+            table.value['A' + i] = static_cast<uint8_t>(10 + i);
+        }
+        return table;
+    }
+
+    constexpr HexDecodeTable HEX_DECODE = makeDecodeTable();
+
+    inline void put16(FrameBuffer &frame, uint16_t value)
+    {
+        frame.data[frame.size++] = static_cast<uint8_t>(value >> 8);
+        frame.data[frame.size++] = static_cast<uint8_t>(value & 0xFF);
+    }
+}
+
+void ModbusFrame::buildReadRequest(uint8_t slaveAddr, uint16_t startAddr, uint16_t numRegs, FrameBuffer &out)
+{
+    out.size = 0;
+    out.data[out.size++] = slaveAddr;
+    out.data[out.size++] = 0x03; // Function code for Read Holding Registers
+    put16(out, startAddr);
+    put16(out, numRegs);
+    appendCRC(out);
+}
+
+void ModbusFrame::buildWriteSingleRequest(uint8_t slaveAddr, uint16_t regAddr, uint16_t regValue, FrameBuffer &out)
+{
+    out.size = 0;
+    out.data[out.size++] = slaveAddr;
+    out.data[out.size++] = 0x06; // Function code for Write Single Register
+    put16(out, regAddr);
+    put16(out, regValue);
+    appendCRC(out);
+}
+
+bool ModbusFrame::buildWriteMultipleRequest(uint8_t slaveAddr, uint16_t startAddr, const uint16_t *values,
+                                            uint16_t count, FrameBuffer &out)
+{
+    if (count == 0 || count > MODBUS_MAX_WRITE_REGISTERS)
+        return false;
+    out.size = 0;
+    out.data[out.size++] = slaveAddr;
+    out.data[out.size++] = 0x10; // Function code for Write Multiple Registers
+    put16(out, startAddr);
+    put16(out, count);
+    out.data[out.size++] = static_cast<uint8_t>(count * 2);
+    for (uint16_t i = 0; i < count; ++i)
+        put16(out, values[i]);
+    appendCRC(out);
+    return true;
+}
+
+bool ModbusFrame::buildReadWriteMultipleRequest(uint8_t slaveAddr, uint16_t readAddr, uint16_t readCount,
+                                                uint16_t writeAddr, const uint16_t *values, uint16_t writeCount,
+                                                FrameBuffer &out)
+{
+    if (readCount == 0 || readCount > MODBUS_MAX_READ_REGISTERS || writeCount == 0 ||
+        writeCount > MODBUS_MAX_READ_WRITE_REGISTERS)
+        return false;
+    out.size = 0;
+    out.data[out.size++] = slaveAddr;
+    out.data[out.size++] = 0x17; // Function code for Read/Write Multiple Registers
+    put16(out, readAddr);
+    put16(out, readCount);
+    put16(out, writeAddr);
+    put16(out, writeCount);
+    out.data[out.size++] = static_cast<uint8_t>(writeCount * 2);
+    for (uint16_t i = 0; i < writeCount; ++i)
+        put16(out, values[i]);
+    appendCRC(out);
+    return true;
+}
+
+void ModbusFrame::appendCRC(FrameBuffer &frame)
+{
+    uint16_t crc = ModbusCRC::compute(frame.data, frame.size);
+    frame.data[frame.size++] = static_cast<uint8_t>(crc & 0xFF);
+    frame.data[frame.size++] = static_cast<uint8_t>((crc >> 8) & 0xFF);
+}
+
+uint16_t ModbusFrame::receivedCRC(const uint8_t *frame, size_t len)
+{
+    return static_cast<uint16_t>(frame[len - 2] | (frame[len - 1] << 8));
+}
+
+void ModbusFrame::encodeHex(const uint8_t *data, size_t len, char *out)
+{
+    for (size_t i = 0; i < len; ++i)
+    {
+        *out++ = HEX_DIGITS[data[i] >> 4];
+        *out++ = HEX_DIGITS[data[i] & 0x0F];
+    }
+    *out = '\0';
+}
+
+void ModbusFrame::encodeHex(const FrameBuffer &frame, HexFrame &out)
+{
+    encodeHex(frame.data, frame.size, out.data);
+    out.size = frame.size * 2;
+}
+
+bool ModbusFrame::decodeHex(const char *hex, size_t hexLen, uint8_t *out, size_t capacity, size_t &outLen)
+{
+    if (hexLen % 2 != 0 || hexLen / 2 > capacity)
+        return false;
+    const uint8_t *table = HEX_DECODE.value;
+    for (size_t i = 0; i < hexLen; i += 2)
+    {
+        uint8_t hi = table[static_cast<uint8_t>(hex[i])];
+        uint8_t lo = table[static_cast<uint8_t>(hex[i + 1])];
+        if ((hi | lo) & 0xF0)
+            return false;
+        out[i / 2] = static_cast<uint8_t>((hi << 4) | lo);
+    }
+    outLen = hexLen / 2;
+    return true;
+}
+
+bool ModbusFrame::decodeHex(const char *hex, size_t hexLen, FrameBuffer &out)
+{
+    return decodeHex(hex, hexLen, out.data, sizeof(out.data), out.size);
+}
+
+// ========== RTU stream framing ==========
+bool ModbusFrame::rtuRequestLength(const uint8_t *data, size_t size, size_t &length)
+{
+    length = 0;
+    if (size < 2)
+        return true;
+    switch (data[1])
+    {
+    case 0x01: // Read coils / inputs / registers, write single coil / register
+    case 0x02:
+    case 0x03:
+    case 0x04:
+    case 0x05:
+    case 0x06:
+        length = 8;
+        return true;
+    case 0x0F: // Write multiple coils / registers: byte count at offset 6
+    case 0x10:
+        if (size >= 7)
+            length = 9u + data[6];
+        return true;
+    case 0x17: // Read/write multiple registers: byte count at offset 10
+        if (size >= 11)
+            length = 13u + data[10];
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool ModbusFrame::rtuResponseLength(const uint8_t *data, size_t size, size_t &length)
+{
+    length = 0;
+    if (size < 3)
+        return true;
+    if (data[1] & 0x80)
+    {
+        length = 5; // Exception: slave, function | 0x80, code, CRC
+        return true;
+    }
+    switch (data[1])
+    {
+    case 0x01: // Byte count at offset 2
+    case 0x02:
+    case 0x03:
+    case 0x04:
+    case 0x17:
+        length = 5u + data[2];
+        return true;
+    case 0x05: // Echo of address and value / quantity
+    case 0x06:
+    case 0x0F:
+    case 0x10:
+        length = 8;
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool ModbusFrame::isWriteMultipleEcho(const FrameBuffer &request, const uint8_t *frame, size_t len)
+{
+    // slave, function, start address, quantity, CRC
+    return len == 8 && request.size >= 6 && std::memcmp(frame, request.data, 6) == 0;
+}
+
+bool ModbusFrame::parseReadResponse(const uint8_t *frame, size_t len, uint16_t numRegs, uint16_t *values)
+{
+    // slave, function, byte count, data, CRC
+    size_t dataBytes = static_cast<size_t>(numRegs) * 2;
+    if (numRegs == 0 || len < 3 + dataBytes + 2 || frame[2] != dataBytes)
+        return false;
+    const uint8_t *p = frame + 3;
+    for (uint16_t i = 0; i < numRegs; ++i, p += 2)
+        values[i] = static_cast<uint16_t>((p[0] << 8) | p[1]);
+    return true;
+}
@@ -0,0 +1,75 @@
+#ifndef MODBUS_FRAME_H
+#define MODBUS_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Largest Modbus RTU application data unit (slave + PDU + CRC)
+static const size_t MODBUS_MAX_ADU = 256;
+
+// Registers per request allowed by the Modbus application protocol
+static const uint16_t MODBUS_MAX_READ_REGISTERS = 125;       // FC03, read part of FC23
+static const uint16_t MODBUS_MAX_WRITE_REGISTERS = 123;      // FC16
+static const uint16_t MODBUS_MAX_READ_WRITE_REGISTERS = 121; // Write part of FC23
+
+// Binary RTU frame held on the stack
+struct FrameBuffer
+{
+    uint8_t data[MODBUS_MAX_ADU];
+    size_t size = 0;
+};
+
+// Hex text of an RTU frame as exchanged with the API, NUL-terminated
+struct HexFrame
+{
+    char data[MODBUS_MAX_ADU * 2 + 1];
+    size_t size = 0;
+};
+
+// Allocation-free Modbus RTU frame codec. Frames are built into and parsed
+// from fixed-size buffers; hex conversion uses lookup tables.
+class ModbusFrame
+{
+public:
+    // Request builders, CRC included
+    static void buildReadRequest(uint8_t slaveAddr, uint16_t startAddr, uint16_t numRegs, FrameBuffer &out);
+    static void buildWriteSingleRequest(uint8_t slaveAddr, uint16_t regAddr, uint16_t regValue, FrameBuffer &out);
+    // Write Multiple Registers (FC16); false when count is outside 1..MODBUS_MAX_WRITE_REGISTERS
+    static bool buildWriteMultipleRequest(uint8_t slaveAddr, uint16_t startAddr, const uint16_t *values, uint16_t count,
+                                          FrameBuffer &out);
+    // Read/Write Multiple Registers (FC23); the device writes before it reads.
+    // False when a count is outside the protocol limits.
+    static bool buildReadWriteMultipleRequest(uint8_t slaveAddr, uint16_t readAddr, uint16_t readCount,
+                                              uint16_t writeAddr, const uint16_t *values, uint16_t writeCount,
+                                              FrameBuffer &out);
+
+    // Append the CRC of the current contents
+    static void appendCRC(FrameBuffer &frame);
+    // CRC carried in the last two bytes (little-endian)
+    static uint16_t receivedCRC(const uint8_t *frame, size_t len);
+
+    // Lower-case hex encoding, writes 2 * len characters plus a terminating NUL
+    static void encodeHex(const uint8_t *data, size_t len, char *out);
+    static void encodeHex(const FrameBuffer &frame, HexFrame &out);
+
+    // Returns false on odd length, non-hex characters or overflow
+    static bool decodeHex(const char *hex, size_t hexLen, uint8_t *out, size_t capacity, size_t &outLen);
+    static bool decodeHex(const char *hex, size_t hexLen, FrameBuffer &out);
+
+    // Total length of a raw RTU frame from its leading bytes, for stream
+    // transports that carry no length field. length is 0 while more bytes are
+    // needed; false for a function code whose framing is unknown.
+    static bool rtuRequestLength(const uint8_t *data, size_t size, size_t &length);
+    static bool rtuResponseLength(const uint8_t *data, size_t size, size_t &length);
+
+    // A Write Multiple Registers (FC16) response echoes the request's
+    // slave, function, start address and quantity
+    static bool isWriteMultipleEcho(const FrameBuffer &request, const uint8_t *frame, size_t len);
+
+    // Decode the register values of a Read Holding Registers (FC03) or
+    // Read/Write Multiple Registers (FC23) response.
+    // The byte count must match numRegs; CRC and exception checks are the caller's.
+    static bool parseReadResponse(const uint8_t *frame, size_t len, uint16_t numRegs, uint16_t *values);
+};
+
+#endif
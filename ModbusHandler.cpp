@@ -1,30 +1,91 @@
 #include "ModbusHandler.h"
+#include "ModbusCRC.h"
+#include "Config.h"
 #include <iostream>
 #include <vector>
-#include <sstream>
-#include <iomanip>
 #include <cstdint>
-#include <algorithm>
-#include <cctype>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
 
-ModbusHandler::ModbusHandler() : adapter_() {}
+ModbusHandler::ModbusHandler()
+    : transport_(Transport::create(Transport::endpointFromConfig())), retryPolicy_(std::make_shared<RetryPolicy>(RetryPolicy::settingsFromConfig())),
+      coalescer_(MODBUS_MAX_READ_REGISTERS), coalesceReads_(Config::getInstance().getTransportCoalesceReads())
+{
+    Config &config = Config::getInstance();
+    setCircuitBreaker(config.getBreakerFailureThreshold(), std::chrono::milliseconds(config.getBreakerCooldownMs()));
+}
+
+ModbusHandler::ModbusHandler(const Endpoint &endpoint)
+    : transport_(Transport::create(endpoint)), retryPolicy_(std::make_shared<RetryPolicy>(RetryPolicy::settingsFromConfig())),
+      coalescer_(MODBUS_MAX_READ_REGISTERS), coalesceReads_(Config::getInstance().getTransportCoalesceReads())
+{
+    Config &config = Config::getInstance();
+    setCircuitBreaker(config.getBreakerFailureThreshold(), std::chrono::milliseconds(config.getBreakerCooldownMs()));
+}
+
+void ModbusHandler::setReadCoalescing(bool enabled)
+{
+    coalesceReads_ = enabled;
+}
+
+// ========== Retry policy and circuit breaker ==========
+void ModbusHandler::setRetryPolicy(std::shared_ptr<const RetryPolicy> policy)
+{
+    if (policy)
+        std::atomic_store(&retryPolicy_, std::move(policy));
+}
+
+void ModbusHandler::setCircuitBreaker(unsigned failureThreshold, std::chrono::milliseconds cooldown)
+{
+    for (auto &breaker : breakers_)
+        breaker.configure(failureThreshold, cooldown);
+}
+
+bool ModbusHandler::isCircuitOpen(uint8_t slaveAddr) const
+{
+    return breakers_[slaveAddr].isOpen();
+}
+
+// Requests to a device whose breaker is open fail fast without touching the network
+bool ModbusHandler::admitRequest(uint8_t slaveAddr, RequestType type)
+{
+    if (breakers_[slaveAddr].allowRequest())
+        return true;
+    Metrics::getInstance().recordRejected(slaveAddr, type);
+    return false;
+}
+
+void ModbusHandler::finishRequest(uint8_t slaveAddr, RequestType type, AttemptOutcome outcome,
+                                  uint8_t exceptionCode, std::chrono::steady_clock::time_point started)
+{
+    bool ok = outcome == AttemptOutcome::SUCCESS;
+    Metrics::getInstance().recordRequest(slaveAddr, type, ok, Metrics::elapsedUs(started));
+
+    // A non-retryable exception still proves the device is alive
+    CircuitBreaker &breaker = breakers_[slaveAddr];
+    if (ok || !policy()->isRetryable(outcome, exceptionCode))
+        breaker.recordSuccess();
+    else if (breaker.recordFailure())
+        std::cerr << "Circuit breaker open for slave 0x" << std::hex << (int)slaveAddr << std::dec
+                  << ": pausing requests for " << breaker.cooldown().count() << " ms\n";
+}
+
+std::shared_ptr<const RetryPolicy> ModbusHandler::policy() const
+{
+    return std::atomic_load(&retryPolicy_);
+}
 
 // ========== Modbus CRC-16 ===========
 uint16_t ModbusHandler::calculateCRC(const std::vector<uint8_t> &data)
 {
-    uint16_t crc = 0xFFFF;
-    for (size_t i = 0; i < data.size(); ++i)
-    {
-        crc ^= data[i];
-        for (int j = 0; j < 8; ++j)
-        {
-            if (crc & 0x0001)
-                crc = (crc >> 1) ^ 0xA001;
-            else
-                crc >>= 1;
-        }
-    }
-    return crc;
+    return ModbusCRC::compute(data.data(), data.size());
+}
+
+uint16_t ModbusHandler::calculateCRC(const uint8_t *data, size_t len)
+{
+    return ModbusCRC::compute(data, len);
 }
 
 // ========== Error Code Handling ==========
@@ -55,182 +116,382 @@ std::string ModbusHandler::modbusExceptionMessage(uint8_t code)
     }
 }
 
-// Helper: Build Modbus Read Holding Registers frame
-std::string ModbusHandler::buildReadFrame(uint8_t slaveAddr, uint16_t startAddr, uint16_t numRegs)
+// Verify the CRC and exception status of a response frame
+AttemptOutcome ModbusHandler::checkFrame(const FrameBuffer &frame, int attempt, uint8_t &exceptionCode)
 {
-    std::vector<uint8_t> frame = {
-        slaveAddr,
-        0x03,
-        static_cast<uint8_t>(startAddr >> 8),
-        static_cast<uint8_t>(startAddr & 0xFF),
-        static_cast<uint8_t>(numRegs >> 8),
-        static_cast<uint8_t>(numRegs & 0xFF)};
-    uint16_t crc = calculateCRC(frame);
-    frame.push_back(crc & 0xFF);
-    frame.push_back((crc >> 8) & 0xFF);
-    std::ostringstream oss;
-    for (auto b : frame)
-        oss << std::hex << std::setw(2) << std::setfill('0') << (int)b;
-    return oss.str();
+    if (frame.size < 4)
+    {
+        std::cerr << "Malformed frame (attempt " << attempt << ")\n";
+        return AttemptOutcome::PARSE_FAILURE;
+    }
+    // CRC check
+    uint16_t receivedCRC = ModbusFrame::receivedCRC(frame.data, frame.size);
+    uint16_t calcCRC = calculateCRC(frame.data, frame.size - 2);
+    if (receivedCRC != calcCRC)
+    {
+        std::cerr << "CRC error: received " << std::hex << receivedCRC << ", calculated " << calcCRC << std::dec << " (attempt " << attempt << ")\n";
+        return AttemptOutcome::CRC_ERROR;
+    }
+    // Modbus error code handling
+    if (frame.size >= 5 && (frame.data[1] & 0x80))
+    {
+        uint8_t excCode = frame.data[2];
+        exceptionCode = excCode;
+        std::cerr << "Modbus Exception: Code 0x" << std::hex << (int)excCode << ": " << modbusExceptionMessage(excCode) << std::dec << " (attempt " << attempt << ")\n";
+        return AttemptOutcome::MODBUS_EXCEPTION;
+    }
+    return AttemptOutcome::SUCCESS;
 }
 
-// Helper: Build Modbus Write Single Register frame
-std::string ModbusHandler::buildWriteFrame(uint8_t slaveAddr, uint16_t regAddr, uint16_t regValue)
+// Validate a read response and decode its registers, logging the failure reason
+AttemptOutcome ModbusHandler::checkReadResponse(const FrameBuffer &resp, uint16_t numRegs,
+                                                std::vector<uint16_t> &values, int attempt, uint8_t &exceptionCode)
 {
-    std::vector<uint8_t> frame = {
-        slaveAddr,
-        0x06, // Function code for Write Single Register
-        static_cast<uint8_t>(regAddr >> 8),
-        static_cast<uint8_t>(regAddr & 0xFF),
-        static_cast<uint8_t>(regValue >> 8),
-        static_cast<uint8_t>(regValue & 0xFF)};
-    uint16_t crc = calculateCRC(frame);
-    frame.push_back(crc & 0xFF);
-    frame.push_back((crc >> 8) & 0xFF);
-    std::ostringstream oss;
-    for (auto b : frame)
-        oss << std::hex << std::setw(2) << std::setfill('0') << (int)b;
-    return oss.str();
+    if (resp.size < 4)
+    {
+        std::cerr << "Malformed or blank response (attempt " << attempt << ")\n";
+        return AttemptOutcome::PARSE_FAILURE;
+    }
+    AttemptOutcome outcome = checkFrame(resp, attempt, exceptionCode);
+    if (outcome != AttemptOutcome::SUCCESS)
+        return outcome;
+    // Parse values (resize keeps the caller's capacity, so reused vectors do not allocate)
+    values.resize(numRegs);
+    if (ModbusFrame::parseReadResponse(resp.data, resp.size, numRegs, values.data()))
+        return AttemptOutcome::SUCCESS;
+    values.clear();
+    std::cerr << "Failed to parse register values (attempt " << attempt << ")\n";
+    return AttemptOutcome::PARSE_FAILURE;
 }
 
-// Helper: Parse Modbus Read response (returns vector of register values)
-std::vector<uint16_t> parseReadResponse(const std::string &resp, int numRegs)
+// Validate a write response: FC06 echoes the whole request, FC16 its address and quantity
+AttemptOutcome ModbusHandler::checkWriteResponse(const FrameBuffer &request, const FrameBuffer &resp, int attempt,
+                                                 uint8_t &exceptionCode)
 {
-    std::vector<uint16_t> regs;
-    if (resp.size() < 6 + static_cast<size_t>(numRegs) * 4)
-        return regs;
-    for (int i = 0; i < numRegs; ++i)
+    if (resp.size == 0)
     {
-        int idx = 6 + i * 4;
-        uint16_t val = static_cast<uint16_t>(std::stoi(resp.substr(idx, 4), nullptr, 16));
-        regs.push_back(val);
+        std::cerr << "Blank response to write (attempt " << attempt << ")\n";
+        return AttemptOutcome::PARSE_FAILURE;
     }
-    return regs;
+    AttemptOutcome outcome = checkFrame(resp, attempt, exceptionCode);
+    if (outcome != AttemptOutcome::SUCCESS)
+        return outcome;
+    bool echoed = request.data[1] == 0x10
+                      ? ModbusFrame::isWriteMultipleEcho(request, resp.data, resp.size)
+                      : resp.size == request.size && std::memcmp(resp.data, request.data, resp.size) == 0;
+    if (echoed)
+        return AttemptOutcome::SUCCESS;
+    std::cerr << "Write response mismatch (attempt " << attempt << ")\n";
+    return AttemptOutcome::PARSE_FAILURE;
 }
 
 // Dynamic register read with retry, CRC, error code handling
 bool ModbusHandler::readRegisters(uint16_t startAddr, uint16_t numRegs, std::vector<uint16_t> &values, uint8_t slaveAddr)
 {
-    std::string resp;
-    std::string req = buildReadFrame(slaveAddr, startAddr, numRegs);
-    int attempts = 0;
-    while (attempts < 3)
-    {
-        if (!adapter_.sendReadRequest(req, resp))
-        {
-            std::cerr << "Read request failed (attempt " << (attempts + 1) << ")\n";
-            attempts++;
-            continue;
-        }
-        if (resp.empty() || resp.size() < 8)
-        {
-            std::cerr << "Malformed or blank response (attempt " << (attempts + 1) << ")\n";
-            attempts++;
-            continue;
-        }
-        // CRC check
-        std::vector<uint8_t> frameBytes;
-        for (size_t i = 0; i < resp.size(); i += 2)
-        {
-            frameBytes.push_back(static_cast<uint8_t>(std::stoi(resp.substr(i, 2), nullptr, 16)));
-        }
-        if (frameBytes.size() < 4)
-        {
-            std::cerr << "Malformed frame (attempt " << (attempts + 1) << ")\n";
-            attempts++;
-            continue;
-        }
-        uint16_t receivedCRC = static_cast<uint16_t>(frameBytes[frameBytes.size() - 2] | (frameBytes[frameBytes.size() - 1] << 8));
-        uint16_t calcCRC = calculateCRC(std::vector<uint8_t>(frameBytes.begin(), frameBytes.end() - 2));
-        if (receivedCRC != calcCRC)
-        {
-            std::cerr << "CRC error: received " << std::hex << receivedCRC << ", calculated " << calcCRC << std::dec << " (attempt " << (attempts + 1) << ")\n";
-            attempts++;
-            continue;
-        }
-        // Modbus error code handling
-        if (frameBytes.size() >= 5 && (frameBytes[1] & 0x80))
-        {
-            uint8_t excCode = frameBytes[2];
-            std::cerr << "Modbus Exception: Code 0x" << std::hex << (int)excCode << ": " << modbusExceptionMessage(excCode) << std::dec << " (attempt " << (attempts + 1) << ")\n";
-            attempts++;
-            continue;
-        }
-        // Parse values
-        values = parseReadResponse(resp, numRegs);
-        if (!values.empty())
-            return true;
-        std::cerr << "Failed to parse register values (attempt " << (attempts + 1) << ")\n";
-        attempts++;
+    // Invalid counts go straight to the device so they fail as before
+    if (!coalesceReads_ || numRegs == 0 || numRegs > MODBUS_MAX_READ_REGISTERS)
+        return readDirect(startAddr, numRegs, values, slaveAddr);
+
+    // Either this thread is handed a flight to read itself, or the flight it
+    // joined completes on another thread
+    struct SyncRead
+    {
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::shared_ptr<ReadCoalescer::Flight> lead;
+        bool done = false;
+        bool ok = false;
+        std::vector<uint16_t> values;
+    };
+    auto state = std::make_shared<SyncRead>();
+    coalescer_.read(slaveAddr, startAddr, numRegs, [state](bool ok, const std::vector<uint16_t> &result)
+                    {
+                        std::lock_guard<std::mutex> lock(state->mutex);
+                        state->ok = ok;
+                        state->values = result;
+                        state->done = true;
+                        state->wake.notify_all(); },
+                    [state](const std::shared_ptr<ReadCoalescer::Flight> &flight)
+                    {
+                        std::lock_guard<std::mutex> lock(state->mutex);
+                        state->lead = flight;
+                        state->wake.notify_all(); });
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->wake.wait(lock, [&state]()
+                     { return state->done || state->lead; });
+    if (state->lead)
+    {
+        // The flight keeps its launcher, which references state: drop the cycle
+        std::shared_ptr<ReadCoalescer::Flight> flight = std::move(state->lead);
+        lock.unlock();
+        std::vector<uint16_t> result;
+        bool ok = readDirect(flight->start, flight->count, result, flight->slave);
+        coalescer_.complete(flight, ok, result);
+        lock.lock();
     }
-    return false;
+    values.swap(state->values);
+    return state->ok;
+}
+
+bool ModbusHandler::readDirect(uint16_t startAddr, uint16_t numRegs, std::vector<uint16_t> &values, uint8_t slaveAddr)
+{
+    FrameBuffer request, response;
+    ModbusFrame::buildReadRequest(slaveAddr, startAddr, numRegs, request);
+
+    if (!admitRequest(slaveAddr, RequestType::READ))
+        return false;
+
+    Metrics &metrics = Metrics::getInstance();
+    std::shared_ptr<const RetryPolicy> retry = policy();
+    auto started = std::chrono::steady_clock::now();
+    AttemptOutcome outcome;
+    uint8_t exceptionCode;
+    for (int attempt = 1;; ++attempt)
+    {
+        auto attemptStarted = std::chrono::steady_clock::now();
+        outcome = AttemptOutcome::TRANSPORT_FAILURE;
+        exceptionCode = 0;
+        if (!transport_->transact(RequestType::READ, request, response))
+            std::cerr << "Read request failed (attempt " << attempt << ")\n";
+        else
+            outcome = checkReadResponse(response, numRegs, values, attempt, exceptionCode);
+        metrics.recordAttempt(slaveAddr, RequestType::READ, outcome, Metrics::elapsedUs(attemptStarted));
+
+        // Back off before retrying instead of hammering a busy device
+        std::chrono::milliseconds delay;
+        if (outcome == AttemptOutcome::SUCCESS ||
+            !retry->nextRetry(attempt, outcome, exceptionCode, started, delay))
+            break;
+        std::this_thread::sleep_for(delay);
+    }
+    finishRequest(slaveAddr, RequestType::READ, outcome, exceptionCode, started);
+    return outcome == AttemptOutcome::SUCCESS;
+}
+
+// Attempt loop shared by the write operations
+bool ModbusHandler::transactWithRetry(RequestType type, const FrameBuffer &request, const ResponseCheck &check)
+{
+    uint8_t slaveAddr = request.data[0];
+    if (!admitRequest(slaveAddr, type))
+        return false;
+
+    FrameBuffer response;
+    Metrics &metrics = Metrics::getInstance();
+    std::shared_ptr<const RetryPolicy> retry = policy();
+    auto started = std::chrono::steady_clock::now();
+    AttemptOutcome outcome;
+    uint8_t exceptionCode;
+    for (int attempt = 1;; ++attempt)
+    {
+        auto attemptStarted = std::chrono::steady_clock::now();
+        outcome = AttemptOutcome::TRANSPORT_FAILURE;
+        exceptionCode = 0;
+        if (!transport_->transact(type, request, response))
+            std::cerr << (type == RequestType::WRITE ? "Write" : "Read") << " request failed (attempt " << attempt
+                      << ")\n";
+        else
+            outcome = check(response, attempt, exceptionCode);
+        metrics.recordAttempt(slaveAddr, type, outcome, Metrics::elapsedUs(attemptStarted));
+
+        std::chrono::milliseconds delay;
+        if (outcome == AttemptOutcome::SUCCESS ||
+            !retry->nextRetry(attempt, outcome, exceptionCode, started, delay))
+            break;
+        std::this_thread::sleep_for(delay);
+    }
+    finishRequest(slaveAddr, type, outcome, exceptionCode, started);
+    return outcome == AttemptOutcome::SUCCESS;
 }
 
 // Write single register with retry, CRC, error code handling
 bool ModbusHandler::writeRegister(uint16_t regAddr, uint16_t regValue, uint8_t slaveAddr)
 {
-    std::string resp;
-    std::string req = buildWriteFrame(slaveAddr, regAddr, regValue);
+    FrameBuffer request;
+    ModbusFrame::buildWriteSingleRequest(slaveAddr, regAddr, regValue, request);
+    bool ok = transactWithRetry(RequestType::WRITE, request, [this, &request](const FrameBuffer &resp, int attempt, uint8_t &exceptionCode)
+                                { return checkWriteResponse(request, resp, attempt, exceptionCode); });
+    coalescer_.invalidate(slaveAddr, regAddr, 1);
+    return ok;
+}
 
-    auto normalize_hex = [](std::string s)
+// Write a block of registers in one transaction
+bool ModbusHandler::writeRegisters(uint16_t startAddr, const std::vector<uint16_t> &values, uint8_t slaveAddr)
+{
+    FrameBuffer request;
+    if (values.size() > MODBUS_MAX_WRITE_REGISTERS ||
+        !ModbusFrame::buildWriteMultipleRequest(slaveAddr, startAddr, values.data(),
+                                                static_cast<uint16_t>(values.size()), request))
     {
-        s.erase(std::remove_if(s.begin(), s.end(),
-                               [](unsigned char c)
-                               { return std::isspace(c); }),
-                s.end());
-        std::transform(s.begin(), s.end(), s.begin(),
-                       [](unsigned char c)
-                       { return static_cast<char>(std::toupper(c)); });
-        return s;
-    };
+        std::cerr << "Invalid register count for a multiple write: " << values.size() << "\n";
+        return false;
+    }
+    bool ok = transactWithRetry(RequestType::WRITE, request, [this, &request](const FrameBuffer &resp, int attempt, uint8_t &exceptionCode)
+                                { return checkWriteResponse(request, resp, attempt, exceptionCode); });
+    coalescer_.invalidate(slaveAddr, startAddr, static_cast<uint16_t>(values.size()));
+    return ok;
+}
 
-    int attempts = 0;
-    while (attempts < 3)
-    {
-        if (!adapter_.sendWriteRequest(req, resp))
-        {
-            std::cerr << "Write request failed (attempt " << (attempts + 1) << ")\n";
-            attempts++;
-            continue;
-        }
-        if (resp.empty())
-        {
-            std::cerr << "Blank response to write (attempt " << (attempts + 1) << ")\n";
-            attempts++;
-            continue;
-        }
-        // CRC check
-        std::vector<uint8_t> frameBytes;
-        for (size_t i = 0; i < resp.size(); i += 2)
-        {
-            frameBytes.push_back(static_cast<uint8_t>(std::stoi(resp.substr(i, 2), nullptr, 16)));
-        }
-        if (frameBytes.size() < 4)
-        {
-            std::cerr << "Malformed frame (attempt " << (attempts + 1) << ")\n";
-            attempts++;
-            continue;
-        }
-        uint16_t receivedCRC = static_cast<uint16_t>(frameBytes[frameBytes.size() - 2] | (frameBytes[frameBytes.size() - 1] << 8));
-        uint16_t calcCRC = calculateCRC(std::vector<uint8_t>(frameBytes.begin(), frameBytes.end() - 2));
-        if (receivedCRC != calcCRC)
-        {
-            std::cerr << "CRC error: received " << std::hex << receivedCRC << ", calculated " << calcCRC << std::dec << " (attempt " << (attempts + 1) << ")\n";
-            attempts++;
-            continue;
-        }
-        // Modbus error code handling
-        if (frameBytes.size() >= 5 && (frameBytes[1] & 0x80))
-        {
-            uint8_t excCode = frameBytes[2];
-            std::cerr << "Modbus Exception: Code 0x" << std::hex << (int)excCode << ": " << modbusExceptionMessage(excCode) << std::dec << " (attempt " << (attempts + 1) << ")\n";
-            attempts++;
-            continue;
-        }
-        if (normalize_hex(resp) == normalize_hex(req))
-            return true;
-        std::cerr << "Write response mismatch (attempt " << (attempts + 1) << ")\n";
-        attempts++;
+// Write one block and read another in one transaction; counted as a write
+bool ModbusHandler::readWriteRegisters(uint16_t readAddr, uint16_t readCount, std::vector<uint16_t> &readValues,
+                                       uint16_t writeAddr, const std::vector<uint16_t> &writeValues, uint8_t slaveAddr)
+{
+    FrameBuffer request;
+    if (writeValues.size() > MODBUS_MAX_READ_WRITE_REGISTERS ||
+        !ModbusFrame::buildReadWriteMultipleRequest(slaveAddr, readAddr, readCount, writeAddr, writeValues.data(),
+                                                    static_cast<uint16_t>(writeValues.size()), request))
+    {
+        std::cerr << "Invalid register count for a read/write: read " << readCount << ", write "
+                  << writeValues.size() << "\n";
+        return false;
     }
-    return false;
+    bool ok = transactWithRetry(RequestType::WRITE, request, [this, readCount, &readValues](const FrameBuffer &resp, int attempt, uint8_t &exceptionCode)
+                                { return checkReadResponse(resp, readCount, readValues, attempt, exceptionCode); });
+    coalescer_.invalidate(slaveAddr, writeAddr, static_cast<uint16_t>(writeValues.size()));
+    return ok;
+}
+
+// ========== Asynchronous operations ==========
+// Each attempt is resubmitted from the completion callback, so no thread blocks
+void ModbusHandler::readAttempt(std::shared_ptr<const FrameBuffer> req, uint8_t slaveAddr, uint16_t numRegs,
+                                int attempt, std::chrono::steady_clock::time_point started,
+                                std::chrono::milliseconds delay, ReadCallback callback)
+{
+    auto attemptStarted = std::chrono::steady_clock::now() + delay;
+    transport_->transactAsync(RequestType::READ, *req, [this, req, slaveAddr, numRegs, attempt, started, attemptStarted, callback](bool ok, const FrameBuffer &resp)
+                              {
+                                  std::vector<uint16_t> values;
+                                  AttemptOutcome outcome = AttemptOutcome::TRANSPORT_FAILURE;
+                                  uint8_t exceptionCode = 0;
+                                  if (!ok)
+                                      std::cerr << "Read request failed (attempt " << attempt << ")\n";
+                                  else
+                                      outcome = checkReadResponse(resp, numRegs, values, attempt, exceptionCode);
+                                  Metrics::getInstance().recordAttempt(slaveAddr, RequestType::READ, outcome,
+                                                                       Metrics::elapsedUs(attemptStarted));
+
+                                  // The backoff is a delayed submission, so the event loop never sleeps
+                                  std::chrono::milliseconds retryDelay;
+                                  if (outcome != AttemptOutcome::SUCCESS &&
+                                      policy()->nextRetry(attempt, outcome, exceptionCode, started, retryDelay))
+                                  {
+                                      readAttempt(req, slaveAddr, numRegs, attempt + 1, started, retryDelay, callback);
+                                      return;
+                                  }
+                                  finishRequest(slaveAddr, RequestType::READ, outcome, exceptionCode, started);
+                                  callback(outcome == AttemptOutcome::SUCCESS, values); },
+                              delay);
+}
+
+void ModbusHandler::writeAttempt(std::shared_ptr<const FrameBuffer> req, int attempt,
+                                 std::chrono::steady_clock::time_point started,
+                                 std::chrono::milliseconds delay, WriteCallback callback)
+{
+    auto attemptStarted = std::chrono::steady_clock::now() + delay;
+    transport_->transactAsync(RequestType::WRITE, *req, [this, req, attempt, started, attemptStarted, callback](bool ok, const FrameBuffer &resp)
+                              {
+                                  AttemptOutcome outcome = AttemptOutcome::TRANSPORT_FAILURE;
+                                  uint8_t exceptionCode = 0;
+                                  if (!ok)
+                                      std::cerr << "Write request failed (attempt " << attempt << ")\n";
+                                  else
+                                      outcome = checkWriteResponse(*req, resp, attempt, exceptionCode);
+                                  uint8_t slaveAddr = req->data[0];
+                                  Metrics::getInstance().recordAttempt(slaveAddr, RequestType::WRITE, outcome,
+                                                                       Metrics::elapsedUs(attemptStarted));
+
+                                  std::chrono::milliseconds retryDelay;
+                                  if (outcome != AttemptOutcome::SUCCESS &&
+                                      policy()->nextRetry(attempt, outcome, exceptionCode, started, retryDelay))
+                                  {
+                                      writeAttempt(req, attempt + 1, started, retryDelay, callback);
+                                      return;
+                                  }
+                                  finishRequest(slaveAddr, RequestType::WRITE, outcome, exceptionCode, started);
+                                  callback(outcome == AttemptOutcome::SUCCESS); },
+                              delay);
+}
+
+void ModbusHandler::readRegistersAsync(uint16_t startAddr, uint16_t numRegs, ReadCallback callback, uint8_t slaveAddr)
+{
+    if (!coalesceReads_ || numRegs == 0 || numRegs > MODBUS_MAX_READ_REGISTERS)
+    {
+        readDirectAsync(startAddr, numRegs, std::move(callback), slaveAddr);
+        return;
+    }
+    coalescer_.read(slaveAddr, startAddr, numRegs, std::move(callback),
+                    [this](const std::shared_ptr<ReadCoalescer::Flight> &flight)
+                    {
+                        readDirectAsync(flight->start, flight->count,
+                                        [this, flight](bool ok, const std::vector<uint16_t> &values)
+                                        { coalescer_.complete(flight, ok, values); },
+                                        flight->slave); });
+}
+
+void ModbusHandler::readDirectAsync(uint16_t startAddr, uint16_t numRegs, ReadCallback callback, uint8_t slaveAddr)
+{
+    if (!admitRequest(slaveAddr, RequestType::READ))
+    {
+        callback(false, std::vector<uint16_t>());
+        return;
+    }
+    auto req = std::make_shared<FrameBuffer>();
+    ModbusFrame::buildReadRequest(slaveAddr, startAddr, numRegs, *req);
+    readAttempt(req, slaveAddr, numRegs, 1, std::chrono::steady_clock::now(), std::chrono::milliseconds(0),
+                std::move(callback));
+}
+
+std::future<ReadResult> ModbusHandler::readRegistersAsync(uint16_t startAddr, uint16_t numRegs, uint8_t slaveAddr)
+{
+    auto promise = std::make_shared<std::promise<ReadResult>>();
+    std::future<ReadResult> future = promise->get_future();
+    readRegistersAsync(startAddr, numRegs, [promise](bool ok, const std::vector<uint16_t> &values)
+                       {
+                           ReadResult result;
+                           result.ok = ok;
+                           result.values = values;
+                           promise->set_value(std::move(result)); },
+                       slaveAddr);
+    return future;
+}
+
+void ModbusHandler::writeRegisterAsync(uint16_t regAddr, uint16_t regValue, WriteCallback callback, uint8_t slaveAddr)
+{
+    if (!admitRequest(slaveAddr, RequestType::WRITE))
+    {
+        callback(false);
+        return;
+    }
+    auto req = std::make_shared<FrameBuffer>();
+    ModbusFrame::buildWriteSingleRequest(slaveAddr, regAddr, regValue, *req);
+    writeAttempt(req, 1, std::chrono::steady_clock::now(), std::chrono::milliseconds(0),
+                 [this, slaveAddr, regAddr, callback](bool ok)
+                 {
+                     coalescer_.invalidate(slaveAddr, regAddr, 1);
+                     callback(ok); });
+}
+
+void ModbusHandler::writeRegistersAsync(uint16_t startAddr, const std::vector<uint16_t> &values,
+                                        WriteCallback callback, uint8_t slaveAddr)
+{
+    auto req = std::make_shared<FrameBuffer>();
+    if (values.size() > MODBUS_MAX_WRITE_REGISTERS ||
+        !ModbusFrame::buildWriteMultipleRequest(slaveAddr, startAddr, values.data(),
+                                                static_cast<uint16_t>(values.size()), *req))
+    {
+        std::cerr << "Invalid register count for a multiple write: " << values.size() << "\n";
+        callback(false);
+        return;
+    }
+    if (!admitRequest(slaveAddr, RequestType::WRITE))
+    {
+        callback(false);
+        return;
+    }
+    uint16_t count = static_cast<uint16_t>(values.size());
+    writeAttempt(req, 1, std::chrono::steady_clock::now(), std::chrono::milliseconds(0),
+                 [this, slaveAddr, startAddr, count, callback](bool ok)
+                 {
+                     coalescer_.invalidate(slaveAddr, startAddr, count);
+                     callback(ok); });
 }
@@ -2,29 +2,107 @@
 #define MODBUS_HANDLER_H
 
 #include <cstdint>
-#include "ProtocolAdapter.h"
+#include "Transport.h"
+#include "ModbusFrame.h"
+#include "Metrics.h"
+#include "RetryPolicy.h"
+#include "ReadCoalescer.h"
+#include <atomic>
+#include <functional>
+#include <future>
+#include <memory>
 #include <vector>
 #include <string>
 
+// Completion callbacks for asynchronous operations (run on the transport thread)
+typedef std::function<void(bool ok, const std::vector<uint16_t> &values)> ReadCallback;
+typedef std::function<void(bool ok)> WriteCallback;
+
+struct ReadResult
+{
+    bool ok = false;
+    std::vector<uint16_t> values;
+};
+
 class ModbusHandler
 {
 public:
+    // Transport selected by endpoint.transport ([TRANSPORT] in config.ini by default)
     ModbusHandler();
+    explicit ModbusHandler(const Endpoint &endpoint);
 
-    // Core Modbus protocol operations
+    // Core Modbus protocol operations. Concurrent reads on one handler are
+    // single-flighted (see ReadCoalescer) unless coalescing is disabled.
     bool readRegisters(uint16_t startAddr, uint16_t numRegs, std::vector<uint16_t> &values, uint8_t slaveAddr = 0x11);
     bool writeRegister(uint16_t regAddr, uint16_t regValue, uint8_t slaveAddr = 0x11);
+    // Write Multiple Registers (FC16): all values in one transaction
+    bool writeRegisters(uint16_t startAddr, const std::vector<uint16_t> &values, uint8_t slaveAddr = 0x11);
+    // Read/Write Multiple Registers (FC23): the write is applied before the read
+    bool readWriteRegisters(uint16_t readAddr, uint16_t readCount, std::vector<uint16_t> &readValues,
+                            uint16_t writeAddr, const std::vector<uint16_t> &writeValues, uint8_t slaveAddr = 0x11);
+
+    // Asynchronous operations, many frames may be in flight at once.
+    // The handler must outlive all outstanding requests. A coalesced read's
+    // callback may also run on the thread that led the shared read.
+    void readRegistersAsync(uint16_t startAddr, uint16_t numRegs, ReadCallback callback, uint8_t slaveAddr = 0x11);
+    std::future<ReadResult> readRegistersAsync(uint16_t startAddr, uint16_t numRegs, uint8_t slaveAddr = 0x11);
+    void writeRegisterAsync(uint16_t regAddr, uint16_t regValue, WriteCallback callback, uint8_t slaveAddr = 0x11);
+    void writeRegistersAsync(uint16_t startAddr, const std::vector<uint16_t> &values, WriteCallback callback,
+                             uint8_t slaveAddr = 0x11);
+
+    // Retry behaviour; the default policy and breaker come from [RETRY] in config.ini
+    void setRetryPolicy(std::shared_ptr<const RetryPolicy> policy);
+    void setCircuitBreaker(unsigned failureThreshold, std::chrono::milliseconds cooldown);
+    // True while requests to the slave are being rejected after repeated failures
+    bool isCircuitOpen(uint8_t slaveAddr) const;
+
+    // Read single-flight; the default comes from [TRANSPORT] coalesce_reads
+    void setReadCoalescing(bool enabled);
+    const ReadCoalescer &readCoalescer() const { return coalescer_; }
 
     // CRC and error code helpers
     uint16_t calculateCRC(const std::vector<uint8_t> &data);
+    uint16_t calculateCRC(const uint8_t *data, size_t len);
     std::string modbusExceptionMessage(uint8_t code);
 
 private:
-    ProtocolAdapter adapter_;
+    std::unique_ptr<Transport> transport_;
+
+    // Swapped atomically so a policy change never races an in-flight retry
+    std::shared_ptr<const RetryPolicy> retryPolicy_;
+    CircuitBreaker breakers_[256]; // One per slave address
+    ReadCoalescer coalescer_;
+    std::atomic<bool> coalesceReads_;
+
+    std::shared_ptr<const RetryPolicy> policy() const;
+    bool admitRequest(uint8_t slaveAddr, RequestType type);
+    void finishRequest(uint8_t slaveAddr, RequestType type, AttemptOutcome outcome, uint8_t exceptionCode,
+                       std::chrono::steady_clock::time_point started);
+
+    // Response validation shared by the blocking and asynchronous paths,
+    // classified so failures can be counted by cause
+    // (exceptionCode is set for Modbus exceptions)
+    AttemptOutcome checkFrame(const FrameBuffer &frame, int attempt, uint8_t &exceptionCode);
+    AttemptOutcome checkReadResponse(const FrameBuffer &resp, uint16_t numRegs, std::vector<uint16_t> &values,
+                                     int attempt, uint8_t &exceptionCode);
+    AttemptOutcome checkWriteResponse(const FrameBuffer &request, const FrameBuffer &resp, int attempt,
+                                      uint8_t &exceptionCode);
+
+    // Blocking attempt loop with backoff and metrics for requests other than
+    // plain reads; check validates each response
+    typedef std::function<AttemptOutcome(const FrameBuffer &resp, int attempt, uint8_t &exceptionCode)> ResponseCheck;
+    bool transactWithRetry(RequestType type, const FrameBuffer &request, const ResponseCheck &check);
+
+    // Reads that always send their own request
+    bool readDirect(uint16_t startAddr, uint16_t numRegs, std::vector<uint16_t> &values, uint8_t slaveAddr);
+    void readDirectAsync(uint16_t startAddr, uint16_t numRegs, ReadCallback callback, uint8_t slaveAddr);
 
-    // Helper functions
-    std::string buildReadFrame(uint8_t slaveAddr, uint16_t startAddr, uint16_t numRegs);
-    std::string buildWriteFrame(uint8_t slaveAddr, uint16_t regAddr, uint16_t regValue);
+    void readAttempt(std::shared_ptr<const FrameBuffer> req, uint8_t slaveAddr, uint16_t numRegs, int attempt,
+                     std::chrono::steady_clock::time_point started, std::chrono::milliseconds delay,
+                     ReadCallback callback);
+    void writeAttempt(std::shared_ptr<const FrameBuffer> req, int attempt,
+                      std::chrono::steady_clock::time_point started, std::chrono::milliseconds delay,
+                      WriteCallback callback);
 };
 
 #endif
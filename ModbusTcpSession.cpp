@@ -0,0 +1,378 @@
+#include "ModbusTcpSession.h"
+#include "TcpTransport.h"
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace
+{
+    const size_t MBAP_HEADER = 7; // Transaction, protocol, length, unit id
+}
+
+ModbusTcpSession::ModbusTcpSession(const std::string &host, uint16_t port, size_t window, long timeoutMs)
+    : host_(host), port_(port), window_(window > 0 ? window : 1), timeoutMs_(timeoutMs),
+      inFlightCount_(0), peakInFlight_(0), connects_(0), timeouts_(0), stale_(0)
+{
+    wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    loop_ = std::thread(&ModbusTcpSession::run, this);
+}
+
+ModbusTcpSession::~ModbusTcpSession()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake();
+    if (loop_.joinable())
+        loop_.join();
+
+    // Nothing is dropped silently: everything still queued or on the wire fails
+    for (auto &entry : inFlight_)
+        entry.second.request.callback(false, FrameBuffer());
+    for (Request &request : pending_)
+        request.callback(false, FrameBuffer());
+    for (auto &entry : delayed_)
+        entry.second.callback(false, FrameBuffer());
+
+    if (fd_ >= 0)
+        ::close(fd_);
+    if (wakeFd_ >= 0)
+        ::close(wakeFd_);
+}
+
+// ========== Submission ==========
+void ModbusTcpSession::submit(const FrameBuffer &request, FrameCallback callback, std::chrono::milliseconds delay)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!stopping_)
+        {
+            if (delay.count() > 0)
+                delayed_.emplace(Clock::now() + delay, Request{request, std::move(callback), false});
+            else
+                pending_.push_back(Request{request, std::move(callback), false});
+            callback = nullptr;
+        }
+    }
+    if (callback)
+    {
+        callback(false, FrameBuffer());
+        return;
+    }
+    wake();
+}
+
+bool ModbusTcpSession::transact(const FrameBuffer &request, FrameBuffer &response)
+{
+    std::mutex mutex;
+    std::condition_variable doneWake;
+    bool done = false;
+    bool result = false;
+
+    submit(request, [&](bool ok, const FrameBuffer &resp)
+           {
+               std::lock_guard<std::mutex> lock(mutex);
+               result = ok;
+               if (ok)
+                   response = resp;
+               done = true;
+               doneWake.notify_one(); });
+
+    std::unique_lock<std::mutex> lock(mutex);
+    doneWake.wait(lock, [&]()
+                  { return done; });
+    return result;
+}
+
+void ModbusTcpSession::wake()
+{
+    uint64_t one = 1;
+    if (::write(wakeFd_, &one, sizeof(one)) < 0 && errno != EAGAIN)
+        std::cerr << "Failed to wake Modbus TCP session: " << std::strerror(errno) << "\n";
+}
+
+// ========== Event loop ==========
+void ModbusTcpSession::run()
+{
+    while (true)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_)
+                break;
+        }
+
+        Clock::time_point now = Clock::now();
+        promoteDelayed(now);
+        sendPending(now);
+        if (fd_ >= 0 && !output_.empty() && !flushOutput())
+            dropConnection(true);
+
+        pollfd fds[2];
+        fds[0] = pollfd{wakeFd_, POLLIN, 0};
+        fds[1] = pollfd{fd_, static_cast<short>(POLLIN | (output_.empty() ? 0 : POLLOUT)), 0};
+        int ready = ::poll(fds, fd_ >= 0 ? 2 : 1, nextTimeoutMs(now));
+        if (ready < 0 && errno != EINTR)
+        {
+            std::cerr << "Modbus TCP session poll failed: " << std::strerror(errno) << "\n";
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        if (ready > 0 && (fds[0].revents & POLLIN))
+        {
+            uint64_t count;
+            while (::read(wakeFd_, &count, sizeof(count)) > 0)
+            {
+            }
+        }
+        if (ready > 0 && fd_ >= 0)
+        {
+            if ((fds[1].revents & POLLOUT) && !flushOutput())
+                dropConnection(true);
+            if (fd_ >= 0 && (fds[1].revents & (POLLIN | POLLERR | POLLHUP)) && !receiveResponses())
+                dropConnection(peerClosed_);
+        }
+        expireTransactions(Clock::now());
+    }
+}
+
+void ModbusTcpSession::promoteDelayed(Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    while (!delayed_.empty() && delayed_.begin()->first <= now)
+    {
+        pending_.push_back(std::move(delayed_.begin()->second));
+        delayed_.erase(delayed_.begin());
+    }
+}
+
+int ModbusTcpSession::nextTimeoutMs(Clock::time_point now)
+{
+    Clock::time_point next = Clock::time_point::max();
+    for (const auto &entry : inFlight_)
+        next = std::min(next, entry.second.deadline);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!pending_.empty() && inFlight_.size() < window_)
+            return 0;
+        if (!delayed_.empty())
+            next = std::min(next, delayed_.begin()->first);
+    }
+    if (next == Clock::time_point::max())
+        return -1;
+    if (next <= now)
+        return 0;
+    // Rounded up so the loop never wakes just before a deadline
+    auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(next - now) + std::chrono::milliseconds(1);
+    return static_cast<int>(std::min<long long>(wait.count(), 60000));
+}
+
+// ========== Sending ==========
+void ModbusTcpSession::sendPending(Clock::time_point now)
+{
+    while (inFlight_.size() < window_)
+    {
+        Request request;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (pending_.empty())
+                return;
+            request = std::move(pending_.front());
+            pending_.pop_front();
+        }
+
+        if (request.frame.size < 4)
+        {
+            request.callback(false, FrameBuffer());
+            continue;
+        }
+        if (fd_ < 0)
+        {
+            fd_ = TcpTransport::openConnection(host_, port_, timeoutMs_);
+            if (fd_ < 0)
+            {
+                // The gateway is unreachable: everything waiting fails now instead of timing out
+                request.callback(false, FrameBuffer());
+                failPending();
+                return;
+            }
+            ::fcntl(fd_, F_SETFL, ::fcntl(fd_, F_GETFL, 0) | O_NONBLOCK);
+            connects_++;
+        }
+
+        // Skip ids still waiting for their response after a wrap-around
+        do
+            transactionId_++;
+        while (inFlight_.count(transactionId_));
+
+        // MBAP header followed by unit id + PDU, i.e. the RTU frame without its CRC
+        size_t unitAndPdu = request.frame.size - 2;
+        output_.push_back(static_cast<uint8_t>(transactionId_ >> 8));
+        output_.push_back(static_cast<uint8_t>(transactionId_ & 0xFF));
+        output_.push_back(0); // Protocol id: Modbus
+        output_.push_back(0);
+        output_.push_back(static_cast<uint8_t>(unitAndPdu >> 8));
+        output_.push_back(static_cast<uint8_t>(unitAndPdu & 0xFF));
+        output_.insert(output_.end(), request.frame.data, request.frame.data + unitAndPdu);
+
+        Clock::time_point deadline = timeoutMs_ > 0 ? now + std::chrono::milliseconds(timeoutMs_)
+                                                    : Clock::time_point::max();
+        inFlight_.emplace(transactionId_, Transaction{std::move(request), now, deadline});
+        inFlightCount_ = inFlight_.size();
+        if (inFlight_.size() > peakInFlight_)
+            peakInFlight_ = inFlight_.size();
+    }
+}
+
+bool ModbusTcpSession::flushOutput()
+{
+    size_t written = 0;
+    while (written < output_.size())
+    {
+        ssize_t sent = ::send(fd_, output_.data() + written, output_.size() - written, MSG_NOSIGNAL);
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (sent <= 0)
+        {
+            output_.clear();
+            return false;
+        }
+        written += static_cast<size_t>(sent);
+    }
+    output_.erase(output_.begin(), output_.begin() + written);
+    return true;
+}
+
+void ModbusTcpSession::failPending()
+{
+    std::deque<Request> failed;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        failed.swap(pending_);
+    }
+    for (Request &request : failed)
+        request.callback(false, FrameBuffer());
+}
+
+// ========== Receiving ==========
+bool ModbusTcpSession::receiveResponses()
+{
+    uint8_t chunk[4096];
+    peerClosed_ = false;
+    while (true)
+    {
+        ssize_t got = ::recv(fd_, chunk, sizeof(chunk), 0);
+        if (got < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (got <= 0)
+        {
+            peerClosed_ = got == 0 || errno == ECONNRESET;
+            return false;
+        }
+        input_.insert(input_.end(), chunk, chunk + got);
+        lastReceive_ = Clock::now();
+    }
+
+    size_t offset = 0;
+    while (input_.size() - offset >= MBAP_HEADER)
+    {
+        const uint8_t *header = input_.data() + offset;
+        uint16_t transaction = static_cast<uint16_t>((header[0] << 8) | header[1]);
+        uint16_t protocol = static_cast<uint16_t>((header[2] << 8) | header[3]);
+        size_t length = static_cast<size_t>((header[4] << 8) | header[5]); // Unit id + PDU
+        if (protocol != 0 || length < 2 || length + 2 > MODBUS_MAX_ADU)
+        {
+            std::cerr << "Invalid MBAP header from Modbus gateway\n";
+            input_.clear();
+            return false;
+        }
+        if (input_.size() - offset < 6 + length)
+            break;
+
+        FrameBuffer response;
+        std::memcpy(response.data, header + 6, length);
+        response.size = length;
+        offset += 6 + length;
+
+        // A response must belong to an outstanding request of the same unit and function
+        auto it = inFlight_.find(transaction);
+        if (it == inFlight_.end() || response.data[0] != it->second.request.frame.data[0] ||
+            (response.data[1] & 0x7F) != it->second.request.frame.data[1])
+        {
+            stale_++;
+            continue;
+        }
+
+        // TCP already guarantees integrity; the CRC keeps the frame in RTU form for the handler
+        ModbusFrame::appendCRC(response);
+        FrameCallback callback = std::move(it->second.request.callback);
+        inFlight_.erase(it);
+        inFlightCount_ = inFlight_.size();
+        callback(true, response);
+    }
+    input_.erase(input_.begin(), input_.begin() + offset);
+    return true;
+}
+
+void ModbusTcpSession::expireTransactions(Clock::time_point now)
+{
+    bool unresponsive = false;
+    for (auto it = inFlight_.begin(); it != inFlight_.end();)
+    {
+        if (it->second.deadline > now)
+        {
+            ++it;
+            continue;
+        }
+        // Nothing at all came back since this was sent: the gateway, not one slave, is stuck
+        if (lastReceive_ < it->second.sent)
+            unresponsive = true;
+        FrameCallback callback = std::move(it->second.request.callback);
+        it = inFlight_.erase(it);
+        inFlightCount_ = inFlight_.size();
+        timeouts_++;
+        callback(false, FrameBuffer());
+    }
+    if (unresponsive && fd_ >= 0)
+        dropConnection(false);
+}
+
+void ModbusTcpSession::dropConnection(bool resendLost)
+{
+    if (fd_ >= 0)
+        ::close(fd_);
+    fd_ = -1;
+    output_.clear();
+    input_.clear();
+
+    // Requests the gateway dropped unanswered (typically an idle connection it
+    // closed) are sent once more on a fresh connection; the rest fail
+    std::map<uint16_t, Transaction> lost;
+    lost.swap(inFlight_);
+    inFlightCount_ = 0;
+    std::vector<Request> resend;
+    for (auto &entry : lost)
+    {
+        Request &request = entry.second.request;
+        if (resendLost && !request.resent)
+        {
+            request.resent = true;
+            resend.push_back(std::move(request));
+        }
+        else
+            request.callback(false, FrameBuffer());
+    }
+    if (!resend.empty())
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_.insert(pending_.begin(), std::make_move_iterator(resend.begin()),
+                        std::make_move_iterator(resend.end()));
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef MODBUS_TCP_SESSION_H
+#define MODBUS_TCP_SESSION_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Transport.h"
+
+// Pipelined Modbus TCP connection to one gateway.
+//
+// Up to `window` transactions are outstanding on the socket at once. Each
+// request gets its own MBAP transaction id and responses are matched back by
+// it, so a multi-slave gateway may answer in any order. Every transaction
+// has its own deadline (timeoutMs); a response arriving after it is
+// discarded. A single event loop thread owns the socket, opens it on demand
+// and re-establishes it after the gateway has closed it. Requests beyond the
+// window wait in a FIFO queue.
+class ModbusTcpSession
+{
+public:
+    ModbusTcpSession(const std::string &host, uint16_t port, size_t window, long timeoutMs);
+    ~ModbusTcpSession();
+
+    ModbusTcpSession(const ModbusTcpSession &) = delete;
+    ModbusTcpSession &operator=(const ModbusTcpSession &) = delete;
+
+    // Queue an RTU request frame; the callback runs once on the event loop
+    // thread and must not block. A non-zero delay holds the request back.
+    void submit(const FrameBuffer &request, FrameCallback callback,
+                std::chrono::milliseconds delay = std::chrono::milliseconds(0));
+
+    // Blocking wrapper around submit()
+    bool transact(const FrameBuffer &request, FrameBuffer &response);
+
+    size_t window() const { return window_; }
+    size_t inFlight() const { return inFlightCount_; }
+    size_t peakInFlight() const { return peakInFlight_; }
+    uint64_t connectCount() const { return connects_; }
+    uint64_t timeoutCount() const { return timeouts_; } // Transactions past their deadline
+    uint64_t staleCount() const { return stale_; }      // Late or unmatched responses discarded
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    struct Request
+    {
+        FrameBuffer frame;
+        FrameCallback callback;
+        bool resent;
+    };
+
+    struct Transaction
+    {
+        Request request;
+        Clock::time_point sent;
+        Clock::time_point deadline;
+    };
+
+    void run();
+    void promoteDelayed(Clock::time_point now);
+    void sendPending(Clock::time_point now);
+    bool flushOutput();
+    bool receiveResponses();
+    void expireTransactions(Clock::time_point now);
+    void dropConnection(bool resendLost);
+    void failPending();
+    int nextTimeoutMs(Clock::time_point now);
+    void wake();
+
+    std::string host_;
+    uint16_t port_;
+    size_t window_;
+    long timeoutMs_;
+
+    // Shared with submitters
+    std::mutex mutex_;
+    std::deque<Request> pending_;
+    std::multimap<Clock::time_point, Request> delayed_;
+    bool stopping_ = false;
+    int wakeFd_ = -1; // eventfd interrupting the loop's poll()
+
+    // Owned by the event loop thread
+    int fd_ = -1;
+    uint16_t transactionId_ = 0;
+    std::map<uint16_t, Transaction> inFlight_;
+    std::vector<uint8_t> output_; // Encoded requests not yet written
+    std::vector<uint8_t> input_;  // Received bytes not yet framed
+    bool peerClosed_ = false;     // The last receive failure was the gateway closing
+    Clock::time_point lastReceive_;
+
+    std::atomic<size_t> inFlightCount_;
+    std::atomic<size_t> peakInFlight_;
+    std::atomic<uint64_t> connects_;
+    std::atomic<uint64_t> timeouts_;
+    std::atomic<uint64_t> stale_;
+    std::thread loop_;
+};
+
+#endif
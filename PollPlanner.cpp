@@ -0,0 +1,173 @@
+#include "PollPlanner.h"
+#include "Inverter.h"
+#include "RegisterCodec.h"
+#include <algorithm>
+#include <future>
+#include <iostream>
+
+PollPlanner::PollPlanner(const PollingConfig &config, uint16_t maxGap, uint16_t maxBlockSize)
+    : config_(config), maxGap_(maxGap), maxBlockSize_(maxBlockSize == 0 ? 1 : maxBlockSize) {}
+
+std::vector<ReadBlock> PollPlanner::plan(const std::set<ParameterType> &params) const
+{
+    // Sort the requested parameters by register address
+    std::vector<const ParameterConfig *> sorted;
+    for (auto param : params)
+    {
+        const ParameterConfig &config = config_.getParameterConfig(param);
+        if (config.available)
+            sorted.push_back(&config);
+    }
+    std::sort(sorted.begin(), sorted.end(),
+              [](const ParameterConfig *a, const ParameterConfig *b)
+              { return a->registerAddress < b->registerAddress; });
+
+    std::vector<ReadBlock> blocks;
+    for (const ParameterConfig *param : sorted)
+    {
+        uint16_t addr = param->registerAddress;
+        uint16_t width = registerWidth(param->format);
+        if (!blocks.empty())
+        {
+            ReadBlock &last = blocks.back();
+            uint32_t end = static_cast<uint32_t>(last.startAddr) + last.numRegs; // One past the last register
+            uint32_t newSize = std::max<uint32_t>(end, static_cast<uint32_t>(addr) + width) - last.startAddr;
+            // Registers already covered (several parameters share them) or close enough to extend the block
+            if ((addr < end || addr - end <= maxGap_) && newSize <= maxBlockSize_)
+            {
+                last.numRegs = static_cast<uint16_t>(newSize);
+                last.fields.push_back(BlockField{param->type, static_cast<uint16_t>(addr - last.startAddr),
+                                                 param->format, param->gain});
+                continue;
+            }
+        }
+        blocks.push_back(ReadBlock{addr, width, {BlockField{param->type, 0, param->format, param->gain}}, {}, {}, 0});
+    }
+    for (ReadBlock &block : blocks)
+        compileRuns(block);
+    return blocks;
+}
+
+// Fields are in address order; a run continues while the next field follows
+// directly in both the registers and the Sample slots with the same format
+void PollPlanner::compileRuns(ReadBlock &block)
+{
+    block.runs.clear();
+    block.scales.clear();
+    block.mask = 0;
+    for (const BlockField &field : block.fields)
+    {
+        uint8_t slot = static_cast<uint8_t>(parameterIndex(field.type));
+        block.mask |= parameterBit(field.type);
+        if (!block.runs.empty())
+        {
+            DecodeRun &run = block.runs.back();
+            if (run.format == field.format && field.offset == run.offset + run.count * registerWidth(run.format) &&
+                slot == run.slot + run.count)
+            {
+                run.count++;
+                block.scales.push_back(1.0f / field.gain);
+                continue;
+            }
+        }
+        block.runs.push_back(DecodeRun{field.offset, 1, static_cast<uint16_t>(block.scales.size()), slot, field.format});
+        block.scales.push_back(1.0f / field.gain);
+    }
+}
+
+std::vector<ReadBlock> PollPlanner::plan(ParameterMask params) const
+{
+    std::set<ParameterType> selected;
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+    {
+        if (params & (1u << i))
+            selected.insert(static_cast<ParameterType>(i));
+    }
+    return plan(selected);
+}
+
+const std::vector<ReadBlock> &PollPlanner::planFor(ParameterMask params)
+{
+    auto it = plans_.find(params);
+    if (it == plans_.end())
+        it = plans_.emplace(params, plan(params)).first;
+    return it->second;
+}
+
+const std::vector<ReadBlock> &PollPlanner::currentPlan()
+{
+    return planFor(config_.getEnabledMask());
+}
+
+void PollPlanner::decodeBlock(const ReadBlock &block, const std::vector<uint16_t> &values, Sample &sample)
+{
+    for (const DecodeRun &run : block.runs)
+    {
+        if (run.offset >= values.size())
+            continue;
+        // A short response only yields the values it fully contains
+        size_t count = std::min<size_t>(run.count, (values.size() - run.offset) / registerWidth(run.format));
+        decodeRun(run.format, &values[run.offset], &block.scales[run.scaleIndex], count, &sample.values[run.slot]);
+        sample.present |= static_cast<ParameterMask>(((1u << count) - 1) << run.slot);
+    }
+}
+
+void PollPlanner::reportFailure(const ReadBlock &block) const
+{
+    for (const auto &field : block.fields)
+        std::cerr << "Failed to read " << config_.getParameterConfig(field.type).name << std::endl;
+}
+
+bool PollPlanner::execute(Inverter &inverter, Sample &sample)
+{
+    return execute(inverter, sample, config_.getEnabledMask());
+}
+
+bool PollPlanner::execute(Inverter &inverter, Sample &sample, ParameterMask params)
+{
+    const auto &blocks = planFor(params);
+    ModbusHandler &modbus = inverter.getModbusHandler();
+    uint8_t slave = inverter.getSlaveAddress();
+    uint64_t generation = inverter.writeGeneration();
+    bool allSuccess = true;
+
+    if (blocks.size() == 1)
+    {
+        std::vector<uint16_t> values;
+        if (modbus.readRegisters(blocks[0].startAddr, blocks[0].numRegs, values, slave))
+        {
+            decodeBlock(blocks[0], values, sample);
+            inverter.cacheValues(sample, blocks[0].mask, generation);
+        }
+        else
+        {
+            reportFailure(blocks[0]);
+            allSuccess = false;
+        }
+        return allSuccess;
+    }
+
+    // Several blocks: put them all in flight at once instead of one after another
+    std::vector<std::future<ReadResult>> pending;
+    pending.reserve(blocks.size());
+    for (const auto &block : blocks)
+        pending.push_back(modbus.readRegistersAsync(block.startAddr, block.numRegs, slave));
+
+    ParameterMask decoded = 0;
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        ReadResult result = pending[i].get();
+        if (result.ok)
+        {
+            decodeBlock(blocks[i], result.values, sample);
+            decoded |= blocks[i].mask;
+        }
+        else
+        {
+            reportFailure(blocks[i]);
+            allSuccess = false;
+        }
+    }
+    inverter.cacheValues(sample, decoded, generation);
+    return allSuccess;
+}
@@ -0,0 +1,83 @@
+#ifndef POLL_PLANNER_H
+#define POLL_PLANNER_H
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <vector>
+#include "PollingConfig.h"
+
+class Inverter;
+
+// A parameter decoded from a position inside a block read
+struct BlockField
+{
+    ParameterType type;
+    uint16_t offset; // Register offset from the block start
+    RegisterFormat format;
+    float gain;
+};
+
+// Consecutive values of one format that land in consecutive Sample slots,
+// decoded by a single batch kernel
+struct DecodeRun
+{
+    uint16_t offset;     // Register offset of the first value
+    uint16_t count;      // Values in the run
+    uint16_t scaleIndex; // First of count reciprocal gains in ReadBlock::scales
+    uint8_t slot;        // Sample slot of the first value
+    RegisterFormat format;
+};
+
+// One FC03 read covering one or more enabled parameters
+struct ReadBlock
+{
+    uint16_t startAddr;
+    uint16_t numRegs;
+    std::vector<BlockField> fields;
+    std::vector<DecodeRun> runs; // Decode program compiled from fields by plan()
+    std::vector<float> scales;
+    ParameterMask mask; // Parameters decoded from the block
+};
+
+// Coalesces the enabled parameters of a PollingConfig into the minimum set of
+// contiguous holding-register reads and decodes every value from the results.
+class PollPlanner
+{
+public:
+    // maxGap: unused registers tolerated between two parameters in one block
+    // maxBlockSize: register limit per read (Modbus allows at most 125)
+    explicit PollPlanner(const PollingConfig &config, uint16_t maxGap = 0, uint16_t maxBlockSize = 125);
+
+    std::vector<ReadBlock> plan(const std::set<ParameterType> &params) const;
+    std::vector<ReadBlock> plan(ParameterMask params) const;
+
+    // Cached plan for a parameter subset, built on first use
+    const std::vector<ReadBlock> &planFor(ParameterMask params);
+
+    // Plan for the currently enabled parameters
+    const std::vector<ReadBlock> &currentPlan();
+
+    // Read all blocks for the given parameters (default: all enabled ones) and
+    // store the decoded values, also in the inverter's register cache. Returns
+    // false if any block failed; values of the other blocks are kept.
+    bool execute(Inverter &inverter, Sample &sample);
+    bool execute(Inverter &inverter, Sample &sample, ParameterMask params);
+
+    // Runs the block's decode program: one batch conversion per run, with the
+    // format resolved once per run and gains applied as reciprocals
+    static void decodeBlock(const ReadBlock &block, const std::vector<uint16_t> &values, Sample &sample);
+
+private:
+    const PollingConfig &config_;
+    uint16_t maxGap_;
+    uint16_t maxBlockSize_;
+
+    // Plans depend only on the parameter subset, so they never go stale
+    std::map<ParameterMask, std::vector<ReadBlock>> plans_;
+
+    void reportFailure(const ReadBlock &block) const;
+    static void compileRuns(ReadBlock &block);
+};
+
+#endif
@@ -0,0 +1,130 @@
+#include "PollScheduler.h"
+#include <iostream>
+#include <thread>
+
+static long long gcd(long long a, long long b)
+{
+    while (b != 0)
+    {
+        long long t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+PollScheduler::PollScheduler(const PollingConfig &config, std::chrono::milliseconds basePeriod, TimePoint start)
+    : config_(config),
+      basePeriod_(basePeriod.count() > 0 ? basePeriod : std::chrono::milliseconds(1)),
+      start_(start),
+      startEpochMs_(std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::system_clock::now().time_since_epoch() - (Clock::now() - start))
+                        .count()),
+      deadline_(start),
+      stop_(false),
+      overruns_(0),
+      skipped_(0)
+{
+    // Tick often enough to hit every parameter's period exactly
+    long long tick = basePeriod_.count();
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+    {
+        long long interval = config_.getParameterInterval(static_cast<ParameterType>(i)).count();
+        if (interval > 0)
+            tick = gcd(tick, interval);
+    }
+    tickPeriod_ = std::chrono::milliseconds(tick);
+    nextDue_.fill(start);
+}
+
+std::chrono::milliseconds PollScheduler::intervalOf(ParameterType param) const
+{
+    auto interval = config_.getParameterInterval(param);
+    return interval.count() > 0 ? interval : basePeriod_;
+}
+
+PollScheduler::TimePoint PollScheduler::nextDeadline() const
+{
+    return deadline_;
+}
+
+ParameterMask PollScheduler::takeDue()
+{
+    ParameterMask due = 0;
+    for (auto param : config_.getEnabledParameters())
+    {
+        size_t i = parameterIndex(param);
+        if (nextDue_[i] > deadline_)
+            continue;
+        due |= parameterBit(param);
+        // Next due time stays on the parameter's own grid, skipping missed periods
+        auto interval = intervalOf(param);
+        while (nextDue_[i] <= deadline_)
+            nextDue_[i] += interval;
+    }
+    return due;
+}
+
+bool PollScheduler::complete(TimePoint finishedAt)
+{
+    deadline_ += tickPeriod_;
+    if (finishedAt <= deadline_)
+        return true;
+
+    // Overrun: jump to the first deadline after finishedAt, keeping the phase
+    auto late = finishedAt - deadline_;
+    uint64_t missed = static_cast<uint64_t>(late / tickPeriod_) + 1;
+    deadline_ += tickPeriod_ * static_cast<long long>(missed);
+    overruns_++;
+    skipped_ += missed;
+    std::cerr << "Poll overrun: tick finished "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(late).count()
+              << " ms after the next deadline (period " << tickPeriod_.count() << " ms), skipping "
+              << missed << " tick(s)\n";
+    return false;
+}
+
+void PollScheduler::run(const TickFunction &tick)
+{
+    while (!stop_)
+    {
+        std::this_thread::sleep_until(deadline_);
+        if (stop_)
+            break;
+        TimePoint deadline = deadline_;
+        ParameterMask due = takeDue();
+        if (due != 0)
+            tick(deadline, due);
+        complete(Clock::now());
+    }
+}
+
+void PollScheduler::stop()
+{
+    stop_ = true;
+}
+
+long long PollScheduler::elapsedMs(TimePoint t) const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(t - start_).count();
+}
+
+long long PollScheduler::epochMs(TimePoint t) const
+{
+    return startEpochMs_ + elapsedMs(t);
+}
+
+std::chrono::milliseconds PollScheduler::tickPeriod() const
+{
+    return tickPeriod_;
+}
+
+uint64_t PollScheduler::overrunCount() const
+{
+    return overruns_;
+}
+
+uint64_t PollScheduler::skippedTicks() const
+{
+    return skipped_;
+}
@@ -0,0 +1,71 @@
+#ifndef POLL_SCHEDULER_H
+#define POLL_SCHEDULER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include "PollingConfig.h"
+
+// Fixed-rate poll scheduler working on absolute deadlines.
+//
+// Ticks fall on start + n * tickPeriod regardless of how long each poll takes,
+// so HTTP latency and retries no longer stretch the period. The tick period
+// is the greatest common divisor of the base poll interval and all
+// per-parameter intervals; each tick reports which parameters are due.
+// A tick that runs past the next deadline is counted as an overrun and the
+// missed ticks are skipped, keeping the original phase.
+// Per-parameter intervals are read from PollingConfig at construction.
+class PollScheduler
+{
+public:
+    typedef std::chrono::steady_clock Clock;
+    typedef Clock::time_point TimePoint;
+    typedef std::function<void(TimePoint deadline, ParameterMask due)> TickFunction;
+
+    PollScheduler(const PollingConfig &config, std::chrono::milliseconds basePeriod,
+                  TimePoint start = Clock::now());
+
+    // Deadline of the next tick
+    TimePoint nextDeadline() const;
+
+    // Enabled parameters due at the next deadline; advances their due times
+    ParameterMask takeDue();
+
+    // Report that the tick at nextDeadline() finished at finishedAt and move
+    // on to the following deadline. Returns false if the tick overran.
+    bool complete(TimePoint finishedAt);
+
+    // Sleep until each deadline and invoke tick, until stop() is called
+    void run(const TickFunction &tick);
+    void stop();
+
+    // Milliseconds from the scheduler start to t
+    long long elapsedMs(TimePoint t) const;
+    // Wall-clock time of t in milliseconds since the Unix epoch (sample
+    // timestamps). Deadlines stay evenly spaced: the wall clock is read once,
+    // at construction, so later clock adjustments do not shift them.
+    long long epochMs(TimePoint t) const;
+
+    std::chrono::milliseconds tickPeriod() const;
+    uint64_t overrunCount() const;
+    uint64_t skippedTicks() const;
+
+private:
+    const PollingConfig &config_;
+    std::chrono::milliseconds basePeriod_;
+    std::chrono::milliseconds tickPeriod_;
+    TimePoint start_;
+    long long startEpochMs_;
+    TimePoint deadline_;
+    std::array<TimePoint, PARAMETER_COUNT> nextDue_;
+
+    std::atomic<bool> stop_;
+    std::atomic<uint64_t> overruns_;
+    std::atomic<uint64_t> skipped_;
+
+    std::chrono::milliseconds intervalOf(ParameterType param) const;
+};
+
+#endif
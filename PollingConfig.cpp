@@ -1,84 +1,97 @@
 #include "PollingConfig.h"
-#include "Inverter.h"
+#include <cmath>
 #include <iostream>
+#include <stdexcept>
 
-PollingConfig::PollingConfig()
+namespace
 {
-    initializeParameterConfigs();
-    // Default polling configuration (voltage and current for backward compatibility)
-    enabledParams_ = {ParameterType::AC_VOLTAGE, ParameterType::AC_CURRENT};
-}
-
-void PollingConfig::initializeParameterConfigs()
-{
-    // Initialize available parameters
-    availableParams_[ParameterType::AC_VOLTAGE] = ParameterConfig(
-        ParameterType::AC_VOLTAGE, "AC_Voltage", "V",
-        [](Inverter &inv, float &val)
-        { return inv.getACVoltage(val); });
-
-    availableParams_[ParameterType::AC_CURRENT] = ParameterConfig(
-        ParameterType::AC_CURRENT, "AC_Current", "A",
-        [](Inverter &inv, float &val)
-        { return inv.getACCurrent(val); });
-
-    availableParams_[ParameterType::AC_FREQUENCY] = ParameterConfig(
-        ParameterType::AC_FREQUENCY, "AC_Frequency", "Hz",
-        [](Inverter &inv, float &val)
-        { return inv.getACFrequency(val); });
-
-    availableParams_[ParameterType::PV1_VOLTAGE] = ParameterConfig(
-        ParameterType::PV1_VOLTAGE, "PV1_Voltage", "V",
-        [](Inverter &inv, float &val)
-        { return inv.getPV1Voltage(val); });
-
-    availableParams_[ParameterType::PV2_VOLTAGE] = ParameterConfig(
-        ParameterType::PV2_VOLTAGE, "PV2_Voltage", "V",
-        [](Inverter &inv, float &val)
-        { return inv.getPV2Voltage(val); });
-
-    availableParams_[ParameterType::PV1_CURRENT] = ParameterConfig(
-        ParameterType::PV1_CURRENT, "PV1_Current", "A",
-        [](Inverter &inv, float &val)
-        { return inv.getPV1Current(val); });
-
-    availableParams_[ParameterType::PV2_CURRENT] = ParameterConfig(
-        ParameterType::PV2_CURRENT, "PV2_Current", "A",
-        [](Inverter &inv, float &val)
-        { return inv.getPV2Current(val); });
-
-    availableParams_[ParameterType::TEMPERATURE] = ParameterConfig(
-        ParameterType::TEMPERATURE, "Temperature", "°C",
-        [](Inverter &inv, float &val)
-        { return inv.getTemperature(val); });
-
-    availableParams_[ParameterType::EXPORT_POWER_PERCENT] = ParameterConfig(
-        ParameterType::EXPORT_POWER_PERCENT, "Export_Power_Percent", "%",
-        [](Inverter &inv, float &val)
-        {
-            int intVal;
-            bool result = inv.getExportPowerPercent(intVal);
-            val = static_cast<float>(intVal);
-            return result;
-        });
-
-    availableParams_[ParameterType::OUTPUT_POWER] = ParameterConfig(
-        ParameterType::OUTPUT_POWER, "Output_Power", "W",
-        [](Inverter &inv, float &val)
+    const char *const PARAMETER_NAMES[PARAMETER_COUNT] = {
+        "AC_Voltage", "AC_Current", "AC_Frequency", "PV1_Voltage", "PV2_Voltage",
+        "PV1_Current", "PV2_Current", "Temperature", "Export_Power_Percent", "Output_Power"};
+}
+
+const char *parameterName(ParameterType param)
+{
+    return PARAMETER_NAMES[parameterIndex(param)];
+}
+
+bool parameterFromName(const std::string &name, ParameterType &param)
+{
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+    {
+        if (name == PARAMETER_NAMES[i])
         {
-            int intVal;
-            bool result = inv.getOutputPower(intVal);
-            val = static_cast<float>(intVal);
-            return result;
-        });
+            param = static_cast<ParameterType>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parseDeadband(const std::string &text, Deadband &deadband)
+{
+    std::string number = text;
+    DeadbandMode mode = DeadbandMode::ABSOLUTE;
+    if (!number.empty() && number.back() == '%')
+    {
+        number.pop_back();
+        mode = DeadbandMode::PERCENT;
+    }
+    try
+    {
+        size_t used;
+        float threshold = std::stof(number, &used);
+        if (used != number.size() || !(threshold >= 0.0f) || !std::isfinite(threshold))
+            return false;
+        deadband.mode = mode;
+        deadband.threshold = threshold;
+        return true;
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+PollingConfig::PollingConfig() : PollingConfig(RegisterMap::getInstance()) {}
+
+PollingConfig::PollingConfig(const RegisterMap &registerMap)
+{
+    initializeParameterConfigs(registerMap);
+    // Default polling configuration (voltage and current for backward compatibility)
+    setParameters({ParameterType::AC_VOLTAGE, ParameterType::AC_CURRENT});
+}
+
+// Flat per-parameter table; parameters the map lacks stay unavailable
+void PollingConfig::initializeParameterConfigs(const RegisterMap &registerMap)
+{
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+    {
+        ParameterConfig &param = params_[i];
+        param.type = static_cast<ParameterType>(i);
+        param.name = PARAMETER_NAMES[i];
+
+        const RegisterDescriptor *reg = registerMap.find(param.name);
+        if (!reg || !reg->readable())
+            continue;
+        param.unit = reg->unit;
+        param.registerAddress = reg->address;
+        param.format = reg->format;
+        param.gain = reg->gain;
+        param.available = true;
+    }
 }
 
 void PollingConfig::addParameter(ParameterType param)
 {
-    if (availableParams_.find(param) != availableParams_.end())
+    if (params_[parameterIndex(param)].available)
     {
         enabledParams_.insert(param);
     }
+    else
+    {
+        std::cerr << "Warning: " << parameterName(param) << " is not in the register map" << std::endl;
+    }
 }
 
 void PollingConfig::removeParameter(ParameterType param)
@@ -100,9 +113,37 @@ const std::set<ParameterType> &PollingConfig::getEnabledParameters() const
     return enabledParams_;
 }
 
+ParameterMask PollingConfig::getEnabledMask() const
+{
+    ParameterMask mask = 0;
+    for (auto param : enabledParams_)
+        mask |= parameterBit(param);
+    return mask;
+}
+
+void PollingConfig::setParameterInterval(ParameterType param, std::chrono::milliseconds interval)
+{
+    intervals_[parameterIndex(param)] = interval;
+}
+
+std::chrono::milliseconds PollingConfig::getParameterInterval(ParameterType param) const
+{
+    return intervals_[parameterIndex(param)];
+}
+
+void PollingConfig::setParameterDeadband(ParameterType param, const Deadband &deadband)
+{
+    deadbands_[parameterIndex(param)] = deadband;
+}
+
+const Deadband &PollingConfig::getParameterDeadband(ParameterType param) const
+{
+    return deadbands_[parameterIndex(param)];
+}
+
 const ParameterConfig &PollingConfig::getParameterConfig(ParameterType param) const
 {
-    return availableParams_.at(param);
+    return params_[parameterIndex(param)];
 }
 
 void PollingConfig::printEnabledParameters() const
@@ -110,8 +151,19 @@ void PollingConfig::printEnabledParameters() const
     std::cout << "Enabled polling parameters:\n";
     for (auto param : enabledParams_)
     {
-        const auto &config = availableParams_.at(param);
-        std::cout << "  - " << config.name << " (" << config.unit << ")\n";
+        const auto &config = params_[parameterIndex(param)];
+        std::cout << "  - " << config.name << " (" << config.unit << ")";
+        if (getParameterInterval(param).count() > 0)
+            std::cout << " every " << getParameterInterval(param).count() << " ms";
+        const Deadband &deadband = getParameterDeadband(param);
+        if (deadband.enabled())
+        {
+            std::cout << ", deadband " << deadband.threshold
+                      << (deadband.mode == DeadbandMode::PERCENT ? "%" : config.unit);
+            if (deadband.heartbeat.count() > 0)
+                std::cout << ", heartbeat " << deadband.heartbeat.count() << " ms";
+        }
+        std::cout << "\n";
     }
 }
 
@@ -148,19 +200,37 @@ void PollingConfig::setThermalProfile()
                    ParameterType::OUTPUT_POWER});
 }
 
-// ================= Sample Implementation ==================
-void Sample::setValue(ParameterType param, float value)
+// ================= SampleBatch Implementation ==================
+void SampleBatch::append(const Sample &s)
+{
+    timestamps.push_back(s.timestamp);
+    masks.push_back(s.present);
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+        columns[i].push_back(s.values[i]);
+}
+
+Sample SampleBatch::at(size_t i) const
 {
-    values[param] = value;
+    Sample s;
+    s.timestamp = timestamps[i];
+    s.present = masks[i];
+    for (size_t p = 0; p < PARAMETER_COUNT; ++p)
+        s.values[p] = columns[p][i];
+    return s;
 }
 
-float Sample::getValue(ParameterType param) const
+void SampleBatch::reserve(size_t n)
 {
-    auto it = values.find(param);
-    return (it != values.end()) ? it->second : 0.0f;
+    timestamps.reserve(n);
+    masks.reserve(n);
+    for (auto &column : columns)
+        column.reserve(n);
 }
 
-bool Sample::hasValue(ParameterType param) const
+void SampleBatch::clear()
 {
-    return values.find(param) != values.end();
+    timestamps.clear();
+    masks.clear();
+    for (auto &column : columns)
+        column.clear();
 }
@@ -1,14 +1,13 @@
 #ifndef POLLING_CONFIG_H
 #define POLLING_CONFIG_H
 
-#include <map>
+#include <array>
+#include <chrono>
+#include <cstdint>
 #include <set>
 #include <string>
-#include <functional>
 #include <vector>
-
-// Forward declaration
-class Inverter;
+#include "RegisterMap.h"
 
 // ================= Polling Configuration ==================
 enum class ParameterType
@@ -25,32 +24,83 @@ enum class ParameterType
     OUTPUT_POWER
 };
 
+// ParameterType is dense, so per-parameter data can live in flat arrays
+static const size_t PARAMETER_COUNT = 10;
+static_assert(static_cast<size_t>(ParameterType::OUTPUT_POWER) + 1 == PARAMETER_COUNT,
+              "PARAMETER_COUNT must match ParameterType");
+
+// One bit per ParameterType
+typedef uint16_t ParameterMask;
+
+constexpr size_t parameterIndex(ParameterType param)
+{
+    return static_cast<size_t>(param);
+}
+
+constexpr ParameterMask parameterBit(ParameterType param)
+{
+    return static_cast<ParameterMask>(1u << parameterIndex(param));
+}
+
+// Register map name of a parameter, e.g. "AC_Voltage"
+const char *parameterName(ParameterType param);
+bool parameterFromName(const std::string &name, ParameterType &param);
+
+// Where and how a parameter is read, taken from the register map
 struct ParameterConfig
 {
-    ParameterType type;
+    ParameterType type = ParameterType::AC_VOLTAGE;
     std::string name;
     std::string unit;
-    std::function<bool(Inverter &, float &)> readFunction;
+    uint16_t registerAddress = 0; // First holding register of the value
+    RegisterFormat format = RegisterFormat::U16;
+    float gain = 1.0f; // Raw register value = value * gain
+    bool available = false; // The register map defines a readable register for it
+};
+
+// Report-by-exception threshold of a parameter, applied by DeadbandFilter
+enum class DeadbandMode : uint8_t
+{
+    NONE,     // Every polled value is kept
+    ABSOLUTE, // threshold is in the parameter's unit
+    PERCENT   // threshold is a percentage of the last reported value
+};
 
-    ParameterConfig() = default;
+struct Deadband
+{
+    DeadbandMode mode = DeadbandMode::NONE;
+    float threshold = 0.0f;
+    std::chrono::milliseconds heartbeat{0}; // Longest silence before a value is reported anyway, 0 = none
 
-    ParameterConfig(ParameterType t, const std::string &n, const std::string &u,
-                    std::function<bool(Inverter &, float &)> func)
-        : type(t), name(n), unit(u), readFunction(func) {}
+    bool enabled() const { return mode != DeadbandMode::NONE; }
 };
 
+// "0.5" is an absolute deadband, "2%" a relative one; false if malformed or negative
+bool parseDeadband(const std::string &text, Deadband &deadband);
+
 class PollingConfig
 {
 public:
+    // Parameter registers from RegisterMap::getInstance() ([REGISTERS] in config.ini)
     PollingConfig();
+    explicit PollingConfig(const RegisterMap &registerMap);
 
     void addParameter(ParameterType param);
     void removeParameter(ParameterType param);
     void setParameters(const std::vector<ParameterType> &params);
 
     const std::set<ParameterType> &getEnabledParameters() const;
+    ParameterMask getEnabledMask() const;
     const ParameterConfig &getParameterConfig(ParameterType param) const;
 
+    // Per-parameter polling period; zero (the default) means every poll cycle
+    void setParameterInterval(ParameterType param, std::chrono::milliseconds interval);
+    std::chrono::milliseconds getParameterInterval(ParameterType param) const;
+
+    // Per-parameter change detection; none (the default) keeps every value
+    void setParameterDeadband(ParameterType param, const Deadband &deadband);
+    const Deadband &getParameterDeadband(ParameterType param) const;
+
     void printEnabledParameters() const;
 
     // Predefined monitoring profiles for common use cases
@@ -60,23 +110,61 @@ public:
     void setThermalProfile();
 
 private:
-    std::map<ParameterType, ParameterConfig> availableParams_;
+    std::array<ParameterConfig, PARAMETER_COUNT> params_; // Indexed by ParameterType
     std::set<ParameterType> enabledParams_;
+    std::array<std::chrono::milliseconds, PARAMETER_COUNT> intervals_{};
+    std::array<Deadband, PARAMETER_COUNT> deadbands_{};
 
-    void initializeParameterConfigs();
+    void initializeParameterConfigs(const RegisterMap &registerMap);
 };
 
 // ================= Sample Structure ==================
+// Fixed-layout value type: one float slot per parameter plus a presence mask,
+// small enough to fit in a single cache line.
 struct Sample
 {
-    std::map<ParameterType, float> values;
-    long long timestamp;
+    std::array<float, PARAMETER_COUNT> values{};
+    ParameterMask present = 0;
+    long long timestamp = 0;
 
     Sample() = default;
 
-    void setValue(ParameterType param, float value);
-    float getValue(ParameterType param) const;
-    bool hasValue(ParameterType param) const;
+    void setValue(ParameterType param, float value)
+    {
+        values[parameterIndex(param)] = value;
+        present |= parameterBit(param);
+    }
+
+    float getValue(ParameterType param) const
+    {
+        return hasValue(param) ? values[parameterIndex(param)] : 0.0f;
+    }
+
+    bool hasValue(ParameterType param) const
+    {
+        return (present & parameterBit(param)) != 0;
+    }
+};
+
+static_assert(sizeof(Sample) <= 64, "Sample should fit in one cache line");
+
+// ================= Sample Batch ==================
+// Struct-of-arrays view of buffered samples: one contiguous column per
+// parameter (0 where the parameter was absent) for batch encoding.
+struct SampleBatch
+{
+    std::vector<long long> timestamps;
+    std::vector<ParameterMask> masks;
+    std::array<std::vector<float>, PARAMETER_COUNT> columns;
+
+    void append(const Sample &s);
+    Sample at(size_t i) const;
+    void reserve(size_t n);
+    void clear(); // Keeps capacity
+
+    size_t size() const { return timestamps.size(); }
+    bool empty() const { return timestamps.empty(); }
+    const std::vector<float> &column(ParameterType param) const { return columns[parameterIndex(param)]; }
 };
 
 #endif
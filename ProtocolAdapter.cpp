@@ -1,55 +1,68 @@
 #include "ProtocolAdapter.h"
 #include "Config.h"
+#include "CurlHandlePool.h"
+#include "JsonFrame.h"
 #include <curl/curl.h>
 #include <iostream>
+#include <map>
 #include <vector>
 #include <iomanip>
 
-// ========== CURL callback ==========
-static size_t write_callback(void *contents, size_t size, size_t nmemb, void *userp)
+// ========== Transport selection ==========
+TransportType parseTransportType(const std::string &name, TransportType fallback)
 {
-    ((std::string *)userp)->append((char *)contents, size * nmemb);
-    return size * nmemb;
+    if (name == "http")
+        return TransportType::HTTP;
+    if (name == "modbus_tcp")
+        return TransportType::MODBUS_TCP;
+    if (name == "rtu_over_tcp")
+        return TransportType::RTU_OVER_TCP;
+    return fallback;
+}
+
+const char *transportTypeName(TransportType type)
+{
+    switch (type)
+    {
+    case TransportType::HTTP:
+        return "http";
+    case TransportType::MODBUS_TCP:
+        return "modbus_tcp";
+    case TransportType::RTU_OVER_TCP:
+        return "rtu_over_tcp";
+    }
+    return "unknown";
 }
 
 // ========== Post JSON ==========
+// One-shot request on a fresh handle; ProtocolAdapter uses its handle pool instead
 bool post_json(const std::string &url, const std::string &apiKey,
-               const std::string &frameHex, std::string &outFrameHex)
+               const FrameBuffer &request, FrameBuffer &response)
 {
     CURL *curl = curl_easy_init();
     if (!curl)
         return false;
 
-    std::string readBuffer;
     struct curl_slist *headers = NULL;
     headers = curl_slist_append(headers, "Content-Type: application/json");
     headers = curl_slist_append(headers, ("Authorization: " + apiKey).c_str());
 
-    std::string body = "{\"frame\":\"" + frameHex + "\"}";
+    JsonFrameBody body;
+    body.build(request);
+    JsonFrameExtractor extractor(response);
 
     curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &readBuffer);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.data);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(body.size));
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, JsonFrameExtractor::curlWrite);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &extractor);
 
     CURLcode res = curl_easy_perform(curl);
     curl_easy_cleanup(curl);
     curl_slist_free_all(headers);
 
-    if (res != CURLE_OK)
-        return false;
-
-    auto pos = readBuffer.find("\"frame\":\"");
-    if (pos == std::string::npos)
-        return false;
-    pos += 9;
-    auto end = readBuffer.find("\"", pos);
-    if (end == std::string::npos)
-        return false;
-    outFrameHex = readBuffer.substr(pos, end - pos);
-
-    return true;
+    return res == CURLE_OK && extractor.found();
 }
 
 // ========== ProtocolAdapter methods ==========
@@ -59,8 +72,23 @@ ProtocolAdapter::ProtocolAdapter()
     {
         std::cerr << "Error: Failed to initialize ProtocolAdapter configuration" << std::endl;
     }
+    createPool();
+}
+
+ProtocolAdapter::ProtocolAdapter(const Endpoint &endpoint)
+    : apiKey_(endpoint.apiKey), readURL_(endpoint.readUrl), writeURL_(endpoint.writeUrl)
+{
+    createPool();
+}
+
+void ProtocolAdapter::createPool()
+{
+    Config &config = Config::getInstance();
+    pool_.reset(new CurlHandlePool(apiKey_, config.getHttpPoolSize(), config.getHttpTimeoutMs()));
 }
 
+ProtocolAdapter::~ProtocolAdapter() = default;
+
 bool ProtocolAdapter::initializeConfig()
 {
     Config &config = Config::getInstance();
@@ -82,12 +110,73 @@ bool ProtocolAdapter::initializeConfig()
     return !apiKey_.empty() && !readURL_.empty() && !writeURL_.empty();
 }
 
-bool ProtocolAdapter::sendReadRequest(const std::string &frameHex, std::string &outFrameHex)
+bool ProtocolAdapter::post(const std::string &url, const FrameBuffer &request, FrameBuffer &response)
+{
+    CurlHandlePool::Lease handle(*pool_);
+    if (!handle.get())
+        return false;
+
+    // The body is hex-encoded onto the stack and the response hex is decoded
+    // into the caller's frame as it arrives, so a request allocates nothing
+    JsonFrameBody body;
+    body.build(request);
+    JsonFrameExtractor extractor(response);
+
+    CURL *curl = handle->curl;
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.data);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(body.size));
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, JsonFrameExtractor::curlWrite);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &extractor);
+
+    if (curl_easy_perform(curl) != CURLE_OK)
+        return false;
+
+    return extractor.found();
+}
+
+bool ProtocolAdapter::sendReadRequest(const FrameBuffer &request, FrameBuffer &response)
+{
+    return post(readURL_, request, response);
+}
+
+bool ProtocolAdapter::sendWriteRequest(const FrameBuffer &request, FrameBuffer &response)
+{
+    return post(writeURL_, request, response);
+}
+
+// One event loop per API key, so a single thread drives every device's requests
+static std::shared_ptr<AsyncTransport> sharedAsyncTransport(const std::string &apiKey)
+{
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<AsyncTransport>> transports;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::shared_ptr<AsyncTransport> transport = transports[apiKey].lock();
+    if (!transport)
+    {
+        Config &config = Config::getInstance();
+        transport = std::make_shared<AsyncTransport>(apiKey, config.getHttpMaxInFlight(), config.getHttpTimeoutMs());
+        transports[apiKey] = transport;
+    }
+    return transport;
+}
+
+AsyncTransport &ProtocolAdapter::asyncTransport()
+{
+    std::call_once(asyncInit_, [this]()
+                   { async_ = sharedAsyncTransport(apiKey_); });
+    return *async_;
+}
+
+void ProtocolAdapter::sendReadRequestAsync(const FrameBuffer &request, TransportCallback callback,
+                                           std::chrono::milliseconds delay)
 {
-    return post_json(readURL_, apiKey_, frameHex, outFrameHex);
+    asyncTransport().submitAfter(delay, readURL_, request, std::move(callback));
 }
 
-bool ProtocolAdapter::sendWriteRequest(const std::string &frameHex, std::string &outFrameHex)
+void ProtocolAdapter::sendWriteRequestAsync(const FrameBuffer &request, TransportCallback callback,
+                                            std::chrono::milliseconds delay)
 {
-    return post_json(writeURL_, apiKey_, frameHex, outFrameHex);
+    asyncTransport().submitAfter(delay, writeURL_, request, std::move(callback));
 }
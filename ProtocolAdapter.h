@@ -1,20 +1,65 @@
 #ifndef PROTOCOL_ADAPTER_H
 #define PROTOCOL_ADAPTER_H
 
+#include <chrono>
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
+#include "AsyncTransport.h"
+#include "ModbusFrame.h"
+
+class CurlHandlePool;
+
+// How Modbus frames travel to the inverter
+enum class TransportType
+{
+    HTTP,        // Hex frames in JSON POSTs to the Inverter SIM API
+    MODBUS_TCP,  // Raw socket, MBAP header instead of the CRC
+    RTU_OVER_TCP // Raw socket, unmodified RTU frames (serial gateways)
+};
+
+TransportType parseTransportType(const std::string &name, TransportType fallback);
+const char *transportTypeName(TransportType type);
+
+// Where and how to reach the inverter API. Built from the HTTP fields; the
+// TCP transports then set transport, host and port.
+struct Endpoint
+{
+    Endpoint() = default;
+    Endpoint(const std::string &key, const std::string &read, const std::string &write)
+        : apiKey(key), readUrl(read), writeUrl(write) {}
+
+    std::string apiKey;
+    std::string readUrl;
+    std::string writeUrl;
+    TransportType transport = TransportType::HTTP;
+    std::string host; // Gateway for the TCP transports
+    uint16_t port = 502;
+};
 
 class ProtocolAdapter
 {
 public:
+    // Endpoint taken from config.ini
     ProtocolAdapter();
+    explicit ProtocolAdapter(const Endpoint &endpoint);
+    ~ProtocolAdapter();
+
+    // Send a read frame and return the response frame (size 0 if the API
+    // answered with undecodable hex)
+    bool sendReadRequest(const FrameBuffer &request, FrameBuffer &response);
 
-    // Send a read frame and return response hex
-    bool sendReadRequest(const std::string &frameHex, std::string &outFrameHex);
+    // Send a write frame and return the response frame
+    bool sendWriteRequest(const FrameBuffer &request, FrameBuffer &response);
 
-    // Send a write frame and return response hex
-    bool sendWriteRequest(const std::string &frameHex, std::string &outFrameHex);
+    // Non-blocking variants; the callback runs on the async transport thread.
+    // A non-zero delay holds the request back without blocking anyone (retry backoff).
+    void sendReadRequestAsync(const FrameBuffer &request, TransportCallback callback,
+                              std::chrono::milliseconds delay = std::chrono::milliseconds(0));
+    void sendWriteRequestAsync(const FrameBuffer &request, TransportCallback callback,
+                               std::chrono::milliseconds delay = std::chrono::milliseconds(0));
 
 private:
     // Configuration is loaded from config file
@@ -22,10 +67,22 @@ private:
     std::string apiKey_;
     std::string readURL_;
     std::string writeURL_;
+
+    // Persistent keep-alive handles shared by all callers of this adapter
+    std::unique_ptr<CurlHandlePool> pool_;
+    bool post(const std::string &url, const FrameBuffer &request, FrameBuffer &response);
+
+    void createPool();
+
+    // curl_multi event loop, started on first async request and shared by all
+    // adapters using the same API key
+    std::shared_ptr<AsyncTransport> async_;
+    std::once_flag asyncInit_;
+    AsyncTransport &asyncTransport();
 };
 
 // Internal helper (hidden from main)
 bool post_json(const std::string &url, const std::string &apiKey,
-               const std::string &frameHex, std::string &outFrameHex);
+               const FrameBuffer &request, FrameBuffer &response);
 
 #endif
@@ -0,0 +1,115 @@
+#include "ReadCoalescer.h"
+#include <algorithm>
+
+ReadCoalescer::ReadCoalescer(uint16_t maxRegisters)
+    : maxRegisters_(maxRegisters), launched_(0), joined_(0), merged_(0) {}
+
+void ReadCoalescer::read(uint8_t slave, uint16_t start, uint16_t count, Callback callback, Launcher launcher)
+{
+    uint32_t end = static_cast<uint32_t>(start) + count;
+    std::shared_ptr<Flight> leader;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::shared_ptr<Flight> overlapped;
+        for (const auto &flight : flights_)
+        {
+            if (flight->slave != slave)
+                continue;
+            uint32_t flightEnd = static_cast<uint32_t>(flight->start) + flight->count;
+
+            // Already being read
+            if (flight->start <= start && end <= flightEnd)
+            {
+                flight->waiters.push_back(Waiter{start, count, std::move(callback)});
+                joined_++;
+                return;
+            }
+
+            // Widen a queued read that overlaps or adjoins this one
+            uint32_t unionStart = std::min<uint32_t>(flight->start, start);
+            uint32_t unionEnd = std::max(flightEnd, end);
+            if (!flight->launched && start <= flightEnd && flight->start <= end &&
+                unionEnd - unionStart <= maxRegisters_)
+            {
+                flight->start = static_cast<uint16_t>(unionStart);
+                flight->count = static_cast<uint16_t>(unionEnd - unionStart);
+                flight->waiters.push_back(Waiter{start, count, std::move(callback)});
+                merged_++;
+                return;
+            }
+
+            if (flight->launched && !overlapped && start < flightEnd && flight->start < end)
+                overlapped = flight;
+        }
+
+        leader = std::make_shared<Flight>();
+        leader->slave = slave;
+        leader->start = start;
+        leader->count = count;
+        leader->launched = !overlapped;
+        leader->launcher = std::move(launcher);
+        leader->waiters.push_back(Waiter{start, count, std::move(callback)});
+        flights_.push_back(leader);
+
+        // Let the overlapping read finish first instead of fetching the same registers twice
+        if (overlapped)
+        {
+            overlapped->queued.push_back(leader);
+            return;
+        }
+    }
+    launch(leader);
+}
+
+void ReadCoalescer::launch(const std::shared_ptr<Flight> &flight)
+{
+    launched_++;
+    flight->launcher(flight);
+}
+
+void ReadCoalescer::complete(const std::shared_ptr<Flight> &flight, bool ok, const std::vector<uint16_t> &values)
+{
+    std::vector<Waiter> waiters;
+    std::vector<std::shared_ptr<Flight>> queued;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::find(flights_.begin(), flights_.end(), flight);
+        if (it != flights_.end())
+            flights_.erase(it);
+        waiters.swap(flight->waiters);
+        queued.swap(flight->queued);
+        for (const auto &next : queued)
+            next->launched = true;
+    }
+
+    ok = ok && values.size() >= flight->count;
+    std::vector<uint16_t> slice;
+    for (Waiter &waiter : waiters)
+    {
+        slice.clear();
+        if (ok)
+        {
+            auto first = values.begin() + (waiter.start - flight->start);
+            slice.assign(first, first + waiter.count);
+        }
+        waiter.callback(ok, slice);
+    }
+
+    for (const auto &next : queued)
+        launch(next);
+}
+
+// A flight that may have been answered before the write would hand old values
+// to reads issued after it; complete() no longer finds it, which is harmless
+void ReadCoalescer::invalidate(uint8_t slave, uint16_t start, uint16_t count)
+{
+    uint32_t end = static_cast<uint32_t>(start) + count;
+    std::lock_guard<std::mutex> lock(mutex_);
+    flights_.erase(std::remove_if(flights_.begin(), flights_.end(),
+                                  [slave, start, end](const std::shared_ptr<Flight> &flight)
+                                  {
+                                      return flight->slave == slave && flight->start < end &&
+                                             start < static_cast<uint32_t>(flight->start) + flight->count;
+                                  }),
+                   flights_.end());
+}
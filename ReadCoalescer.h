@@ -0,0 +1,75 @@
+#ifndef READ_COALESCER_H
+#define READ_COALESCER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Single-flight layer for holding-register reads.
+//
+// A read whose (slave, range) is covered by a read already in flight or
+// queued joins it and gets its slice of the response; no frame is sent for
+// it. A read that overlaps an in-flight read without being covered is queued
+// until that read completes, and later reads overlapping or adjoining the
+// queued one are merged into it as one superset read (up to maxRegisters).
+// A read touching neither an in-flight nor a queued read is sent at once.
+// Writes fence the reads they overlap: those keep serving the callers already
+// waiting on them, but later reads no longer join them.
+class ReadCoalescer
+{
+public:
+    typedef std::function<void(bool ok, const std::vector<uint16_t> &values)> Callback;
+
+    struct Flight;
+    // Issues the read of flight->start/count; whoever runs it must call
+    // complete() exactly once. Runs outside the coalescer's lock, either
+    // inside read() or on the thread completing the read it was queued on.
+    typedef std::function<void(const std::shared_ptr<Flight> &flight)> Launcher;
+
+    struct Waiter
+    {
+        uint16_t start;
+        uint16_t count;
+        Callback callback;
+    };
+
+    struct Flight
+    {
+        uint8_t slave;
+        uint16_t start;
+        uint16_t count;
+        bool launched;
+        Launcher launcher;
+        std::vector<Waiter> waiters;
+        std::vector<std::shared_ptr<Flight>> queued; // Launched when this flight completes
+    };
+
+    explicit ReadCoalescer(uint16_t maxRegisters = 125);
+
+    // The callback runs once with the requested registers. launcher is used
+    // only if this read ends up leading a new flight.
+    void read(uint8_t slave, uint16_t start, uint16_t count, Callback callback, Launcher launcher);
+    void complete(const std::shared_ptr<Flight> &flight, bool ok, const std::vector<uint16_t> &values);
+    // Called once a write to the range has been answered
+    void invalidate(uint8_t slave, uint16_t start, uint16_t count);
+
+    uint64_t launchedCount() const { return launched_; } // Reads actually issued
+    uint64_t joinedCount() const { return joined_; }     // Reads served by another flight
+    uint64_t mergedCount() const { return merged_; }     // Reads that widened a queued flight
+
+private:
+    void launch(const std::shared_ptr<Flight> &flight);
+
+    uint16_t maxRegisters_;
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<Flight>> flights_; // In flight or queued
+
+    std::atomic<uint64_t> launched_;
+    std::atomic<uint64_t> joined_;
+    std::atomic<uint64_t> merged_;
+};
+
+#endif
@@ -0,0 +1,164 @@
+#ifndef REGISTER_CODEC_H
+#define REGISTER_CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include "PollingConfig.h"
+#include "RegisterMap.h"
+
+// ========== Format kernels ==========
+// Raw value of one register format, resolved at compile time so decode loops
+// inline to plain loads, shifts and conversions
+template <RegisterFormat F>
+struct RegisterCodec;
+
+template <>
+struct RegisterCodec<RegisterFormat::U16>
+{
+    static const uint16_t WIDTH = 1;
+    static float raw(const uint16_t *regs) { return static_cast<float>(regs[0]); }
+};
+
+template <>
+struct RegisterCodec<RegisterFormat::S16>
+{
+    static const uint16_t WIDTH = 1;
+    static float raw(const uint16_t *regs) { return static_cast<float>(static_cast<int16_t>(regs[0])); }
+};
+
+template <>
+struct RegisterCodec<RegisterFormat::U32>
+{
+    static const uint16_t WIDTH = 2;
+    static float raw(const uint16_t *regs)
+    {
+        return static_cast<float>((static_cast<uint32_t>(regs[0]) << 16) | regs[1]);
+    }
+};
+
+template <>
+struct RegisterCodec<RegisterFormat::S32>
+{
+    static const uint16_t WIDTH = 2;
+    static float raw(const uint16_t *regs)
+    {
+        return static_cast<float>(static_cast<int32_t>((static_cast<uint32_t>(regs[0]) << 16) | regs[1]));
+    }
+};
+
+// Batch conversion of count consecutive values: out[i] = raw(value i) * scales[i].
+// Scales are reciprocal gains, so there is no division in the loop and the
+// single-register formats vectorise.
+template <RegisterFormat F>
+inline void decodeRun(const uint16_t *regs, const float *scales, size_t count, float *out)
+{
+    for (size_t i = 0; i < count; ++i)
+        out[i] = RegisterCodec<F>::raw(regs + i * RegisterCodec<F>::WIDTH) * scales[i];
+}
+
+// Runtime format dispatch: one switch per run, not per value
+inline void decodeRun(RegisterFormat format, const uint16_t *regs, const float *scales, size_t count, float *out)
+{
+    switch (format)
+    {
+    case RegisterFormat::U16:
+        decodeRun<RegisterFormat::U16>(regs, scales, count, out);
+        break;
+    case RegisterFormat::S16:
+        decodeRun<RegisterFormat::S16>(regs, scales, count, out);
+        break;
+    case RegisterFormat::U32:
+        decodeRun<RegisterFormat::U32>(regs, scales, count, out);
+        break;
+    case RegisterFormat::S32:
+        decodeRun<RegisterFormat::S32>(regs, scales, count, out);
+        break;
+    }
+}
+
+// ========== Build-time register layouts ==========
+// A register fixed at compile time. The gain is GainNum / GainDen (a template
+// parameter cannot be a float), applied as a constant reciprocal.
+template <ParameterType P, uint16_t Address, RegisterFormat Format, unsigned GainNum, unsigned GainDen = 1>
+struct FixedRegister
+{
+    static_assert(GainNum > 0 && GainDen > 0, "Register gain must be positive");
+
+    static constexpr ParameterType PARAMETER = P;
+    static constexpr uint16_t ADDRESS = Address;
+    static constexpr RegisterFormat FORMAT = Format;
+    static constexpr uint16_t WIDTH = RegisterCodec<Format>::WIDTH;
+    static constexpr float GAIN = static_cast<float>(GainNum) / GainDen;
+    static constexpr float SCALE = static_cast<float>(GainDen) / GainNum;
+
+    // regs holds a block read starting at register start
+    static void decode(const uint16_t *regs, uint16_t start, Sample &sample)
+    {
+        sample.values[parameterIndex(P)] = RegisterCodec<Format>::raw(regs + (Address - start)) * SCALE;
+    }
+};
+
+namespace RegisterLayoutDetail
+{
+    constexpr uint16_t minStart() { return 0xFFFF; }
+    template <typename R, typename... Rest>
+    constexpr uint16_t minStart(R, Rest... rest)
+    {
+        return R::ADDRESS < minStart(rest...) ? R::ADDRESS : minStart(rest...);
+    }
+
+    constexpr uint32_t maxEnd() { return 0; }
+    template <typename R, typename... Rest>
+    constexpr uint32_t maxEnd(R, Rest... rest)
+    {
+        return static_cast<uint32_t>(R::ADDRESS) + R::WIDTH > maxEnd(rest...) ? static_cast<uint32_t>(R::ADDRESS) + R::WIDTH
+                                                                             : maxEnd(rest...);
+    }
+
+    constexpr ParameterMask mask() { return 0; }
+    template <typename R, typename... Rest>
+    constexpr ParameterMask mask(R, Rest... rest)
+    {
+        return static_cast<ParameterMask>(parameterBit(R::PARAMETER) | mask(rest...));
+    }
+}
+
+// A whole register map known at build time, decoded from one block read
+// (START, COUNT) with every register's offset, format and scale folded into
+// straight-line code. Use it instead of PollPlanner::decodeBlock when a build
+// only ever talks to one inverter model.
+template <typename... Registers>
+struct FixedRegisterLayout
+{
+    static constexpr uint16_t START = RegisterLayoutDetail::minStart(Registers()...);
+    static constexpr uint16_t COUNT =
+        static_cast<uint16_t>(RegisterLayoutDetail::maxEnd(Registers()...) - RegisterLayoutDetail::minStart(Registers()...));
+    static constexpr ParameterMask MASK = RegisterLayoutDetail::mask(Registers()...);
+
+    static_assert(sizeof...(Registers) > 0, "A register layout needs registers");
+    static_assert(COUNT <= 125, "A fixed layout must fit one FC03 read");
+
+    // regs holds at least COUNT registers read from START
+    static void decode(const uint16_t *regs, Sample &sample)
+    {
+        int expand[] = {(Registers::decode(regs, START, sample), 0)...};
+        (void)expand;
+        sample.present |= MASK;
+    }
+};
+
+// The EcoWatt Inverter SIM layout, the same as the built-in RegisterMap
+typedef FixedRegisterLayout<
+    FixedRegister<ParameterType::AC_VOLTAGE, 0, RegisterFormat::U16, 10>,
+    FixedRegister<ParameterType::AC_CURRENT, 1, RegisterFormat::U16, 10>,
+    FixedRegister<ParameterType::AC_FREQUENCY, 2, RegisterFormat::U16, 100>,
+    FixedRegister<ParameterType::PV1_VOLTAGE, 3, RegisterFormat::U16, 10>,
+    FixedRegister<ParameterType::PV2_VOLTAGE, 4, RegisterFormat::U16, 10>,
+    FixedRegister<ParameterType::PV1_CURRENT, 5, RegisterFormat::U16, 10>,
+    FixedRegister<ParameterType::PV2_CURRENT, 6, RegisterFormat::U16, 10>,
+    FixedRegister<ParameterType::TEMPERATURE, 7, RegisterFormat::U16, 10>,
+    FixedRegister<ParameterType::EXPORT_POWER_PERCENT, 8, RegisterFormat::U16, 1>,
+    FixedRegister<ParameterType::OUTPUT_POWER, 9, RegisterFormat::U16, 1>>
+    SimRegisterLayout;
+
+#endif
@@ -0,0 +1,197 @@
+#include "RegisterMap.h"
+#include "Config.h"
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+    // EcoWatt Inverter SIM layout, used when no descriptor file is configured
+    const RegisterDescriptor BUILTIN_REGISTERS[] = {
+        {"AC_Voltage", "V", 0, RegisterFormat::U16, 10.0f, RegisterAccess::READ},
+        {"AC_Current", "A", 1, RegisterFormat::U16, 10.0f, RegisterAccess::READ},
+        {"AC_Frequency", "Hz", 2, RegisterFormat::U16, 100.0f, RegisterAccess::READ},
+        {"PV1_Voltage", "V", 3, RegisterFormat::U16, 10.0f, RegisterAccess::READ},
+        {"PV2_Voltage", "V", 4, RegisterFormat::U16, 10.0f, RegisterAccess::READ},
+        {"PV1_Current", "A", 5, RegisterFormat::U16, 10.0f, RegisterAccess::READ},
+        {"PV2_Current", "A", 6, RegisterFormat::U16, 10.0f, RegisterAccess::READ},
+        {"Temperature", "°C", 7, RegisterFormat::U16, 10.0f, RegisterAccess::READ},
+        {"Export_Power_Percent", "%", 8, RegisterFormat::U16, 1.0f, RegisterAccess::READ_WRITE},
+        {"Output_Power", "W", 9, RegisterFormat::U16, 1.0f, RegisterAccess::READ},
+    };
+
+    bool parseFormat(const std::string &token, RegisterFormat &format)
+    {
+        if (token == "u16")
+            format = RegisterFormat::U16;
+        else if (token == "s16")
+            format = RegisterFormat::S16;
+        else if (token == "u32")
+            format = RegisterFormat::U32;
+        else if (token == "s32")
+            format = RegisterFormat::S32;
+        else
+            return false;
+        return true;
+    }
+
+    bool parseAccess(const std::string &token, RegisterAccess &access)
+    {
+        if (token == "r")
+            access = RegisterAccess::READ;
+        else if (token == "w")
+            access = RegisterAccess::WRITE;
+        else if (token == "rw")
+            access = RegisterAccess::READ_WRITE;
+        else
+            return false;
+        return true;
+    }
+}
+
+RegisterMap::RegisterMap()
+    : entries_(std::begin(BUILTIN_REGISTERS), std::end(BUILTIN_REGISTERS)) {}
+
+const RegisterMap &RegisterMap::getInstance()
+{
+    static const RegisterMap instance = []()
+    {
+        RegisterMap map;
+        Config &config = Config::getInstance();
+        if (!config.isLoaded() && !config.loadFromFile())
+            std::cerr << "Error: Failed to load register map configuration" << std::endl;
+
+        std::string path = config.getRegisterMapFile();
+        if (!path.empty() && !map.loadFromFile(path))
+            std::cerr << "Warning: Using the built-in register map" << std::endl;
+        return map;
+    }();
+    return instance;
+}
+
+// ========== Descriptor files ==========
+bool RegisterMap::loadFromFile(const std::string &path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+    {
+        std::cerr << "Error: Could not open register map " << path << std::endl;
+        return false;
+    }
+    return load(file, path);
+}
+
+bool RegisterMap::load(std::istream &in, const std::string &source)
+{
+    std::vector<RegisterDescriptor> entries;
+    std::set<std::string> names;
+    std::string line;
+    for (int lineNo = 1; std::getline(in, line); ++lineNo)
+    {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos)
+            line.erase(comment);
+
+        std::istringstream fields(line);
+        std::string name, address, format, gain, unit, access, extra;
+        if (!(fields >> name))
+            continue; // Blank line
+        if (!(fields >> address >> format >> gain >> unit >> access) || (fields >> extra))
+        {
+            std::cerr << source << ":" << lineNo << ": expected name address format gain unit access" << std::endl;
+            return false;
+        }
+
+        RegisterDescriptor entry;
+        entry.name = name;
+        entry.unit = unit == "-" ? "" : unit;
+        try
+        {
+            size_t used;
+            unsigned long addr = std::stoul(address, &used, 0);
+            entry.gain = std::stof(gain);
+            if (used != address.size() || addr > 0xFFFF)
+                throw std::out_of_range(address);
+            entry.address = static_cast<uint16_t>(addr);
+        }
+        catch (const std::exception &)
+        {
+            std::cerr << source << ":" << lineNo << ": invalid address or gain" << std::endl;
+            return false;
+        }
+        if (!parseFormat(format, entry.format) || !parseAccess(access, entry.access))
+        {
+            std::cerr << source << ":" << lineNo << ": unknown format '" << format << "' or access '" << access
+                      << "'" << std::endl;
+            return false;
+        }
+        if (!(entry.gain > 0.0f) || !std::isfinite(entry.gain) ||
+            static_cast<uint32_t>(entry.address) + entry.width() > 0x10000)
+        {
+            std::cerr << source << ":" << lineNo << ": gain must be positive and the register in range" << std::endl;
+            return false;
+        }
+        if (!names.insert(name).second)
+        {
+            std::cerr << source << ":" << lineNo << ": duplicate register " << name << std::endl;
+            return false;
+        }
+        entries.push_back(entry);
+    }
+
+    if (entries.empty())
+    {
+        std::cerr << source << ": no registers defined" << std::endl;
+        return false;
+    }
+    entries_.swap(entries);
+    return true;
+}
+
+// ========== Lookup and encoding ==========
+const RegisterDescriptor *RegisterMap::find(const std::string &name) const
+{
+    for (const RegisterDescriptor &entry : entries_)
+    {
+        if (entry.name == name)
+            return &entry;
+    }
+    return nullptr;
+}
+
+bool RegisterMap::encodeRaw(RegisterFormat format, int64_t raw, uint16_t *regs)
+{
+    int64_t min = 0, max = 0xFFFF;
+    switch (format)
+    {
+    case RegisterFormat::S16:
+        min = -0x8000;
+        max = 0x7FFF;
+        break;
+    case RegisterFormat::U32:
+        max = 0xFFFFFFFFLL;
+        break;
+    case RegisterFormat::S32:
+        min = -0x80000000LL;
+        max = 0x7FFFFFFF;
+        break;
+    case RegisterFormat::U16:
+        break;
+    }
+    if (raw < min || raw > max)
+        return false;
+
+    uint32_t bits = static_cast<uint32_t>(raw);
+    if (registerWidth(format) == 2)
+    {
+        regs[0] = static_cast<uint16_t>(bits >> 16);
+        regs[1] = static_cast<uint16_t>(bits & 0xFFFF);
+    }
+    else
+        regs[0] = static_cast<uint16_t>(bits & 0xFFFF);
+    return true;
+}
@@ -0,0 +1,99 @@
+#ifndef REGISTER_MAP_H
+#define REGISTER_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <vector>
+
+// How a value is laid out in holding registers
+enum class RegisterFormat : uint8_t
+{
+    U16, // One register
+    S16,
+    U32, // Two registers, high word first
+    S32
+};
+
+// Registers occupied by a value of the format
+inline uint16_t registerWidth(RegisterFormat format)
+{
+    return (format == RegisterFormat::U32 || format == RegisterFormat::S32) ? 2 : 1;
+}
+
+enum class RegisterAccess : uint8_t
+{
+    READ,
+    WRITE,
+    READ_WRITE
+};
+
+struct RegisterDescriptor
+{
+    std::string name; // Parameter name, e.g. AC_Voltage
+    std::string unit;
+    uint16_t address = 0;
+    RegisterFormat format = RegisterFormat::U16;
+    float gain = 1.0f; // Raw register value = value * gain
+    RegisterAccess access = RegisterAccess::READ;
+
+    uint16_t width() const { return registerWidth(format); }
+    bool readable() const { return access != RegisterAccess::WRITE; }
+    bool writable() const { return access != RegisterAccess::READ; }
+};
+
+// Register layout of an inverter model, kept as a flat table.
+//
+// The built-in layout matches the EcoWatt Inverter SIM (registers 0-9). Other
+// models are described by a descriptor file, one register per line:
+//
+//   # name        address  format  gain  unit  access
+//   AC_Voltage    0        u16     10    V     r
+//   Output_Power  40       s32     1     W     r
+//
+// format is u16, s16, u32 or s32 (32-bit values span two registers, high word
+// first); access is r, w or rw. Blank lines and '#' comments are ignored.
+class RegisterMap
+{
+public:
+    RegisterMap();
+
+    // Process-wide map: [REGISTERS] map_file from config.ini if set, else the
+    // built-in layout. Loaded on first use and never changed afterwards.
+    static const RegisterMap &getInstance();
+
+    // The current entries are only replaced if the whole descriptor is valid
+    bool loadFromFile(const std::string &path);
+    bool load(std::istream &in, const std::string &source = "register map");
+
+    size_t size() const { return entries_.size(); }
+    const RegisterDescriptor &at(size_t index) const { return entries_[index]; }
+    // Null when the map has no register of that name
+    const RegisterDescriptor *find(const std::string &name) const;
+
+    // Signed raw value held in regs (width(format) registers)
+    static int64_t rawValue(RegisterFormat format, const uint16_t *regs)
+    {
+        switch (format)
+        {
+        case RegisterFormat::S16:
+            return static_cast<int16_t>(regs[0]);
+        case RegisterFormat::U32:
+            return (static_cast<uint32_t>(regs[0]) << 16) | regs[1];
+        case RegisterFormat::S32:
+            return static_cast<int32_t>((static_cast<uint32_t>(regs[0]) << 16) | regs[1]);
+        case RegisterFormat::U16:
+            break;
+        }
+        return regs[0];
+    }
+
+    // Register words of a raw value; false if it does not fit the format
+    static bool encodeRaw(RegisterFormat format, int64_t raw, uint16_t *regs);
+
+private:
+    std::vector<RegisterDescriptor> entries_;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#include "RetryPolicy.h"
+#include "Config.h"
+#include <random>
+
+// ========== RetryPolicy ==========
+RetryPolicy::RetryPolicy() : settings_() {}
+
+RetryPolicy::RetryPolicy(const RetrySettings &settings) : settings_(settings) {}
+
+RetrySettings RetryPolicy::settingsFromConfig()
+{
+    Config &config = Config::getInstance();
+    RetrySettings settings;
+    settings.maxAttempts = config.getRetryMaxAttempts();
+    settings.initialBackoff = std::chrono::milliseconds(config.getRetryInitialBackoffMs());
+    settings.backoffMultiplier = config.getRetryBackoffMultiplier();
+    settings.maxBackoff = std::chrono::milliseconds(config.getRetryMaxBackoffMs());
+    settings.jitter = config.getRetryJitter();
+    settings.deadline = std::chrono::milliseconds(config.getRetryDeadlineMs());
+    return settings;
+}
+
+bool RetryPolicy::isRetryable(AttemptOutcome outcome, uint8_t exceptionCode) const
+{
+    if (outcome != AttemptOutcome::MODBUS_EXCEPTION)
+        return outcome != AttemptOutcome::SUCCESS;
+
+    switch (exceptionCode)
+    {
+    case 0x01: // Illegal Function
+    case 0x02: // Illegal Data Address
+    case 0x03: // Illegal Data Value
+        return false;
+    default:
+        return true;
+    }
+}
+
+std::chrono::milliseconds RetryPolicy::backoff(int attempt) const
+{
+    double delayMs = static_cast<double>(settings_.initialBackoff.count());
+    for (int i = 1; i < attempt; ++i)
+        delayMs *= settings_.backoffMultiplier;
+    if (delayMs > settings_.maxBackoff.count())
+        delayMs = static_cast<double>(settings_.maxBackoff.count());
+
+    // Jitter spreads out retries of devices that failed at the same moment
+    if (settings_.jitter > 0.0)
+    {
+        static thread_local std::mt19937 rng(std::random_device{}());
+        std::uniform_real_distribution<double> spread(1.0 - settings_.jitter, 1.0 + settings_.jitter);
+        delayMs *= spread(rng);
+    }
+    return std::chrono::milliseconds(static_cast<long long>(delayMs));
+}
+
+bool RetryPolicy::nextRetry(int attempt, AttemptOutcome outcome, uint8_t exceptionCode,
+                            std::chrono::steady_clock::time_point started, std::chrono::milliseconds &delay) const
+{
+    if (attempt >= settings_.maxAttempts || !isRetryable(outcome, exceptionCode))
+        return false;
+
+    delay = backoff(attempt);
+    if (settings_.deadline.count() > 0 &&
+        std::chrono::steady_clock::now() + delay >= started + settings_.deadline)
+        return false;
+    return true;
+}
+
+// ========== CircuitBreaker ==========
+CircuitBreaker::CircuitBreaker()
+    : consecutiveFailures_(0), openUntilNs_(0), probeInFlight_(false), threshold_(0), cooldownNs_(0) {}
+
+void CircuitBreaker::configure(unsigned threshold, std::chrono::milliseconds cooldown)
+{
+    threshold_ = threshold;
+    cooldownNs_ = std::chrono::duration_cast<std::chrono::nanoseconds>(cooldown).count();
+}
+
+int64_t CircuitBreaker::nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+bool CircuitBreaker::allowRequest()
+{
+    int64_t openUntil = openUntilNs_.load(std::memory_order_acquire);
+    if (openUntil == 0)
+        return true;
+    if (nowNs() < openUntil)
+        return false;
+    // Cooldown over: exactly one caller gets to probe the device
+    return !probeInFlight_.exchange(true, std::memory_order_acq_rel);
+}
+
+void CircuitBreaker::recordSuccess()
+{
+    consecutiveFailures_.store(0, std::memory_order_relaxed);
+    openUntilNs_.store(0, std::memory_order_release);
+    probeInFlight_.store(false, std::memory_order_release);
+}
+
+bool CircuitBreaker::recordFailure()
+{
+    unsigned threshold = threshold_.load(std::memory_order_relaxed);
+    if (threshold == 0)
+        return false;
+
+    unsigned failures = consecutiveFailures_.fetch_add(1, std::memory_order_relaxed) + 1;
+    bool halfOpen = openUntilNs_.load(std::memory_order_acquire) != 0;
+    if (halfOpen || failures == threshold)
+    {
+        // A failed probe re-opens for another full cooldown
+        openUntilNs_.store(nowNs() + cooldownNs_.load(std::memory_order_relaxed), std::memory_order_release);
+        probeInFlight_.store(false, std::memory_order_release);
+        return true;
+    }
+    return false;
+}
+
+CircuitBreaker::State CircuitBreaker::state() const
+{
+    int64_t openUntil = openUntilNs_.load(std::memory_order_acquire);
+    if (openUntil == 0)
+        return State::CLOSED;
+    return nowNs() < openUntil ? State::OPEN : State::HALF_OPEN;
+}
+
+std::chrono::milliseconds CircuitBreaker::cooldown() const
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::nanoseconds(cooldownNs_.load(std::memory_order_relaxed)));
+}
@@ -0,0 +1,86 @@
+#ifndef RETRY_POLICY_H
+#define RETRY_POLICY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "Metrics.h"
+
+// Tunables of the default retry policy ([RETRY] in config.ini)
+struct RetrySettings
+{
+    int maxAttempts = 3;
+    std::chrono::milliseconds initialBackoff{100};
+    double backoffMultiplier = 2.0;
+    std::chrono::milliseconds maxBackoff{2000};
+    double jitter = 0.2;                      // +/- fraction applied to every delay
+    std::chrono::milliseconds deadline{5000}; // Whole request including retries, 0 = none
+};
+
+// Decides whether and when a failed Modbus attempt is retried.
+// Subclass and override isRetryable()/backoff() to plug in another strategy.
+class RetryPolicy
+{
+public:
+    RetryPolicy();
+    explicit RetryPolicy(const RetrySettings &settings);
+    virtual ~RetryPolicy() = default;
+
+    static RetrySettings settingsFromConfig();
+
+    // Illegal function/address/value (0x01-0x03) will fail the same way again;
+    // everything else (busy, transport, CRC, parse errors) may be transient
+    virtual bool isRetryable(AttemptOutcome outcome, uint8_t exceptionCode) const;
+
+    // Delay before the next attempt after `attempt` attempts have failed
+    virtual std::chrono::milliseconds backoff(int attempt) const;
+
+    // Combines the above with the attempt limit and deadline. On true, delay
+    // holds how long to wait before the next attempt.
+    bool nextRetry(int attempt, AttemptOutcome outcome, uint8_t exceptionCode,
+                   std::chrono::steady_clock::time_point started, std::chrono::milliseconds &delay) const;
+
+    const RetrySettings &settings() const { return settings_; }
+
+protected:
+    RetrySettings settings_;
+};
+
+// Per-device circuit breaker. After `threshold` consecutive failed requests
+// the breaker opens and rejects requests for the cooldown; then a single
+// probe request is let through, closing the breaker again on success.
+class CircuitBreaker
+{
+public:
+    enum class State
+    {
+        CLOSED,
+        OPEN,
+        HALF_OPEN
+    };
+
+    CircuitBreaker();
+
+    // threshold 0 disables the breaker
+    void configure(unsigned threshold, std::chrono::milliseconds cooldown);
+
+    bool allowRequest();
+    void recordSuccess();
+    // Returns true when this failure opened (or re-opened) the breaker
+    bool recordFailure();
+
+    State state() const;
+    bool isOpen() const { return state() == State::OPEN; }
+    std::chrono::milliseconds cooldown() const;
+
+private:
+    static int64_t nowNs();
+
+    std::atomic<unsigned> consecutiveFailures_;
+    std::atomic<int64_t> openUntilNs_; // 0 while closed
+    std::atomic<bool> probeInFlight_;
+    std::atomic<unsigned> threshold_;
+    std::atomic<int64_t> cooldownNs_;
+};
+
+#endif
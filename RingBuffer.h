@@ -0,0 +1,171 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+static const size_t CACHE_LINE_SIZE = 64;
+
+// Bounded lock-free ring buffer (Vyukov sequence-per-slot design).
+//
+// Each slot carries a sequence number telling producers and consumers whether
+// it is free or holds an item for the current lap, so no lock is needed.
+// The producer side is either single-threaded (plain index store) or
+// multi-threaded (CAS on the tail). The consumer side always claims slots
+// with a CAS, which lets a producer evict the oldest item for drop-oldest
+// overflow handling while the regular consumer is draining.
+//
+// Head and tail live on separate cache lines so producer and consumer never
+// false-share.
+//
+// A single slot cannot tell "free for this lap" from "full from the last
+// lap" (both read the same sequence), so the capacity is at least 2.
+template <typename T, bool MultiProducer>
+class BoundedRing
+{
+public:
+    explicit BoundedRing(size_t capacity)
+        : capacity_(capacity < 2 ? 2 : capacity), slots_(new Slot[capacity_])
+    {
+        for (size_t i = 0; i < capacity_; ++i)
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+        head_.store(0, std::memory_order_relaxed);
+    }
+
+    BoundedRing(const BoundedRing &) = delete;
+    BoundedRing &operator=(const BoundedRing &) = delete;
+
+    // Returns false (leaving item untouched) when the ring is full
+    bool tryPush(T &&item)
+    {
+        size_t pos;
+        Slot *slot = claimForPush(pos);
+        if (!slot)
+            return false;
+        slot->value = std::move(item);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPush(const T &item)
+    {
+        T copy(item);
+        return tryPush(std::move(copy));
+    }
+
+    // Returns false when the ring is empty
+    bool tryPop(T &item)
+    {
+        size_t pos;
+        Slot *slot = claimForPop(pos);
+        if (!slot)
+            return false;
+        item = std::move(slot->value);
+        slot->sequence.store(pos + capacity_, std::memory_order_release);
+        return true;
+    }
+
+    // Hand up to maxItems items to fn(T &) while they are still in their slot,
+    // releasing each slot afterwards. Returns the number of items consumed.
+    template <typename Fn>
+    size_t consume(Fn fn, size_t maxItems = SIZE_MAX)
+    {
+        size_t count = 0;
+        size_t pos;
+        Slot *slot;
+        while (count < maxItems && (slot = claimForPop(pos)) != nullptr)
+        {
+            fn(slot->value);
+            slot->sequence.store(pos + capacity_, std::memory_order_release);
+            ++count;
+        }
+        return count;
+    }
+
+    // Approximate when other threads are active
+    size_t size() const
+    {
+        size_t tail = tail_.load(std::memory_order_acquire);
+        size_t head = head_.load(std::memory_order_acquire);
+        return tail > head ? tail - head : 0;
+    }
+
+    bool empty() const { return size() == 0; }
+    size_t capacity() const { return capacity_; }
+
+private:
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    Slot *claimForPush(size_t &pos)
+    {
+        pos = tail_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot *slot = &slots_[pos % capacity_];
+            size_t seq = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (!MultiProducer)
+                {
+                    tail_.store(pos + 1, std::memory_order_relaxed);
+                    return slot;
+                }
+                if (tail_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    return slot;
+            }
+            else if (diff < 0)
+                return nullptr; // Slot still holds an item from the previous lap: full
+            else
+                pos = tail_.load(std::memory_order_relaxed);
+        }
+    }
+
+    Slot *claimForPop(size_t &pos)
+    {
+        pos = head_.load(std::memory_order_relaxed);
+        while (true)
+        {
+            Slot *slot = &slots_[pos % capacity_];
+            size_t seq = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (head_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    return slot;
+            }
+            else if (diff < 0)
+                return nullptr; // Not yet published: empty
+            else
+                pos = head_.load(std::memory_order_relaxed);
+        }
+    }
+
+    const size_t capacity_;
+    std::unique_ptr<Slot[]> slots_;
+
+    // Producer and consumer indices, each padded to its own cache line
+    char padStart_[CACHE_LINE_SIZE];
+    std::atomic<size_t> tail_;
+    char padTail_[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> head_;
+    char padHead_[CACHE_LINE_SIZE - sizeof(std::atomic<size_t>)];
+};
+
+// One poller thread producing, one uploader consuming
+template <typename T>
+using SpscRingBuffer = BoundedRing<T, false>;
+
+// Several poller threads producing into one buffer
+template <typename T>
+using MpscRingBuffer = BoundedRing<T, true>;
+
+#endif
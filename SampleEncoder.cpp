@@ -0,0 +1,332 @@
+#include "SampleEncoder.h"
+#include <cmath>
+#include <zlib.h>
+
+const uint8_t SampleEncoder::FORMAT_VERSION;
+const uint8_t SampleEncoder::FLAG_COMPRESSED;
+const uint8_t SampleEncoder::FLAG_AGGREGATES;
+
+SampleEncoder::SampleEncoder(const PollingConfig &config)
+{
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+    {
+        float gain = config.getParameterConfig(static_cast<ParameterType>(i)).gain;
+        gains_[i] = gain > 0.0f ? gain : 1.0f;
+    }
+}
+
+// ========== Varints ==========
+void SampleEncoder::putVarint(std::vector<uint8_t> &out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+bool SampleEncoder::getVarint(const uint8_t *&pos, const uint8_t *end, uint64_t &value)
+{
+    value = 0;
+    for (unsigned shift = 0; shift < 64 && pos < end; shift += 7)
+    {
+        uint8_t byte = *pos++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false; // Truncated or over-long
+}
+
+// ========== Encoding ==========
+bool SampleEncoder::encode(const SampleBatch &batch, uint8_t deviceId, std::vector<uint8_t> &out, bool compress)
+{
+    const size_t count = batch.size();
+    body_.clear();
+    body_.reserve(16 + count * (2 + PARAMETER_COUNT));
+
+    putVarint(body_, deviceId);
+    putVarint(body_, count);
+
+    // Timestamps: first value, first delta, then delta-of-delta
+    long long prevTimestamp = 0;
+    long long prevDelta = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        long long ts = batch.timestamps[i];
+        if (i == 0)
+            putVarint(body_, zigzag(ts));
+        else
+        {
+            long long delta = ts - prevTimestamp;
+            putVarint(body_, zigzag(i == 1 ? delta : delta - prevDelta));
+            prevDelta = delta;
+        }
+        prevTimestamp = ts;
+    }
+
+    ParameterMask prevMask = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        putVarint(body_, static_cast<uint64_t>(batch.masks[i] ^ prevMask));
+        prevMask = batch.masks[i];
+    }
+
+    // Column-major raw register deltas keep similar bytes together for zlib
+    for (size_t p = 0; p < PARAMETER_COUNT; ++p)
+    {
+        const ParameterMask bit = static_cast<ParameterMask>(1u << p);
+        const std::vector<float> &column = batch.columns[p];
+        long long prevRaw = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!(batch.masks[i] & bit))
+                continue;
+            long long raw = rawValue(p, column[i]);
+            putVarint(body_, zigzag(raw - prevRaw));
+            prevRaw = raw;
+        }
+    }
+
+    return finish(0, compress, out);
+}
+
+bool SampleEncoder::encodeAggregates(const std::vector<WindowAggregate> &windows, uint8_t deviceId,
+                                     std::vector<uint8_t> &out, bool compress)
+{
+    const size_t count = windows.size();
+    body_.clear();
+    body_.reserve(16 + count * (6 + 4 * PARAMETER_COUNT));
+
+    putVarint(body_, deviceId);
+    putVarint(body_, count);
+
+    long long prevStart = 0;
+    ParameterMask prevMask = 0;
+    for (const WindowAggregate &window : windows)
+    {
+        putVarint(body_, zigzag(window.start - prevStart));
+        putVarint(body_, zigzag(window.end - window.start));
+        putVarint(body_, window.samples);
+        putVarint(body_, static_cast<uint64_t>(window.present ^ prevMask));
+        prevStart = window.start;
+        prevMask = window.present;
+    }
+
+    // Means drift slowly between windows; min, max and last sit close to the mean
+    for (size_t p = 0; p < PARAMETER_COUNT; ++p)
+    {
+        const ParameterMask bit = static_cast<ParameterMask>(1u << p);
+        long long prevMean = 0;
+        for (const WindowAggregate &window : windows)
+        {
+            if (!(window.present & bit))
+                continue;
+            long long mean = rawValue(p, window.mean[p]);
+            putVarint(body_, zigzag(mean - prevMean));
+            putVarint(body_, zigzag(rawValue(p, window.min[p]) - mean));
+            putVarint(body_, zigzag(rawValue(p, window.max[p]) - mean));
+            putVarint(body_, zigzag(rawValue(p, window.last[p]) - mean));
+            prevMean = mean;
+        }
+    }
+
+    for (const WindowAggregate &window : windows)
+    {
+        if (window.hasValue(ParameterType::OUTPUT_POWER))
+            putVarint(body_, zigzag(std::llround(window.energyWh * 1000.0)));
+    }
+
+    return finish(FLAG_AGGREGATES, compress, out);
+}
+
+bool SampleEncoder::finish(uint8_t flags, bool compress, std::vector<uint8_t> &out)
+{
+    out.clear();
+    out.push_back('E');
+    out.push_back('W');
+    out.push_back(FORMAT_VERSION);
+    if (!compress)
+    {
+        out.push_back(flags);
+        out.insert(out.end(), body_.begin(), body_.end());
+        return true;
+    }
+
+    out.push_back(static_cast<uint8_t>(flags | FLAG_COMPRESSED));
+    putVarint(out, body_.size());
+    size_t headerSize = out.size();
+    uLongf compressedSize = compressBound(static_cast<uLong>(body_.size()));
+    out.resize(headerSize + compressedSize);
+    if (compress2(out.data() + headerSize, &compressedSize, body_.data(), static_cast<uLong>(body_.size()),
+                  Z_BEST_COMPRESSION) != Z_OK)
+        return false;
+    out.resize(headerSize + compressedSize);
+    return true;
+}
+
+// ========== Decoding ==========
+bool SampleEncoder::openBody(const uint8_t *data, size_t len, uint8_t expected, std::vector<uint8_t> &inflated,
+                             const uint8_t *&pos, const uint8_t *&end)
+{
+    if (len < 4 || data[0] != 'E' || data[1] != 'W' || data[2] != FORMAT_VERSION ||
+        (data[3] & ~FLAG_COMPRESSED) != expected)
+        return false;
+
+    pos = data + 4;
+    end = data + len;
+    if (data[3] & FLAG_COMPRESSED)
+    {
+        uint64_t rawLength;
+        if (!getVarint(pos, end, rawLength) || rawLength > (64u << 20))
+            return false;
+        inflated.resize(static_cast<size_t>(rawLength));
+        uLongf inflatedSize = static_cast<uLongf>(rawLength);
+        if (uncompress(inflated.data(), &inflatedSize, pos, static_cast<uLong>(end - pos)) != Z_OK ||
+            inflatedSize != rawLength)
+            return false;
+        pos = inflated.data();
+        end = pos + inflated.size();
+    }
+    return true;
+}
+
+bool SampleEncoder::decode(const uint8_t *data, size_t len, SampleBatch &batch, uint8_t &deviceId) const
+{
+    const uint8_t *pos;
+    const uint8_t *end;
+    std::vector<uint8_t> inflated;
+    if (!openBody(data, len, 0, inflated, pos, end))
+        return false;
+
+    uint64_t value, count;
+    if (!getVarint(pos, end, value) || value > 0xFF || !getVarint(pos, end, count) ||
+        count > static_cast<uint64_t>(end - pos))
+        return false;
+    deviceId = static_cast<uint8_t>(value);
+
+    batch.clear();
+    batch.reserve(static_cast<size_t>(count));
+
+    std::vector<long long> timestamps(static_cast<size_t>(count));
+    long long prevDelta = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!getVarint(pos, end, value))
+            return false;
+        long long v = unzigzag(value);
+        if (i == 0)
+            timestamps[i] = v;
+        else
+        {
+            long long delta = (i == 1) ? v : prevDelta + v;
+            timestamps[i] = timestamps[i - 1] + delta;
+            prevDelta = delta;
+        }
+    }
+
+    std::vector<ParameterMask> masks(static_cast<size_t>(count));
+    ParameterMask prevMask = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (!getVarint(pos, end, value))
+            return false;
+        masks[i] = static_cast<ParameterMask>(prevMask ^ value);
+        prevMask = masks[i];
+    }
+
+    std::vector<Sample> samples(static_cast<size_t>(count));
+    for (size_t i = 0; i < count; ++i)
+    {
+        samples[i].timestamp = timestamps[i];
+        samples[i].present = masks[i];
+    }
+    for (size_t p = 0; p < PARAMETER_COUNT; ++p)
+    {
+        const ParameterMask bit = static_cast<ParameterMask>(1u << p);
+        long long raw = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (!(masks[i] & bit))
+                continue;
+            if (!getVarint(pos, end, value))
+                return false;
+            raw += unzigzag(value);
+            samples[i].values[p] = fromRaw(p, raw);
+        }
+    }
+    if (pos != end)
+        return false;
+
+    for (const Sample &sample : samples)
+        batch.append(sample);
+    return true;
+}
+
+bool SampleEncoder::decodeAggregates(const uint8_t *data, size_t len, std::vector<WindowAggregate> &windows,
+                                     uint8_t &deviceId) const
+{
+    const uint8_t *pos;
+    const uint8_t *end;
+    std::vector<uint8_t> inflated;
+    if (!openBody(data, len, FLAG_AGGREGATES, inflated, pos, end))
+        return false;
+
+    uint64_t value, count;
+    if (!getVarint(pos, end, value) || value > 0xFF || !getVarint(pos, end, count) ||
+        count > static_cast<uint64_t>(end - pos))
+        return false;
+    deviceId = static_cast<uint8_t>(value);
+
+    std::vector<WindowAggregate> decoded(static_cast<size_t>(count));
+    long long prevStart = 0;
+    ParameterMask prevMask = 0;
+    for (WindowAggregate &window : decoded)
+    {
+        uint64_t length, samples, mask;
+        if (!getVarint(pos, end, value) || !getVarint(pos, end, length) || !getVarint(pos, end, samples) ||
+            !getVarint(pos, end, mask) || samples > 0xFFFFFFFFu)
+            return false;
+        window.start = prevStart + unzigzag(value);
+        window.end = window.start + unzigzag(length);
+        window.samples = static_cast<uint32_t>(samples);
+        window.present = static_cast<ParameterMask>(prevMask ^ mask);
+        prevStart = window.start;
+        prevMask = window.present;
+    }
+
+    for (size_t p = 0; p < PARAMETER_COUNT; ++p)
+    {
+        const ParameterMask bit = static_cast<ParameterMask>(1u << p);
+        long long mean = 0;
+        for (WindowAggregate &window : decoded)
+        {
+            if (!(window.present & bit))
+                continue;
+            uint64_t minDelta, maxDelta, lastDelta;
+            if (!getVarint(pos, end, value) || !getVarint(pos, end, minDelta) || !getVarint(pos, end, maxDelta) ||
+                !getVarint(pos, end, lastDelta))
+                return false;
+            mean += unzigzag(value);
+            window.mean[p] = fromRaw(p, mean);
+            window.min[p] = fromRaw(p, mean + unzigzag(minDelta));
+            window.max[p] = fromRaw(p, mean + unzigzag(maxDelta));
+            window.last[p] = fromRaw(p, mean + unzigzag(lastDelta));
+        }
+    }
+
+    for (WindowAggregate &window : decoded)
+    {
+        if (!window.hasValue(ParameterType::OUTPUT_POWER))
+            continue;
+        if (!getVarint(pos, end, value))
+            return false;
+        window.energyWh = unzigzag(value) / 1000.0;
+    }
+    if (pos != end)
+        return false;
+
+    windows.swap(decoded);
+    return true;
+}
@@ -0,0 +1,82 @@
+#ifndef SAMPLE_ENCODER_H
+#define SAMPLE_ENCODER_H
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "PollingConfig.h"
+#include "WindowAggregator.h"
+
+// Compact binary encoding of a sample batch for upload.
+//
+// Layout (all integers are LEB128 varints, signed ones zigzag-encoded):
+//   'E' 'W' version flags        4-byte header, flags bit 0 = zlib-compressed body
+//   [rawBodyLength]              only when compressed
+//   body:
+//     deviceId count
+//     firstTimestamp firstDelta  then one delta-of-delta per further sample
+//     mask XOR previous mask     one per sample (0 while the parameter set is stable)
+//     per parameter, per sample carrying it:
+//       raw register value (value * gain) minus the previous raw value
+//
+// Periodic samples of slowly changing registers therefore cost about one
+// byte per field before compression.
+//
+// Window aggregates (flags bit 1) use the same header with this body:
+//     deviceId count
+//     per window: start (first absolute, then delta to the previous start),
+//                 length, sample count, mask XOR previous mask
+//     per parameter, per window carrying it:
+//       raw mean minus the previous raw mean, then raw min, max and last
+//       each minus the raw mean
+//     per window carrying OUTPUT_POWER: energy in mWh
+class SampleEncoder
+{
+public:
+    static const uint8_t FORMAT_VERSION = 1;
+    static const uint8_t FLAG_COMPRESSED = 0x01;
+    static const uint8_t FLAG_AGGREGATES = 0x02;
+
+    explicit SampleEncoder(const PollingConfig &config);
+
+    // Replaces out with the encoded batch
+    bool encode(const SampleBatch &batch, uint8_t deviceId, std::vector<uint8_t> &out, bool compress = false);
+
+    // Inverse of encode(); values are restored as raw / gain
+    bool decode(const uint8_t *data, size_t len, SampleBatch &batch, uint8_t &deviceId) const;
+
+    // Same for a batch of window aggregates
+    bool encodeAggregates(const std::vector<WindowAggregate> &windows, uint8_t deviceId, std::vector<uint8_t> &out,
+                          bool compress = false);
+    bool decodeAggregates(const uint8_t *data, size_t len, std::vector<WindowAggregate> &windows,
+                          uint8_t &deviceId) const;
+
+    // LEB128 / zigzag primitives
+    static void putVarint(std::vector<uint8_t> &out, uint64_t value);
+    static bool getVarint(const uint8_t *&pos, const uint8_t *end, uint64_t &value);
+    static uint64_t zigzag(int64_t value) { return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63); }
+    static int64_t unzigzag(uint64_t value) { return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1); }
+
+private:
+    // Header, optional compression of body_ and the body itself
+    bool finish(uint8_t flags, bool compress, std::vector<uint8_t> &out);
+    // Checks the header and locates the (inflated) body; flags must match expected apart from compression
+    static bool openBody(const uint8_t *data, size_t len, uint8_t expected, std::vector<uint8_t> &inflated,
+                         const uint8_t *&pos, const uint8_t *&end);
+
+    long long rawValue(size_t param, float value) const
+    {
+        return std::llround(static_cast<double>(value) * gains_[param]);
+    }
+    float fromRaw(size_t param, long long raw) const
+    {
+        return static_cast<float>(raw / static_cast<double>(gains_[param]));
+    }
+
+    std::array<float, PARAMETER_COUNT> gains_;
+    std::vector<uint8_t> body_; // Reused between batches
+};
+
+#endif
@@ -0,0 +1,488 @@
+#include "SampleStore.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+#include <zlib.h>
+
+const size_t SampleStore::RECORD_SIZE;
+const size_t SampleStore::HEADER_SIZE;
+
+namespace
+{
+    const char SEGMENT_MAGIC[4] = {'E', 'W', 'S', 'S'};
+    const uint16_t SEGMENT_VERSION = 1;
+    const uint8_t RECORD_MARKER = 0xA5;
+
+    // Record layout: crc32(bytes 4..63) | marker | reserved | present | timestamp | values | padding
+    const size_t CRC_OFFSET = 0;
+    const size_t MARKER_OFFSET = 4;
+    const size_t PRESENT_OFFSET = 6;
+    const size_t TIMESTAMP_OFFSET = 8;
+    const size_t VALUES_OFFSET = 16;
+
+    static_assert(VALUES_OFFSET + PARAMETER_COUNT * sizeof(float) <= SampleStore::RECORD_SIZE,
+                  "Sample does not fit in a store record");
+
+    // Segment header: magic | version | record size | records per segment | sequence
+    struct SegmentHeader
+    {
+        char magic[4];
+        uint16_t version;
+        uint16_t recordSize;
+        uint32_t recordsPerSegment;
+        uint64_t seq;
+    };
+
+    bool makeDirectories(const std::string &path)
+    {
+        for (size_t pos = 1; pos <= path.size(); ++pos)
+        {
+            if (pos != path.size() && path[pos] != '/')
+                continue;
+            std::string prefix = path.substr(0, pos);
+            if (::mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST)
+                return false;
+        }
+        return true;
+    }
+
+    uint32_t recordCrc(const uint8_t *record)
+    {
+        return static_cast<uint32_t>(crc32(0, record + MARKER_OFFSET,
+                                           static_cast<uInt>(SampleStore::RECORD_SIZE - MARKER_OFFSET)));
+    }
+}
+
+SampleStore::SampleStore(const std::string &directory, size_t recordsPerSegment, size_t maxSegments)
+    : directory_(directory),
+      recordsPerSegment_(recordsPerSegment == 0 ? 1 : recordsPerSegment),
+      maxSegments_(maxSegments == 0 ? 1 : maxSegments) {}
+
+SampleStore::~SampleStore()
+{
+    close();
+}
+
+// ========== Records ==========
+void SampleStore::encodeRecord(const Sample &sample, uint8_t *record)
+{
+    uint8_t buffer[RECORD_SIZE] = {};
+    buffer[MARKER_OFFSET] = RECORD_MARKER;
+    std::memcpy(buffer + PRESENT_OFFSET, &sample.present, sizeof(sample.present));
+    std::memcpy(buffer + TIMESTAMP_OFFSET, &sample.timestamp, sizeof(sample.timestamp));
+    std::memcpy(buffer + VALUES_OFFSET, sample.values.data(), PARAMETER_COUNT * sizeof(float));
+    uint32_t crc = recordCrc(buffer);
+    std::memcpy(buffer + CRC_OFFSET, &crc, sizeof(crc));
+    std::memcpy(record, buffer, RECORD_SIZE);
+}
+
+bool SampleStore::decodeRecord(const uint8_t *record, Sample &sample)
+{
+    uint32_t crc;
+    std::memcpy(&crc, record + CRC_OFFSET, sizeof(crc));
+    if (record[MARKER_OFFSET] != RECORD_MARKER || crc != recordCrc(record))
+        return false;
+    std::memcpy(&sample.present, record + PRESENT_OFFSET, sizeof(sample.present));
+    std::memcpy(&sample.timestamp, record + TIMESTAMP_OFFSET, sizeof(sample.timestamp));
+    std::memcpy(sample.values.data(), record + VALUES_OFFSET, PARAMETER_COUNT * sizeof(float));
+    return true;
+}
+
+// ========== Segments ==========
+std::string SampleStore::segmentPath(uint64_t seq) const
+{
+    char name[32];
+    std::snprintf(name, sizeof(name), "seg-%016llx.dat", static_cast<unsigned long long>(seq));
+    return directory_ + "/" + name;
+}
+
+std::string SampleStore::cursorPath() const
+{
+    return directory_ + "/cursor";
+}
+
+size_t SampleStore::segmentBytes() const
+{
+    return HEADER_SIZE + recordsPerSegment_ * RECORD_SIZE;
+}
+
+bool SampleStore::createSegment(uint64_t seq)
+{
+    std::string path = segmentPath(seq);
+    int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        std::cerr << "Failed to create store segment " << path << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    SegmentHeader header{};
+    std::memcpy(header.magic, SEGMENT_MAGIC, sizeof(header.magic));
+    header.version = SEGMENT_VERSION;
+    header.recordSize = static_cast<uint16_t>(RECORD_SIZE);
+    header.recordsPerSegment = static_cast<uint32_t>(recordsPerSegment_);
+    header.seq = seq;
+
+    // The blocks are reserved up front: stores through the shared mapping into
+    // a sparse file would raise SIGBUS on a full disk instead of failing here.
+    // Records read back as zeros, which never pass the CRC check.
+    int error = ::posix_fallocate(fd, 0, static_cast<off_t>(segmentBytes()));
+    bool ok = error == 0 && ::pwrite(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header));
+    if (error == 0 && !ok)
+        error = errno;
+    ::close(fd);
+    if (!ok)
+    {
+        std::cerr << "Failed to size store segment " << path << ": " << std::strerror(error) << "\n";
+        ::unlink(path.c_str());
+        return false;
+    }
+
+    segments_.push_back(Segment{seq, 0, nullptr});
+    return mapSegment(segments_.back());
+}
+
+bool SampleStore::openSegment(uint64_t seq, Segment &segment)
+{
+    std::string path = segmentPath(seq);
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    SegmentHeader header{};
+    bool ok = ::fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) == segmentBytes() &&
+              ::pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+              std::memcmp(header.magic, SEGMENT_MAGIC, sizeof(header.magic)) == 0 &&
+              header.version == SEGMENT_VERSION && header.recordSize == RECORD_SIZE &&
+              header.recordsPerSegment == recordsPerSegment_ && header.seq == seq;
+    ::close(fd);
+
+    // Older segments were full when the next one was started
+    segment = Segment{seq, recordsPerSegment_, nullptr};
+    return ok;
+}
+
+bool SampleStore::mapSegment(Segment &segment)
+{
+    if (segment.map)
+        return true;
+    int fd = ::open(segmentPath(segment.seq).c_str(), O_RDWR);
+    if (fd < 0)
+        return false;
+    void *map = ::mmap(nullptr, segmentBytes(), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd); // The mapping keeps the file referenced
+    if (map == MAP_FAILED)
+    {
+        std::cerr << "Failed to map store segment " << segmentPath(segment.seq) << "\n";
+        return false;
+    }
+    segment.map = static_cast<uint8_t *>(map);
+    return true;
+}
+
+void SampleStore::unmapSegment(Segment &segment)
+{
+    if (!segment.map)
+        return;
+    ::munmap(segment.map, segmentBytes());
+    segment.map = nullptr;
+}
+
+void SampleStore::removeFront()
+{
+    Segment &front = segments_.front();
+    unmapSegment(front);
+    ::unlink(segmentPath(front.seq).c_str());
+    segments_.pop_front();
+    readIndex_ = 0;
+}
+
+// ========== Cursor ==========
+bool SampleStore::saveCursor()
+{
+    std::string content = std::to_string(segments_.front().seq) + " " + std::to_string(readIndex_) + "\n";
+    std::string tmpPath = cursorPath() + ".tmp";
+    int fd = ::open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+    bool ok = ::write(fd, content.data(), content.size()) == static_cast<ssize_t>(content.size()) &&
+              ::fsync(fd) == 0;
+    ::close(fd);
+
+    // Rename is atomic, so a crash leaves either the old or the new cursor
+    if (!ok || std::rename(tmpPath.c_str(), cursorPath().c_str()) != 0)
+    {
+        std::cerr << "Failed to persist store cursor in " << directory_ << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool SampleStore::loadCursor(uint64_t &seq, size_t &index) const
+{
+    std::ifstream file(cursorPath());
+    unsigned long long fileSeq, fileIndex;
+    if (!(file >> fileSeq >> fileIndex))
+        return false;
+    seq = fileSeq;
+    index = static_cast<size_t>(fileIndex);
+    return true;
+}
+
+// ========== Lifecycle ==========
+bool SampleStore::open()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (open_)
+        return true;
+
+    if (!makeDirectories(directory_))
+    {
+        std::cerr << "Failed to create store directory " << directory_ << ": " << std::strerror(errno) << "\n";
+        return false;
+    }
+
+    // Collect existing segments in sequence order
+    std::vector<uint64_t> seqs;
+    DIR *dir = ::opendir(directory_.c_str());
+    if (!dir)
+        return false;
+    while (dirent *entry = ::readdir(dir))
+    {
+        unsigned long long seq;
+        char tail[8];
+        if (std::strlen(entry->d_name) == 24 &&
+            std::sscanf(entry->d_name, "seg-%16llx%7s", &seq, tail) == 2 && std::strcmp(tail, ".dat") == 0)
+            seqs.push_back(seq);
+    }
+    ::closedir(dir);
+    std::sort(seqs.begin(), seqs.end());
+
+    segments_.clear();
+    readIndex_ = 0;
+    for (uint64_t seq : seqs)
+    {
+        Segment segment;
+        if (openSegment(seq, segment))
+            segments_.push_back(segment);
+        else
+            std::cerr << "Ignoring invalid store segment " << segmentPath(seq) << "\n";
+    }
+
+    // The newest segment ends at its first invalid record (torn or never written)
+    if (!segments_.empty())
+    {
+        Segment &last = segments_.back();
+        if (!mapSegment(last))
+            return false;
+        Sample sample;
+        last.records = 0;
+        while (last.records < recordsPerSegment_ &&
+               decodeRecord(last.map + HEADER_SIZE + last.records * RECORD_SIZE, sample))
+            last.records++;
+    }
+
+    // Segments before the cursor were already delivered
+    uint64_t cursorSeq = 0;
+    size_t cursorIndex = 0;
+    bool hasCursor = loadCursor(cursorSeq, cursorIndex);
+    if (hasCursor)
+    {
+        while (!segments_.empty() && segments_.front().seq < cursorSeq)
+            removeFront();
+        if (!segments_.empty() && segments_.front().seq == cursorSeq)
+            readIndex_ = std::min(cursorIndex, segments_.front().records);
+    }
+
+    if (segments_.empty() && !createSegment(hasCursor ? cursorSeq : 0))
+        return false;
+
+    while (segments_.size() > maxSegments_)
+    {
+        dropped_ += segments_.front().records - readIndex_;
+        removeFront();
+    }
+
+    peekValid_ = false;
+    open_ = true;
+    return true;
+}
+
+void SampleStore::close()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (Segment &segment : segments_)
+    {
+        if (segment.map)
+            ::msync(segment.map, segmentBytes(), MS_SYNC);
+        unmapSegment(segment);
+    }
+    segments_.clear();
+    peekValid_ = false;
+    open_ = false;
+}
+
+bool SampleStore::isOpen() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return open_;
+}
+
+// ========== Writing ==========
+bool SampleStore::append(const Sample &sample)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_)
+        return false;
+
+    if (segments_.back().records == recordsPerSegment_)
+    {
+        // Roll over: the full segment is only kept mapped while it is also being read
+        Segment &full = segments_.back();
+        uint64_t next = full.seq + 1;
+        if (full.map)
+            ::msync(full.map, segmentBytes(), MS_ASYNC);
+        if (segments_.size() > 1)
+            unmapSegment(full);
+
+        // At the disk cap the oldest unsent samples make room. Samples of an
+        // outstanding peek are already with the uploader and not counted; the
+        // peek stays valid, commit() skips over the missing front itself.
+        if (segments_.size() >= maxSegments_)
+        {
+            const Segment &front = segments_.front();
+            size_t unsent = readIndex_;
+            if (peekValid_)
+                unsent = peekSeq_ > front.seq ? front.records : std::max(readIndex_, peekIndex_);
+            dropped_ += front.records - unsent;
+            removeFront();
+        }
+        if (!createSegment(next))
+            return false;
+    }
+
+    Segment &segment = segments_.back();
+    if (!mapSegment(segment))
+        return false;
+    encodeRecord(sample, segment.map + HEADER_SIZE + segment.records * RECORD_SIZE);
+    segment.records++;
+    return true;
+}
+
+void SampleStore::flush()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (open_ && segments_.back().map)
+        ::msync(segments_.back().map, segmentBytes(), MS_SYNC);
+}
+
+// ========== Reading ==========
+size_t SampleStore::peek(SampleBatch &batch, size_t maxSamples)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    batch.clear();
+    peekValid_ = false;
+    if (!open_)
+        return 0;
+
+    size_t i = 0;
+    size_t index = readIndex_;
+    uint64_t corrupt = 0;
+    Sample sample;
+    while (batch.size() < maxSamples)
+    {
+        Segment &segment = segments_[i];
+        if (index >= segment.records)
+        {
+            if (i + 1 == segments_.size())
+                break;
+            ++i;
+            index = 0;
+            continue;
+        }
+        if (!mapSegment(segment))
+            break;
+        for (; index < segment.records && batch.size() < maxSamples; ++index)
+        {
+            if (decodeRecord(segment.map + HEADER_SIZE + index * RECORD_SIZE, sample))
+                batch.append(sample);
+            else
+                corrupt++;
+        }
+        // Only the read and write segments stay mapped
+        if (i != 0 && i + 1 != segments_.size())
+            unmapSegment(segment);
+    }
+
+    peekSeq_ = segments_[i].seq;
+    peekIndex_ = index;
+    peekCorrupt_ = corrupt;
+    peekValid_ = true;
+    return batch.size();
+}
+
+bool SampleStore::commit()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!open_)
+        return false;
+    if (!peekValid_)
+        return true;
+    peekValid_ = false;
+
+    // Segments dropped at the cap since the peek are gone already
+    if (peekSeq_ < segments_.front().seq)
+        return true;
+
+    while (segments_.front().seq < peekSeq_)
+        removeFront();
+    readIndex_ = peekIndex_;
+    if (segments_.size() > 1 && readIndex_ == segments_.front().records)
+        removeFront();
+    corrupt_ += peekCorrupt_;
+    return saveCursor();
+}
+
+// ========== Statistics ==========
+size_t SampleStore::size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t total = 0;
+    for (const Segment &segment : segments_)
+        total += segment.records;
+    return total - readIndex_;
+}
+
+size_t SampleStore::capacity() const
+{
+    return recordsPerSegment_ * maxSegments_;
+}
+
+size_t SampleStore::segmentCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return segments_.size();
+}
+
+uint64_t SampleStore::droppedCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return dropped_;
+}
+
+uint64_t SampleStore::corruptCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return corrupt_;
+}
@@ -0,0 +1,100 @@
+#ifndef SAMPLE_STORE_H
+#define SAMPLE_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include "PollingConfig.h"
+
+// Crash-safe, append-only sample store for riding out long uplink outages.
+//
+// Samples are kept as fixed 64-byte records (CRC-32 each) in memory-mapped
+// segment files seg-<seq>.dat inside one directory. The poller appends to the
+// newest segment; the uploader peeks a batch from the read cursor and commits
+// it once delivered, which persists the cursor (cursor file, atomic rename)
+// and deletes fully consumed segments. At most two segments are mapped at a
+// time, so RAM use does not grow with the backlog; disk use is capped at
+// maxSegments, after which the oldest unsent segment is dropped.
+//
+// On open the write position is recovered by scanning the newest segment up
+// to the first invalid record, so a torn write after a crash is discarded.
+class SampleStore
+{
+public:
+    static const size_t RECORD_SIZE = 64;
+    static const size_t HEADER_SIZE = 64;
+
+    SampleStore(const std::string &directory, size_t recordsPerSegment = 4096, size_t maxSegments = 64);
+    ~SampleStore();
+
+    SampleStore(const SampleStore &) = delete;
+    SampleStore &operator=(const SampleStore &) = delete;
+
+    // Create the directory if needed and recover existing segments and cursor
+    bool open();
+    void close();
+    bool isOpen() const;
+
+    bool append(const Sample &sample);
+
+    // Copy up to maxSamples unread samples into batch (cleared first) without
+    // consuming them; commit() consumes what the last peek returned
+    size_t peek(SampleBatch &batch, size_t maxSamples);
+    bool commit();
+
+    // Write dirty pages of the active segment back to storage
+    void flush();
+
+    size_t size() const;         // Unread records
+    size_t capacity() const;     // recordsPerSegment * maxSegments
+    size_t segmentCount() const;
+    uint64_t droppedCount() const; // Unread records lost to the segment cap
+    uint64_t corruptCount() const; // Records skipped on a CRC mismatch
+
+    const std::string &directory() const { return directory_; }
+
+private:
+    struct Segment
+    {
+        uint64_t seq;
+        size_t records; // Written records
+        uint8_t *map;   // Null while not mapped
+    };
+
+    std::string segmentPath(uint64_t seq) const;
+    std::string cursorPath() const;
+    size_t segmentBytes() const;
+
+    bool createSegment(uint64_t seq);
+    bool openSegment(uint64_t seq, Segment &segment);
+    bool mapSegment(Segment &segment);
+    void unmapSegment(Segment &segment);
+    void removeFront();
+    bool saveCursor();
+    bool loadCursor(uint64_t &seq, size_t &index) const;
+
+    static void encodeRecord(const Sample &sample, uint8_t *record);
+    static bool decodeRecord(const uint8_t *record, Sample &sample);
+
+    std::string directory_;
+    size_t recordsPerSegment_;
+    size_t maxSegments_;
+
+    mutable std::mutex mutex_;
+    bool open_ = false;
+    std::deque<Segment> segments_; // Oldest first, the back one is written
+    size_t readIndex_ = 0;         // Next unread record of the front segment
+
+    // End of the last peek, consumed by commit()
+    bool peekValid_ = false;
+    uint64_t peekSeq_ = 0;
+    size_t peekIndex_ = 0;
+    uint64_t peekCorrupt_ = 0;
+
+    uint64_t dropped_ = 0;
+    uint64_t corrupt_ = 0;
+};
+
+#endif
@@ -0,0 +1,271 @@
+#include "TcpTransport.h"
+#include "ModbusTcpSession.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// One pipelined session per gateway, shared by every transport talking to it
+static std::shared_ptr<ModbusTcpSession> sharedSession(const std::string &host, uint16_t port, size_t window,
+                                                       long timeoutMs)
+{
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<ModbusTcpSession>> sessions;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string key = host + ":" + std::to_string(port);
+    std::shared_ptr<ModbusTcpSession> session = sessions[key].lock();
+    if (!session)
+    {
+        session = std::make_shared<ModbusTcpSession>(host, port, window, timeoutMs);
+        sessions[key] = session;
+    }
+    return session;
+}
+
+// ========== Connection ==========
+TcpTransport::TcpTransport(TransportType framing, const std::string &host, uint16_t port, long timeoutMs,
+                           size_t window)
+    : framing_(framing), host_(host), port_(port), timeoutMs_(timeoutMs), connects_(0)
+{
+    if (framing_ == TransportType::MODBUS_TCP)
+        session_ = sharedSession(host_, port_, window, timeoutMs_);
+}
+
+TcpTransport::~TcpTransport()
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        stopping_ = true;
+    }
+    queueWake_.notify_all();
+    if (worker_.joinable())
+        worker_.join();
+
+    // Requests still waiting for their delay fail rather than vanish
+    for (auto &entry : jobs_)
+        entry.second.callback(false, FrameBuffer());
+
+    std::lock_guard<std::mutex> lock(connMutex_);
+    closeSocket();
+}
+
+int TcpTransport::openConnection(const std::string &host, uint16_t port, long timeoutMs)
+{
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *addresses = nullptr;
+    if (::getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses) != 0)
+    {
+        std::cerr << "Cannot resolve Modbus gateway " << host << "\n";
+        return -1;
+    }
+
+    int connected = -1;
+    for (addrinfo *ai = addresses; ai && connected < 0; ai = ai->ai_next)
+    {
+        int fd = ::socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0)
+            continue;
+
+        // Non-blocking connect bounded by the timeout
+        int flags = ::fcntl(fd, F_GETFL, 0);
+        ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        int rc = ::connect(fd, ai->ai_addr, ai->ai_addrlen);
+        if (rc < 0 && errno == EINPROGRESS)
+        {
+            pollfd pfd{fd, POLLOUT, 0};
+            int error = 0;
+            socklen_t len = sizeof(error);
+            rc = (::poll(&pfd, 1, timeoutMs > 0 ? static_cast<int>(timeoutMs) : -1) == 1 &&
+                  ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) == 0 && error == 0)
+                     ? 0
+                     : -1;
+        }
+        if (rc < 0)
+        {
+            ::close(fd);
+            continue;
+        }
+        ::fcntl(fd, F_SETFL, flags);
+
+        int noDelay = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        if (timeoutMs > 0)
+        {
+            timeval tv;
+            tv.tv_sec = timeoutMs / 1000;
+            tv.tv_usec = (timeoutMs % 1000) * 1000;
+            ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        }
+        connected = fd;
+    }
+    ::freeaddrinfo(addresses);
+
+    if (connected < 0)
+        std::cerr << "Cannot connect to Modbus gateway " << host << ":" << port << "\n";
+    return connected;
+}
+
+bool TcpTransport::connectSocket()
+{
+    fd_ = openConnection(host_, port_, timeoutMs_);
+    if (fd_ < 0)
+        return false;
+    connects_++;
+    return true;
+}
+
+uint64_t TcpTransport::connectCount() const
+{
+    return session_ ? session_->connectCount() : connects_.load();
+}
+
+void TcpTransport::closeSocket()
+{
+    if (fd_ >= 0)
+        ::close(fd_);
+    fd_ = -1;
+}
+
+bool TcpTransport::sendAll(const uint8_t *data, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t sent = ::send(fd_, data, len, MSG_NOSIGNAL);
+        if (sent <= 0)
+        {
+            peerClosed_ = sent < 0 && (errno == EPIPE || errno == ECONNRESET);
+            return false;
+        }
+        data += sent;
+        len -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+bool TcpTransport::receiveExact(uint8_t *data, size_t len)
+{
+    while (len > 0)
+    {
+        ssize_t got = ::recv(fd_, data, len, 0);
+        if (got <= 0)
+        {
+            peerClosed_ = got == 0 || errno == ECONNRESET;
+            return false;
+        }
+        data += got;
+        len -= static_cast<size_t>(got);
+        received_ += static_cast<size_t>(got);
+    }
+    return true;
+}
+
+// ========== Exchange ==========
+bool TcpTransport::transact(RequestType, const FrameBuffer &request, FrameBuffer &response)
+{
+    if (session_)
+        return session_->transact(request, response);
+
+    std::lock_guard<std::mutex> lock(connMutex_);
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        bool reused = fd_ >= 0;
+        if (!reused && !connectSocket())
+            return false;
+
+        peerClosed_ = false;
+        received_ = 0;
+        if (sendAll(request.data, request.size) && receiveRtuResponse(response))
+            return true;
+
+        // After a timeout or a framing error the stream position is unknown
+        closeSocket();
+
+        // An idle connection the gateway dropped is retried once on a fresh one
+        if (!(reused && peerClosed_ && received_ == 0))
+            return false;
+    }
+    return false;
+}
+
+void TcpTransport::transactAsync(RequestType, const FrameBuffer &request, FrameCallback callback,
+                                 std::chrono::milliseconds delay)
+{
+    if (session_)
+    {
+        session_->submit(request, std::move(callback), delay);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex_);
+        if (stopping_)
+        {
+            callback(false, FrameBuffer());
+            return;
+        }
+        jobs_.emplace(std::chrono::steady_clock::now() + delay, Job{request, std::move(callback)});
+        if (!worker_.joinable())
+            worker_ = std::thread(&TcpTransport::run, this);
+    }
+    queueWake_.notify_one();
+}
+
+void TcpTransport::run()
+{
+    std::unique_lock<std::mutex> lock(queueMutex_);
+    while (!stopping_)
+    {
+        if (jobs_.empty())
+        {
+            queueWake_.wait(lock);
+            continue;
+        }
+        auto due = jobs_.begin()->first;
+        if (due > std::chrono::steady_clock::now())
+        {
+            queueWake_.wait_until(lock, due);
+            continue;
+        }
+
+        Job job = std::move(jobs_.begin()->second);
+        jobs_.erase(jobs_.begin());
+        lock.unlock();
+
+        FrameBuffer response;
+        bool ok = transact(RequestType::READ, job.request, response);
+        job.callback(ok, response);
+
+        lock.lock();
+    }
+}
+
+// ========== Framing ==========
+bool TcpTransport::receiveRtuResponse(FrameBuffer &response)
+{
+    // Slave, function and the first data byte tell the frame length
+    size_t length = 0;
+    if (!receiveExact(response.data, 3))
+        return false;
+    if (!ModbusFrame::rtuResponseLength(response.data, 3, length) || length > MODBUS_MAX_ADU || length < 3)
+    {
+        std::cerr << "Unknown RTU response from Modbus gateway (function 0x" << std::hex
+                  << static_cast<int>(response.data[1]) << std::dec << ")\n";
+        return false;
+    }
+    if (!receiveExact(response.data + 3, length - 3))
+        return false;
+    response.size = length;
+    return true;
+}
@@ -0,0 +1,87 @@
+#ifndef TCP_TRANSPORT_H
+#define TCP_TRANSPORT_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include "Transport.h"
+
+class ModbusTcpSession;
+
+// Raw socket transport to a Modbus gateway over one persistent connection,
+// re-established transparently when the gateway has closed it.
+//
+// MODBUS_TCP frames requests with an MBAP header (transaction id, protocol 0,
+// length, unit id) and drops the CRC, which is recomputed on receipt. All
+// transports to the same gateway share one pipelined ModbusTcpSession, so up
+// to `window` transactions from any of them are outstanding at once.
+//
+// RTU_OVER_TCP sends RTU frames unchanged and delimits responses by function
+// code. RTU has no transaction id, so requests are exchanged one at a time;
+// asynchronous requests are run in order by a background thread started on
+// first use.
+class TcpTransport : public Transport
+{
+public:
+    TcpTransport(TransportType framing, const std::string &host, uint16_t port, long timeoutMs,
+                 size_t window = 1);
+    ~TcpTransport() override;
+
+    TcpTransport(const TcpTransport &) = delete;
+    TcpTransport &operator=(const TcpTransport &) = delete;
+
+    bool transact(RequestType type, const FrameBuffer &request, FrameBuffer &response) override;
+    void transactAsync(RequestType type, const FrameBuffer &request, FrameCallback callback,
+                       std::chrono::milliseconds delay = std::chrono::milliseconds(0)) override;
+    TransportType type() const override { return framing_; }
+
+    uint64_t connectCount() const;
+    // Session carrying MODBUS_TCP traffic, null for RTU_OVER_TCP
+    const std::shared_ptr<ModbusTcpSession> &session() const { return session_; }
+
+    // Blocking TCP connection with TCP_NODELAY and send/receive timeouts, -1 on failure
+    static int openConnection(const std::string &host, uint16_t port, long timeoutMs);
+
+private:
+    struct Job
+    {
+        FrameBuffer request;
+        FrameCallback callback;
+    };
+
+    bool connectSocket();
+    void closeSocket();
+    bool sendAll(const uint8_t *data, size_t len);
+    bool receiveExact(uint8_t *data, size_t len);
+
+    bool receiveRtuResponse(FrameBuffer &response);
+
+    void run();
+
+    TransportType framing_;
+    std::string host_;
+    uint16_t port_;
+    long timeoutMs_;
+    std::shared_ptr<ModbusTcpSession> session_;
+
+    // RTU connection state, guarded by connMutex_
+    std::mutex connMutex_;
+    int fd_ = -1;
+    bool peerClosed_ = false; // The last failure was the gateway closing the connection
+    size_t received_ = 0;     // Bytes received for the current response
+    std::atomic<uint64_t> connects_;
+
+    // Asynchronous requests ordered by due time
+    std::mutex queueMutex_;
+    std::condition_variable queueWake_;
+    std::multimap<std::chrono::steady_clock::time_point, Job> jobs_;
+    bool stopping_ = false;
+    std::thread worker_;
+};
+
+#endif
@@ -0,0 +1,61 @@
+#include "Transport.h"
+#include "Config.h"
+#include "TcpTransport.h"
+#include <iostream>
+
+// ========== Factory ==========
+std::unique_ptr<Transport> Transport::create(const Endpoint &endpoint)
+{
+    Config &config = Config::getInstance();
+    switch (endpoint.transport)
+    {
+    case TransportType::MODBUS_TCP:
+    case TransportType::RTU_OVER_TCP:
+        return std::unique_ptr<Transport>(
+            new TcpTransport(endpoint.transport, endpoint.host, endpoint.port, config.getTransportTimeoutMs(),
+                             config.getTransportWindow()));
+    case TransportType::HTTP:
+        break;
+    }
+    return std::unique_ptr<Transport>(new HttpTransport(endpoint));
+}
+
+Endpoint Transport::endpointFromConfig()
+{
+    Config &config = Config::getInstance();
+
+    // Load config if not already loaded
+    if (!config.isLoaded() && !config.loadFromFile())
+        std::cerr << "Error: Failed to load transport configuration" << std::endl;
+
+    Endpoint endpoint;
+    endpoint.apiKey = config.getApiKey();
+    endpoint.readUrl = config.getReadUrl();
+    endpoint.writeUrl = config.getWriteUrl();
+    endpoint.transport = parseTransportType(config.getTransportType(), TransportType::HTTP);
+    endpoint.host = config.getTransportHost();
+    endpoint.port = config.getTransportPort();
+    return endpoint;
+}
+
+// ========== HTTP ==========
+HttpTransport::HttpTransport(const Endpoint &endpoint)
+    : adapter_(endpoint) {}
+
+// The adapter hex-encodes the request straight into the JSON body and decodes
+// the response hex into the caller's frame as it streams in; undecodable hex
+// is handed on as a blank frame
+bool HttpTransport::transact(RequestType type, const FrameBuffer &request, FrameBuffer &response)
+{
+    return type == RequestType::WRITE ? adapter_.sendWriteRequest(request, response)
+                                      : adapter_.sendReadRequest(request, response);
+}
+
+void HttpTransport::transactAsync(RequestType type, const FrameBuffer &request, FrameCallback callback,
+                                  std::chrono::milliseconds delay)
+{
+    if (type == RequestType::WRITE)
+        adapter_.sendWriteRequestAsync(request, std::move(callback), delay);
+    else
+        adapter_.sendReadRequestAsync(request, std::move(callback), delay);
+}
@@ -0,0 +1,55 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include "Metrics.h"
+#include "ModbusFrame.h"
+#include "ProtocolAdapter.h"
+
+// Completion callback of an asynchronous exchange. On ok, response holds the
+// RTU frame received (size 0 for a blank answer); it is only valid during the call.
+typedef std::function<void(bool ok, const FrameBuffer &response)> FrameCallback;
+
+// Carries one Modbus RTU request frame (slave + PDU + CRC) to the device and
+// returns its response in the same form, whatever the wire format is.
+// Returns false on a transport failure (connection, timeout, HTTP error).
+class Transport
+{
+public:
+    virtual ~Transport() = default;
+
+    // The request type selects the endpoint where the wire format has several
+    virtual bool transact(RequestType type, const FrameBuffer &request, FrameBuffer &response) = 0;
+
+    // Non-blocking variant; a non-zero delay holds the request back (retry backoff)
+    virtual void transactAsync(RequestType type, const FrameBuffer &request, FrameCallback callback,
+                               std::chrono::milliseconds delay = std::chrono::milliseconds(0)) = 0;
+
+    virtual TransportType type() const = 0;
+
+    // Backend matching endpoint.transport
+    static std::unique_ptr<Transport> create(const Endpoint &endpoint);
+
+    // Endpoint described by [API], [ENDPOINTS] and [TRANSPORT] in config.ini
+    static Endpoint endpointFromConfig();
+};
+
+// Hex frames wrapped in JSON and POSTed to the Inverter SIM API
+class HttpTransport : public Transport
+{
+public:
+    explicit HttpTransport(const Endpoint &endpoint);
+
+    bool transact(RequestType type, const FrameBuffer &request, FrameBuffer &response) override;
+    void transactAsync(RequestType type, const FrameBuffer &request, FrameCallback callback,
+                       std::chrono::milliseconds delay = std::chrono::milliseconds(0)) override;
+    TransportType type() const override { return TransportType::HTTP; }
+
+private:
+    ProtocolAdapter adapter_;
+};
+
+#endif
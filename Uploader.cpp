@@ -0,0 +1,73 @@
+#include "Uploader.h"
+#include "CurlHandlePool.h"
+#include <iostream>
+#include <thread>
+
+Uploader::Uploader(const std::string &url, const std::string &apiKey, long timeoutMs, const RetrySettings &retry)
+    : url_(url),
+      pool_(new CurlHandlePool(apiKey, 1, timeoutMs, "application/octet-stream")),
+      retry_(retry),
+      uploadedBatches_(0),
+      uploadedBytes_(0),
+      failedBatches_(0),
+      rejectedBatches_(0) {}
+
+Uploader::~Uploader() = default;
+
+long Uploader::post(const std::vector<uint8_t> &payload)
+{
+    CurlHandlePool::Lease handle(*pool_);
+    if (!handle.get())
+        return 0;
+
+    handle->body.assign(reinterpret_cast<const char *>(payload.data()), payload.size());
+    handle->response.clear();
+
+    CURL *curl = handle->curl;
+    curl_easy_setopt(curl, CURLOPT_URL, url_.c_str());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, handle->body.data());
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(handle->body.size()));
+
+    if (curl_easy_perform(curl) != CURLE_OK)
+        return 0;
+    long status = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    return status;
+}
+
+UploadResult Uploader::upload(const std::vector<uint8_t> &payload)
+{
+    auto started = std::chrono::steady_clock::now();
+    for (int attempt = 1;; ++attempt)
+    {
+        long status = post(payload);
+        if (status >= 200 && status < 300)
+        {
+            uploadedBatches_++;
+            uploadedBytes_ += payload.size();
+            return UploadResult::DELIVERED;
+        }
+
+        if (status == 0)
+            std::cerr << "Upload request failed (attempt " << attempt << ")\n";
+        else
+            std::cerr << "Upload rejected with HTTP " << status << " (attempt " << attempt << ")\n";
+
+        // Only these answers blame the payload itself; a wrong URL, an expired
+        // key or a redirect is a setup problem and must not cost the batch
+        if (status == 400 || status == 413 || status == 422)
+        {
+            failedBatches_++;
+            rejectedBatches_++;
+            return UploadResult::REJECTED;
+        }
+        // Retrying within this call only helps while the server is overloaded or unreachable
+        bool transient = status == 0 || status == 429 || status >= 500;
+        std::chrono::milliseconds delay;
+        if (!transient || !retry_.nextRetry(attempt, AttemptOutcome::TRANSPORT_FAILURE, 0, started, delay))
+            break;
+        std::this_thread::sleep_for(delay);
+    }
+    failedBatches_++;
+    return UploadResult::FAILED;
+}
@@ -0,0 +1,53 @@
+#ifndef UPLOADER_H
+#define UPLOADER_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "RetryPolicy.h"
+
+class CurlHandlePool;
+
+enum class UploadResult
+{
+    DELIVERED,
+    FAILED,  // Anything but a payload refusal (transport errors, 3xx, 401/403/404, 429, 5xx); may succeed later
+    REJECTED // 400, 413 or 422: the payload itself was refused, sending it again will not help
+};
+
+// POSTs encoded sample batches (application/octet-stream) to the upload
+// endpoint over a persistent connection. Transport errors, 429 and 5xx
+// responses are retried with the backoff of the given retry settings.
+class Uploader
+{
+public:
+    Uploader(const std::string &url, const std::string &apiKey, long timeoutMs, const RetrySettings &retry);
+    ~Uploader();
+
+    Uploader(const Uploader &) = delete;
+    Uploader &operator=(const Uploader &) = delete;
+
+    UploadResult upload(const std::vector<uint8_t> &payload);
+
+    uint64_t uploadedBatches() const { return uploadedBatches_.load(); }
+    uint64_t uploadedBytes() const { return uploadedBytes_.load(); }
+    uint64_t failedBatches() const { return failedBatches_.load(); } // Including rejected ones
+    uint64_t rejectedBatches() const { return rejectedBatches_.load(); }
+
+private:
+    // HTTP status of one POST, 0 on transport failure
+    long post(const std::vector<uint8_t> &payload);
+
+    std::string url_;
+    std::unique_ptr<CurlHandlePool> pool_;
+    RetryPolicy retry_;
+
+    std::atomic<uint64_t> uploadedBatches_;
+    std::atomic<uint64_t> uploadedBytes_;
+    std::atomic<uint64_t> failedBatches_;
+    std::atomic<uint64_t> rejectedBatches_;
+};
+
+#endif
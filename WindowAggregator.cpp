@@ -0,0 +1,129 @@
+#include "WindowAggregator.h"
+
+namespace
+{
+    const double MS_PER_HOUR = 3600.0 * 1000.0;
+
+    // Energy in Wh of a linear power ramp between two readings
+    inline double trapezoidWh(float fromW, long long fromMs, float toW, long long toMs)
+    {
+        return (static_cast<double>(fromW) + toW) * 0.5 * static_cast<double>(toMs - fromMs) / MS_PER_HOUR;
+    }
+}
+
+WindowAggregator::WindowAggregator(std::chrono::milliseconds window, size_t capacity)
+    : window_(window.count() > 0 ? window.count() : 1), closed_(capacity), dropped_(0) {}
+
+void WindowAggregator::add(const Sample &sample)
+{
+    const long long ts = sample.timestamp;
+    const long long start = ts - ((ts % window_) + window_) % window_;
+
+    // Energy of the power segment ending at this sample; the share before
+    // this sample's window start belongs to the window it crosses out of
+    const bool hasPower = sample.hasValue(ParameterType::OUTPUT_POWER);
+    const float power = sample.getValue(ParameterType::OUTPUT_POWER);
+    double before = 0.0;
+    double after = 0.0;
+    if (hasPower && hasPower_ && ts > powerAt_ && ts - powerAt_ <= window_)
+    {
+        if (powerAt_ >= start)
+            after = trapezoidWh(power_, powerAt_, power, ts);
+        else
+        {
+            float atBoundary = power_ + (power - power_) * static_cast<float>(start - powerAt_) /
+                                            static_cast<float>(ts - powerAt_);
+            before = trapezoidWh(power_, powerAt_, atBoundary, start);
+            after = trapezoidWh(atBoundary, start, power, ts);
+        }
+    }
+
+    if (open_ && start != start_)
+    {
+        energyWh_ += before;
+        before = 0.0;
+        close();
+    }
+    if (!open_)
+        open(start);
+    // A reading from before an already closed window still counts here
+    energyWh_ += before + after;
+    if (hasPower)
+    {
+        hasPower_ = true;
+        power_ = power;
+        powerAt_ = ts;
+    }
+
+    samples_++;
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+    {
+        const ParameterMask bit = static_cast<ParameterMask>(1u << i);
+        if (!(sample.present & bit))
+            continue;
+        const float value = sample.values[i];
+        if (!(present_ & bit))
+        {
+            min_[i] = value;
+            max_[i] = value;
+        }
+        else
+        {
+            min_[i] = value < min_[i] ? value : min_[i];
+            max_[i] = value > max_[i] ? value : max_[i];
+        }
+        last_[i] = value;
+        sum_[i] += value;
+        count_[i]++;
+        present_ |= bit;
+    }
+}
+
+void WindowAggregator::flush()
+{
+    if (open_)
+        close();
+}
+
+size_t WindowAggregator::drainInto(std::vector<WindowAggregate> &out)
+{
+    out.clear();
+    return closed_.consume([&out](WindowAggregate &aggregate)
+                           { out.push_back(aggregate); });
+}
+
+void WindowAggregator::open(long long start)
+{
+    open_ = true;
+    start_ = start;
+    samples_ = 0;
+    present_ = 0;
+    min_.fill(0.0f);
+    max_.fill(0.0f);
+    last_.fill(0.0f);
+    sum_.fill(0.0);
+    count_.fill(0);
+    energyWh_ = 0.0;
+}
+
+void WindowAggregator::close()
+{
+    WindowAggregate aggregate;
+    aggregate.start = start_;
+    aggregate.end = start_ + window_;
+    aggregate.samples = samples_;
+    aggregate.present = present_;
+    aggregate.min = min_;
+    aggregate.max = max_;
+    aggregate.last = last_;
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+    {
+        if (count_[i] > 0)
+            aggregate.mean[i] = static_cast<float>(sum_[i] / count_[i]);
+    }
+    aggregate.energyWh = energyWh_;
+    open_ = false;
+
+    if (!closed_.tryPush(std::move(aggregate)))
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+}
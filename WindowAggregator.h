@@ -0,0 +1,87 @@
+#ifndef WINDOW_AGGREGATOR_H
+#define WINDOW_AGGREGATOR_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "PollingConfig.h"
+#include "RingBuffer.h"
+
+// Statistics of one aggregation window
+struct WindowAggregate
+{
+    long long start = 0; // Sample timestamps in ms, end exclusive
+    long long end = 0;
+    uint32_t samples = 0;      // Polls that fell into the window
+    ParameterMask present = 0; // Parameters seen at least once
+    std::array<float, PARAMETER_COUNT> min{};
+    std::array<float, PARAMETER_COUNT> max{};
+    std::array<float, PARAMETER_COUNT> mean{};
+    std::array<float, PARAMETER_COUNT> last{};
+    double energyWh = 0.0; // OUTPUT_POWER integrated over the window
+
+    bool hasValue(ParameterType param) const
+    {
+        return (present & parameterBit(param)) != 0;
+    }
+};
+
+// Windowed aggregation stage between a device's poller and the uploader.
+//
+// Samples are folded into fixed windows aligned to multiples of the window
+// length; every update is O(1) (running min, max, sum and last per parameter)
+// so the poll rate does not matter. OUTPUT_POWER is integrated into energy
+// with the trapezoidal rule between consecutive readings, the segment
+// crossing a window boundary being split at the interpolated power there.
+// Readings further apart than one window are not integrated (device down).
+//
+// A window closes when the first sample of a later window arrives and is
+// queued for the uploader. One poller and one uploader thread.
+class WindowAggregator
+{
+public:
+    WindowAggregator(std::chrono::milliseconds window, size_t capacity);
+
+    // Poller side
+    void add(const Sample &sample);
+    // Close the open window early (shutdown)
+    void flush();
+
+    // Uploader side: move every closed window into out (cleared first)
+    size_t drainInto(std::vector<WindowAggregate> &out);
+
+    std::chrono::milliseconds window() const { return std::chrono::milliseconds(window_); }
+    size_t size() const { return closed_.size(); }
+    size_t capacity() const { return closed_.capacity(); }
+    uint64_t droppedCount() const { return dropped_.load(std::memory_order_relaxed); } // Queue was full
+
+private:
+    void open(long long start);
+    void close();
+
+    long long window_;
+
+    // Open window
+    bool open_ = false;
+    long long start_ = 0;
+    uint32_t samples_ = 0;
+    ParameterMask present_ = 0;
+    std::array<float, PARAMETER_COUNT> min_{};
+    std::array<float, PARAMETER_COUNT> max_{};
+    std::array<float, PARAMETER_COUNT> last_{};
+    std::array<double, PARAMETER_COUNT> sum_{};
+    std::array<uint32_t, PARAMETER_COUNT> count_{};
+    double energyWh_ = 0.0;
+
+    // Previous power reading, carried across windows for the integration
+    bool hasPower_ = false;
+    float power_ = 0.0f;
+    long long powerAt_ = 0;
+
+    SpscRingBuffer<WindowAggregate> closed_;
+    std::atomic<uint64_t> dropped_;
+};
+
+#endif
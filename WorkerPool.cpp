@@ -0,0 +1,64 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(size_t threads)
+{
+    if (threads == 0)
+        threads = 1;
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i)
+        workers_.emplace_back(&WorkerPool::workerLoop, this);
+}
+
+WorkerPool::~WorkerPool()
+{
+    shutdown();
+}
+
+bool WorkerPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_)
+            return false;
+        tasks_.push_back(std::move(task));
+    }
+    available_.notify_one();
+    return true;
+}
+
+void WorkerPool::shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    available_.notify_all();
+    for (auto &worker : workers_)
+    {
+        if (worker.joinable())
+            worker.join();
+    }
+}
+
+size_t WorkerPool::threadCount() const
+{
+    return workers_.size();
+}
+
+void WorkerPool::workerLoop()
+{
+    while (true)
+    {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            available_.wait(lock, [this]()
+                            { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty())
+                return; // Stopping and fully drained
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
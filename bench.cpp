@@ -0,0 +1,630 @@
+/*
+ * EcoWatt Benchmark Suite
+ *
+ * Microbenchmarks for the hot paths of the polling stack, plus macro
+ * benchmarks that drive ModbusHandler and the full poll/upload pipeline
+ * against the embedded Inverter SIM. Build with optimisation enabled
+ * (make bench) and compare the numbers before and after every optimisation.
+ *
+ * Usage: ./bench [--micro | --macro]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "DataBuffer.h"
+#include "Inverter.h"
+#include "InverterSimServer.h"
+#include "JsonFrame.h"
+#include "ModbusCRC.h"
+#include "ModbusFrame.h"
+#include "ModbusHandler.h"
+#include "PollPlanner.h"
+#include "PollingConfig.h"
+#include "RegisterCodec.h"
+#include "RegisterMap.h"
+#include "SampleEncoder.h"
+#include "TcpTransport.h"
+#include "WindowAggregator.h"
+
+// Prevents the optimiser from discarding benchmark results
+static volatile uint32_t g_sink;
+
+// Run fn repeatedly for roughly minMs and return nanoseconds per call
+template <typename Fn>
+double timeIt(Fn fn, int minMs = 200)
+{
+    using clock = std::chrono::steady_clock;
+    long long iterations = 0;
+    long long batch = 1;
+    auto start = clock::now();
+    auto elapsed = clock::duration::zero();
+    while (elapsed < std::chrono::milliseconds(minMs))
+    {
+        for (long long i = 0; i < batch; ++i)
+            fn();
+        iterations += batch;
+        batch *= 2;
+        elapsed = clock::now() - start;
+    }
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+static void report(const std::string &name, double nsPerOp, size_t bytes = 0)
+{
+    std::cout << "  " << std::left << std::setw(36) << name << std::right
+              << std::fixed << std::setprecision(1) << std::setw(10) << nsPerOp << " ns/op";
+    if (bytes > 0)
+        std::cout << std::setw(10) << std::setprecision(0) << (bytes / nsPerOp) * 1000.0 << " MB/s";
+    std::cout << std::endl;
+}
+
+// Sorted latency samples of one macro benchmark run
+static double percentile(const std::vector<double> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0.0;
+    size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+static void reportLatency(const std::string &name, std::vector<double> latenciesUs, double seconds,
+                          const char *unit = "req/s")
+{
+    std::sort(latenciesUs.begin(), latenciesUs.end());
+    std::cout << "  " << std::left << std::setw(36) << name << std::right << std::fixed
+              << std::setprecision(0) << std::setw(9) << latenciesUs.size() / seconds << " " << unit
+              << std::setprecision(1)
+              << "  p50 " << std::setw(7) << percentile(latenciesUs, 0.50) << " us"
+              << "  p99 " << std::setw(7) << percentile(latenciesUs, 0.99) << " us"
+              << "  p999 " << std::setw(7) << percentile(latenciesUs, 0.999) << " us" << std::endl;
+}
+
+static double microsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ========== CRC-16 ==========
+void benchCRC()
+{
+    std::cout << "\n=== CRC-16 (bitwise vs table vs slicing-by-8) ===" << std::endl;
+
+    // 6 bytes: request frame body, 255 bytes: largest FC03 response, 64 KiB: capture replay
+    const size_t sizes[] = {6, 255, 65536};
+    for (size_t size : sizes)
+    {
+        std::vector<uint8_t> data(size);
+        for (size_t i = 0; i < size; ++i)
+            data[i] = static_cast<uint8_t>(i * 31 + 7);
+
+        if (ModbusCRC::bitwise(data.data(), size) != ModbusCRC::table(data.data(), size) ||
+            ModbusCRC::bitwise(data.data(), size) != ModbusCRC::slicing8(data.data(), size))
+        {
+            std::cout << "  MISMATCH between CRC implementations for " << size << " bytes" << std::endl;
+            continue;
+        }
+
+        std::string suffix = " (" + std::to_string(size) + " B)";
+        report("bitwise" + suffix, timeIt([&]()
+                                          { g_sink += ModbusCRC::bitwise(data.data(), size); }),
+               size);
+        report("table" + suffix, timeIt([&]()
+                                        { g_sink += ModbusCRC::table(data.data(), size); }),
+               size);
+        report("slicing8" + suffix, timeIt([&]()
+                                           { g_sink += ModbusCRC::slicing8(data.data(), size); }),
+               size);
+    }
+}
+
+// ========== Frame codec ==========
+void benchFrameCodec()
+{
+    std::cout << "\n=== Frame build / parse ===" << std::endl;
+
+    report("build FC03 request + hex encode", timeIt([]()
+                                                     {
+                                                         FrameBuffer frame;
+                                                         HexFrame hex;
+                                                         ModbusFrame::buildReadRequest(0x11, 0, 10, frame);
+                                                         ModbusFrame::encodeHex(frame, hex);
+                                                         g_sink += static_cast<uint8_t>(hex.data[12]); }));
+
+    // 10-register response as returned by the API
+    uint16_t regs[10] = {2300, 52, 5000, 3500, 3400, 80, 75, 425, 20, 1200};
+    FrameBuffer response;
+    response.data[response.size++] = 0x11;
+    response.data[response.size++] = 0x03;
+    response.data[response.size++] = 20;
+    for (uint16_t r : regs)
+    {
+        response.data[response.size++] = static_cast<uint8_t>(r >> 8);
+        response.data[response.size++] = static_cast<uint8_t>(r & 0xFF);
+    }
+    ModbusFrame::appendCRC(response);
+    HexFrame responseHex;
+    ModbusFrame::encodeHex(response, responseHex);
+    const std::string hex(responseHex.data, responseHex.size);
+
+    report("hex decode + CRC + parse (10 regs)", timeIt([&]()
+                                                        {
+                                                            FrameBuffer frame;
+                                                            uint16_t values[10];
+                                                            ModbusFrame::decodeHex(hex.data(), hex.size(), frame);
+                                                            bool crcOk = ModbusFrame::receivedCRC(frame.data, frame.size) ==
+                                                                         ModbusCRC::compute(frame.data, frame.size - 2);
+                                                            ModbusFrame::parseReadResponse(frame.data, frame.size, 10, values);
+                                                            g_sink += values[9] + crcOk; }));
+
+    // HTTP API envelope: request body out, "frame" field of the response back
+    // to binary. The string path is what post_json did before streaming.
+    FrameBuffer request;
+    ModbusFrame::buildReadRequest(0x11, 0, 10, request);
+    const std::string reply = "{\"frame\":\"" + hex + "\",\"status\":\"ok\"}";
+    report("JSON envelope (string find)", timeIt([&]()
+                                                 {
+                                                     HexFrame requestHex;
+                                                     ModbusFrame::encodeHex(request, requestHex);
+                                                     std::string body = "{\"frame\":\"" + std::string(requestHex.data, requestHex.size) + "\"}";
+                                                     std::string received;
+                                                     received.append(reply.data(), reply.size());
+                                                     std::string frameHex;
+                                                     auto pos = received.find("\"frame\":\"");
+                                                     if (pos != std::string::npos)
+                                                     {
+                                                         pos += 9;
+                                                         frameHex.assign(received, pos, received.find('"', pos) - pos);
+                                                     }
+                                                     FrameBuffer frame;
+                                                     ModbusFrame::decodeHex(frameHex.data(), frameHex.size(), frame);
+                                                     g_sink += frame.data[4] + static_cast<uint8_t>(body[12]); }));
+    report("JSON envelope (streaming)", timeIt([&]()
+                                               {
+                                                   JsonFrameBody body;
+                                                   body.build(request);
+                                                   FrameBuffer frame;
+                                                   JsonFrameExtractor extractor(frame);
+                                                   extractor.feed(reply.data(), reply.size());
+                                                   g_sink += frame.data[4] + static_cast<uint8_t>(body.data[12]); }));
+}
+
+// ========== Sample ==========
+void benchSample()
+{
+    std::cout << "\n=== Sample set / get ===" << std::endl;
+
+    report("set 10 parameters", timeIt([]()
+                                       {
+                                           Sample sample;
+                                           for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+                                               sample.setValue(static_cast<ParameterType>(i), static_cast<float>(i));
+                                           g_sink += sample.present; }));
+
+    Sample full;
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+        full.setValue(static_cast<ParameterType>(i), static_cast<float>(i) * 1.5f);
+    report("get 10 parameters", timeIt([&]()
+                                       {
+                                           float sum = 0.0f;
+                                           for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+                                               sum += full.getValue(static_cast<ParameterType>(i));
+                                           g_sink += static_cast<uint32_t>(sum); }));
+
+    // All ten parameters of the built-in register map from one block read
+    RegisterMap registerMap;
+    PollingConfig config(registerMap);
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+        config.addParameter(static_cast<ParameterType>(i));
+    PollPlanner planner(config);
+    const ReadBlock &block = planner.currentPlan().front();
+    std::vector<uint16_t> registers(block.numRegs, 2301);
+    report("decode 10-register block", timeIt([&]()
+                                              {
+                                                  Sample sample;
+                                                  PollPlanner::decodeBlock(block, registers, sample);
+                                                  g_sink += sample.present; }));
+    report("decode 10-register fixed layout", timeIt([&]()
+                                                     {
+                                                         Sample sample;
+                                                         SimRegisterLayout::decode(registers.data(), sample);
+                                                         g_sink += sample.present; }));
+}
+
+// ========== Data buffer ==========
+void benchDataBuffer()
+{
+    std::cout << "\n=== DataBuffer append / flush ===" << std::endl;
+
+    const size_t capacity = 1024;
+    Sample sample;
+    sample.setValue(ParameterType::AC_VOLTAGE, 230.0f);
+    sample.setValue(ParameterType::AC_CURRENT, 5.2f);
+
+    // Per-sample cost of filling the buffer and draining it into a reused batch
+    DataBuffer spsc(capacity);
+    SampleBatch batch;
+    report("SPSC append + drain (per sample)", timeIt([&]()
+                                                      {
+                                                          for (size_t i = 0; i < capacity; ++i)
+                                                              spsc.append(sample);
+                                                          g_sink += static_cast<uint32_t>(spsc.drainInto(batch)); }) /
+                                                   capacity);
+
+    SharedDataBuffer mpsc(capacity);
+    report("MPSC append + drain (per sample)", timeIt([&]()
+                                                      {
+                                                          for (size_t i = 0; i < capacity; ++i)
+                                                              mpsc.append(sample);
+                                                          g_sink += static_cast<uint32_t>(mpsc.drainInto(batch)); }) /
+                                                   capacity);
+
+    report("SPSC append + flush (per sample)", timeIt([&]()
+                                                      {
+                                                          for (size_t i = 0; i < capacity; ++i)
+                                                              spsc.append(sample);
+                                                          g_sink += static_cast<uint32_t>(spsc.flush().size()); }) /
+                                                   capacity);
+
+    // Aggregation instead of buffering: one O(1) fold per sample, all ten parameters
+    WindowAggregator aggregator(std::chrono::milliseconds(60000), capacity);
+    std::vector<WindowAggregate> windows;
+    Sample full;
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+        full.setValue(static_cast<ParameterType>(i), 100.0f + i);
+    report("WindowAggregator add (per sample)", timeIt([&]()
+                                                       {
+                                                           for (size_t i = 0; i < capacity; ++i)
+                                                           {
+                                                               full.timestamp += 1000;
+                                                               full.values[9] = static_cast<float>(i & 0xFF);
+                                                               aggregator.add(full);
+                                                           }
+                                                           g_sink += static_cast<uint32_t>(aggregator.drainInto(windows)); }) /
+                                                    capacity);
+}
+
+// ========== Macro: ModbusHandler against the local SIM ==========
+void benchSampleEncoder()
+{
+    std::cout << "\n=== SampleEncoder (30-sample batch) ===" << std::endl;
+
+    PollingConfig config;
+    SampleEncoder encoder(config);
+    SampleBatch batch;
+    for (int i = 0; i < 30; ++i)
+    {
+        Sample sample;
+        sample.timestamp = 1700000000000LL + i * 5000;
+        sample.setValue(ParameterType::AC_VOLTAGE, 230.0f + (i % 4) * 0.1f);
+        sample.setValue(ParameterType::AC_CURRENT, 5.2f + (i % 2) * 0.1f);
+        sample.setValue(ParameterType::AC_FREQUENCY, 50.0f);
+        batch.append(sample);
+    }
+
+    std::vector<uint8_t> out;
+    SampleBatch decoded;
+    uint8_t deviceId;
+    encoder.encode(batch, 0x11, out, false);
+    size_t plainSize = out.size();
+    report("encode", timeIt([&]()
+                            {
+                                encoder.encode(batch, 0x11, out, false);
+                                g_sink += static_cast<uint32_t>(out.size()); }));
+    report("decode", timeIt([&]()
+                            {
+                                encoder.decode(out.data(), out.size(), decoded, deviceId);
+                                g_sink += static_cast<uint32_t>(decoded.size()); }));
+    encoder.encode(batch, 0x11, out, true);
+    std::cout << "  " << plainSize << " bytes encoded, " << out.size() << " bytes compressed" << std::endl;
+    report("encode + zlib", timeIt([&]()
+                                   {
+                                       encoder.encode(batch, 0x11, out, true);
+                                       g_sink += static_cast<uint32_t>(out.size()); }));
+}
+
+void benchReadRegisters(InverterSimServer &sim, const Endpoint &endpoint)
+{
+    std::cout << "\n=== ModbusHandler::readRegisters (local SIM, " << sim.port() << ") ===" << std::endl;
+
+    const auto duration = std::chrono::seconds(2);
+    ModbusHandler handler(endpoint);
+    handler.setReadCoalescing(false); // Every read on the wire; see benchReadCoalescing
+
+    // Closed loop: each thread issues the next read as soon as the previous one returns
+    const int threadCounts[] = {1, 4};
+    for (int threads : threadCounts)
+    {
+        std::vector<std::vector<double>> perThread(threads);
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now();
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t]()
+                                 {
+                                     std::vector<uint16_t> values;
+                                     while (std::chrono::steady_clock::now() - start < duration)
+                                     {
+                                         auto begin = std::chrono::steady_clock::now();
+                                         if (handler.readRegisters(0, 10, values))
+                                             perThread[t].push_back(microsSince(begin));
+                                     } });
+        }
+        for (auto &w : workers)
+            w.join();
+        double seconds = microsSince(start) / 1e6;
+
+        std::vector<double> all;
+        for (auto &v : perThread)
+            all.insert(all.end(), v.begin(), v.end());
+        reportLatency("sync, " + std::to_string(threads) + " thread(s)", all, seconds);
+    }
+
+    // Pipelined: keep a window of asynchronous reads in flight on one thread
+    const size_t window = 16;
+    std::vector<double> latencies;
+    std::vector<std::future<ReadResult>> inFlight;
+    std::vector<std::chrono::steady_clock::time_point> issued;
+    auto start = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - start < duration)
+    {
+        inFlight.clear();
+        issued.clear();
+        for (size_t i = 0; i < window; ++i)
+        {
+            issued.push_back(std::chrono::steady_clock::now());
+            inFlight.push_back(handler.readRegistersAsync(0, 10));
+        }
+        for (size_t i = 0; i < window; ++i)
+        {
+            if (inFlight[i].get().ok)
+                latencies.push_back(microsSince(issued[i]));
+        }
+    }
+    reportLatency("async, window " + std::to_string(window), latencies, microsSince(start) / 1e6);
+}
+
+// ========== Macro: poll / upload pipeline ==========
+void benchTransports(InverterSimServer &sim)
+{
+    std::cout << "\n=== Transport backends (sync readRegisters, 1 thread) ===" << std::endl;
+
+    const auto duration = std::chrono::seconds(2);
+    const TransportType types[] = {TransportType::HTTP, TransportType::MODBUS_TCP, TransportType::RTU_OVER_TCP};
+    for (TransportType type : types)
+    {
+        ModbusHandler handler(sim.endpoint(type));
+        std::vector<uint16_t> values;
+        std::vector<double> latencies;
+        auto start = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - start < duration)
+        {
+            auto begin = std::chrono::steady_clock::now();
+            if (handler.readRegisters(0, 10, values))
+                latencies.push_back(microsSince(begin));
+        }
+        reportLatency(transportTypeName(type), latencies, microsSince(start) / 1e6);
+    }
+}
+
+void benchReadCoalescing(InverterSimServer &sim)
+{
+    std::cout << "\n=== Concurrent readers of one device (RTU over TCP, 2 ms device think time) ===" << std::endl;
+
+    const auto duration = std::chrono::seconds(1);
+    const int threads = 8;
+    sim.setLatency(2000, 0);
+    for (int coalesce = 0; coalesce < 2; ++coalesce)
+    {
+        // A serial bus behind the gateway answers one request at a time
+        ModbusHandler handler(sim.endpoint(TransportType::RTU_OVER_TCP));
+        handler.setReadCoalescing(coalesce != 0);
+        uint64_t requestsBefore = sim.requestCount();
+
+        // Dashboard-style readers: each asks for an overlapping slice of registers 0-9
+        std::vector<std::vector<double>> perThread(threads);
+        std::vector<std::thread> workers;
+        auto start = std::chrono::steady_clock::now();
+        for (int t = 0; t < threads; ++t)
+        {
+            workers.emplace_back([&, t]()
+                                 {
+                                     std::vector<uint16_t> values;
+                                     uint16_t first = static_cast<uint16_t>(t % 4);
+                                     while (std::chrono::steady_clock::now() - start < duration)
+                                     {
+                                         auto begin = std::chrono::steady_clock::now();
+                                         if (handler.readRegisters(first, 6, values))
+                                             perThread[t].push_back(microsSince(begin));
+                                     } });
+        }
+        for (auto &w : workers)
+            w.join();
+        double seconds = microsSince(start) / 1e6;
+
+        std::vector<double> all;
+        for (auto &v : perThread)
+            all.insert(all.end(), v.begin(), v.end());
+        reportLatency(coalesce ? "single-flight" : "every read sent", all, seconds);
+        std::cout << "  " << all.size() << " reads, " << sim.requestCount() - requestsBefore << " device requests"
+                  << std::endl;
+    }
+    sim.setLatency(0, 0);
+}
+
+void benchSetpoints(InverterSimServer &sim)
+{
+    std::cout << "\n=== Setpoint update, 4 registers (HTTP) ===" << std::endl;
+
+    const auto duration = std::chrono::seconds(1);
+    for (uint16_t reg = 5; reg <= 7; ++reg)
+        sim.setWritable(reg, true);
+    ModbusHandler handler(sim.endpoint());
+    const std::vector<uint16_t> setpoints = {81, 82, 430, 40};
+
+    for (int blockWrite = 0; blockWrite < 2; ++blockWrite)
+    {
+        std::vector<double> latencies;
+        auto start = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - start < duration)
+        {
+            auto begin = std::chrono::steady_clock::now();
+            bool ok = true;
+            if (blockWrite)
+                ok = handler.writeRegisters(5, setpoints);
+            else
+                for (uint16_t i = 0; i < setpoints.size(); ++i)
+                    ok = handler.writeRegister(static_cast<uint16_t>(5 + i), setpoints[i]) && ok;
+            if (ok)
+                latencies.push_back(microsSince(begin));
+        }
+        reportLatency(blockWrite ? "1 x FC16" : "4 x FC06", latencies, microsSince(start) / 1e6);
+    }
+    for (uint16_t reg = 5; reg <= 7; ++reg)
+        sim.setWritable(reg, false);
+    sim.resetRegisters();
+}
+
+void benchModbusTcpWindow(InverterSimServer &sim)
+{
+    std::cout << "\n=== Modbus TCP pipelining (2 ms device think time, 64 requests queued) ===" << std::endl;
+
+    const auto duration = std::chrono::seconds(1);
+    const size_t batch = 64;
+    const size_t windows[] = {1, 4, 16};
+    sim.setLatency(2000, 0);
+    for (size_t window : windows)
+    {
+        TcpTransport transport(TransportType::MODBUS_TCP, "127.0.0.1", sim.modbusTcpPort(), 3000, window);
+        FrameBuffer request;
+        ModbusFrame::buildReadRequest(0x11, 0, 10, request);
+
+        std::vector<double> latencies;
+        auto start = std::chrono::steady_clock::now();
+        while (std::chrono::steady_clock::now() - start < duration)
+        {
+            std::vector<std::promise<double>> results(batch);
+            auto issued = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < batch; ++i)
+            {
+                std::promise<double> *result = &results[i];
+                transport.transactAsync(RequestType::READ, request, [result, issued](bool ok, const FrameBuffer &)
+                                        { result->set_value(ok ? microsSince(issued) : -1.0); });
+            }
+            for (auto &result : results)
+            {
+                double latency = result.get_future().get();
+                if (latency >= 0)
+                    latencies.push_back(latency);
+            }
+        }
+        reportLatency("window " + std::to_string(window), latencies, microsSince(start) / 1e6);
+    }
+    sim.setLatency(0, 0);
+}
+
+void benchPipeline(const Endpoint &endpoint)
+{
+    std::cout << "\n=== Poll / upload pipeline (local SIM) ===" << std::endl;
+
+    PollingConfig config;
+    config.setParameters({ParameterType::AC_VOLTAGE, ParameterType::AC_CURRENT, ParameterType::AC_FREQUENCY,
+                          ParameterType::TEMPERATURE, ParameterType::OUTPUT_POWER});
+
+    // Pollers read as fast as they can; the uploader drains every 10 ms
+    const auto duration = std::chrono::seconds(2);
+    const int pollers = 4;
+    SharedDataBuffer buffer(4096);
+    std::atomic<bool> done(false);
+    std::atomic<uint64_t> uploaded(0);
+
+    std::thread uploader([&]()
+                         {
+                             SampleBatch batch;
+                             while (!done)
+                             {
+                                 std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                                 uploaded += buffer.drainInto(batch);
+                             }
+                             uploaded += buffer.drainInto(batch); });
+
+    std::vector<std::vector<double>> perPoller(pollers);
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int p = 0; p < pollers; ++p)
+    {
+        threads.emplace_back([&, p]()
+                             {
+                                 Inverter inverter(static_cast<uint8_t>(0x11 + p), endpoint);
+                                 PollPlanner planner(config, 1);
+                                 while (std::chrono::steady_clock::now() - start < duration)
+                                 {
+                                     auto begin = std::chrono::steady_clock::now();
+                                     Sample sample;
+                                     if (planner.execute(inverter, sample))
+                                     {
+                                         buffer.append(std::move(sample));
+                                         perPoller[p].push_back(microsSince(begin));
+                                     }
+                                 } });
+    }
+    for (auto &t : threads)
+        t.join();
+    double seconds = microsSince(start) / 1e6;
+    done = true;
+    uploader.join();
+
+    std::vector<double> all;
+    for (auto &v : perPoller)
+        all.insert(all.end(), v.begin(), v.end());
+    reportLatency(std::to_string(pollers) + " pollers, 5 params", all, seconds, "polls/s");
+    std::cout << "  uploaded " << uploaded << " samples, dropped " << buffer.droppedCount() << std::endl;
+}
+
+int main(int argc, char **argv)
+{
+    std::cout << "EcoWatt Benchmark Suite" << std::endl;
+    std::cout << "=======================" << std::endl;
+
+    bool micro = !(argc > 1 && std::strcmp(argv[1], "--macro") == 0);
+    bool macro = !(argc > 1 && std::strcmp(argv[1], "--micro") == 0);
+
+    if (micro)
+    {
+        benchCRC();
+        benchFrameCodec();
+        benchSample();
+        benchDataBuffer();
+        benchSampleEncoder();
+    }
+
+    if (macro)
+    {
+        InverterSimServer sim;
+        if (!sim.start())
+        {
+            std::cerr << "Could not start local SIM, skipping macro benchmarks" << std::endl;
+            return 1;
+        }
+        Endpoint endpoint{"bench", sim.readUrl(), sim.writeUrl()};
+        benchReadRegisters(sim, endpoint);
+        benchTransports(sim);
+        benchModbusTcpWindow(sim);
+        benchReadCoalescing(sim);
+        benchSetpoints(sim);
+        benchPipeline(endpoint);
+        std::cout << "  SIM served " << sim.requestCount() << " requests on "
+                  << sim.connectionCount() << " connections" << std::endl;
+    }
+
+    std::cout << "\nAll benchmarks completed!" << std::endl;
+    return 0;
+}
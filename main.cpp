@@ -1,211 +1,345 @@
-#include <iostream>
-#include <vector>
-#include <thread>
-#include <mutex>
-#include <chrono>
-#include "Inverter.h"
-#include "PollingConfig.h"
-
-// ================= Buffer ==================
-class DataBuffer
-{
-public:
-    explicit DataBuffer(size_t cap) : capacity_(cap) {}
-    bool hasSpace()
-    {
-        std::lock_guard<std::mutex> l(m_);
-        return buf_.size() < capacity_;
-    }
-    void append(const Sample &s)
-    {
-        std::lock_guard<std::mutex> l(m_);
-        buf_.push_back(s);
-    }
-    std::vector<Sample> flush()
-    {
-        std::lock_guard<std::mutex> l(m_);
-        auto out = buf_;
-        buf_.clear();
-        return out;
-    }
-
-private:
-    std::vector<Sample> buf_;
-    std::mutex m_;
-    size_t capacity_;
-};
-
-// ================= Loops ==================
-void pollLoop(Inverter &inverter, DataBuffer &buf,
-              std::chrono::milliseconds pollInt, const PollingConfig &config)
-{
-    auto start = std::chrono::steady_clock::now();
-    while (true)
-    {
-        Sample sample;
-        sample.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
-                               std::chrono::steady_clock::now() - start)
-                               .count();
-
-        bool allSuccess = true;
-        const auto &enabledParams = config.getEnabledParameters();
-
-        for (auto paramType : enabledParams)
-        {
-            const auto &paramConfig = config.getParameterConfig(paramType);
-            float value;
-
-            if (paramConfig.readFunction(inverter, value))
-            {
-                sample.setValue(paramType, value);
-            }
-            else
-            {
-                std::cerr << "Failed to read " << paramConfig.name << std::endl;
-                allSuccess = false;
-            }
-        }
-
-        if (allSuccess && buf.hasSpace())
-        {
-            buf.append(sample);
-        }
-        else if (!allSuccess)
-        {
-            std::cerr << "Poll failed for some parameters\n";
-        }
-
-        std::this_thread::sleep_for(pollInt);
-    }
-}
-void uploadLoop(DataBuffer &buf, std::chrono::milliseconds upInt, const PollingConfig &config)
-{
-    while (true)
-    {
-        std::this_thread::sleep_for(upInt);
-        auto data = buf.flush();
-        if (!data.empty())
-        {
-            std::cout << "Uploading " << data.size() << " samples\n";
-            for (auto &s : data)
-            {
-                std::cout << "t=" << s.timestamp << " ms";
-
-                // Print all polled parameters
-                for (auto paramType : config.getEnabledParameters())
-                {
-                    if (s.hasValue(paramType))
-                    {
-                        const auto &paramConfig = config.getParameterConfig(paramType);
-                        std::cout << " " << paramConfig.name << "=" << s.getValue(paramType)
-                                  << paramConfig.unit;
-                    }
-                }
-                std::cout << "\n";
-            }
-        }
-        else
-            std::cout << "No data\n";
-    }
-}
-
-// ================= Main ==================
-int main()
-{
-    std::cout << "=== Inverter Communication Demo ===\n";
-
-    // Create Inverter instance (configuration loaded automatically)
-    Inverter inverter;
-
-    // Demo: write once
-    if (inverter.setExportPowerPercent(20))
-    {
-        std::cout << "Export power set to 20%\n";
-    }
-    else
-    {
-        std::cerr << "Failed to set export power percent\n";
-    }
-
-    // Demo: dynamic register read (temperature and export power percent)
-    float temperature;
-    int exportPercent;
-    if (inverter.getTemperature(temperature) && inverter.getExportPowerPercent(exportPercent))
-    {
-        std::cout << "Temperature: " << temperature << " C\n";
-        std::cout << "Export Power Percent: " << exportPercent << " %\n";
-    }
-    else
-    {
-        std::cerr << "Failed to read temperature and export power percent\n";
-    }
-
-    // Demo: comprehensive AC measurements
-    float acVoltage, acCurrent, acFrequency;
-    if (inverter.getACMeasurements(acVoltage, acCurrent, acFrequency))
-    {
-        std::cout << "AC Measurements - Voltage: " << acVoltage << " V, Current: " << acCurrent << " A, Frequency: " << acFrequency << " Hz\n";
-    }
-    else
-    {
-        std::cerr << "Failed to read AC measurements\n";
-    }
-
-    // Demo: PV input measurements
-    float pv1Voltage, pv2Voltage, pv1Current, pv2Current;
-    if (inverter.getPVMeasurements(pv1Voltage, pv2Voltage, pv1Current, pv2Current))
-    {
-        std::cout << "PV1 - Voltage: " << pv1Voltage << " V, Current: " << pv1Current << " A\n";
-        std::cout << "PV2 - Voltage: " << pv2Voltage << " V, Current: " << pv2Current << " A\n";
-    }
-    else
-    {
-        std::cerr << "Failed to read PV measurements\n";
-    }
-
-    // Demo: system status
-    int outputPower;
-    if (inverter.getSystemStatus(temperature, exportPercent, outputPower))
-    {
-        std::cout << "System Status - Temperature: " << temperature << " C, Export: " << exportPercent << " %, Output Power: " << outputPower << " W\n";
-    }
-    else
-    {
-        std::cerr << "Failed to read system status\n";
-    }
-
-    // Demo: dynamic register read (voltage and current)
-    float voltage, current;
-    if (inverter.getACVoltage(voltage) && inverter.getACCurrent(current))
-    {
-        std::cout << "[Dynamic] Voltage: " << voltage << " V\n";
-        std::cout << "[Dynamic] Current: " << current << " A\n";
-    }
-    else
-    {
-        std::cerr << "Failed to read voltage and current registers dynamically\n";
-    }
-
-    // ================= Dynamic Polling Configuration Demo ===================
-    std::cout << "\n=== Dynamic Polling Configuration ===\n";
-
-    // Create and configure polling parameters
-    PollingConfig pollingConfig;
-
-    // Configure to poll AC Voltage and Current only
-    std::cout << "\nConfiguring to poll AC voltage and AC current...\n";
-    pollingConfig.setParameters({ParameterType::AC_VOLTAGE, ParameterType::AC_CURRENT, ParameterType::AC_FREQUENCY});
-    pollingConfig.printEnabledParameters();
-
-    // Start polling with the configured parameters
-    std::cout << "\n=== Starting Dynamic Polling ===\n";
-
-    DataBuffer buffer(30);
-    std::thread pollT(pollLoop, std::ref(inverter), std::ref(buffer),
-                      std::chrono::milliseconds(5000), std::ref(pollingConfig));
-    std::thread upT(uploadLoop, std::ref(buffer), std::chrono::milliseconds(30000),
-                    std::ref(pollingConfig));
-    pollT.join();
-    upT.join();
-    return 0;
-}
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include "Inverter.h"
+#include "PollingConfig.h"
+#include "DataBuffer.h"
+#include "FleetPoller.h"
+#include "Config.h"
+#include "Metrics.h"
+#include "SampleEncoder.h"
+#include "Uploader.h"
+
+// ================= Loops ==================
+// Batches are encoded and POSTed when an uploader is given, printed otherwise.
+// A batch that cannot be encoded is REJECTED like one the server refuses:
+// sending it again would fail the same way.
+UploadResult publishBatch(const SampleBatch &data, uint8_t slaveAddress, const PollingConfig &config,
+                          SampleEncoder &encoder, std::vector<uint8_t> &payload, Uploader *uploader, bool compress)
+{
+    if (uploader)
+    {
+        if (!encoder.encode(data, slaveAddress, payload, compress))
+        {
+            std::cerr << "Failed to encode " << data.size() << " samples\n";
+            return UploadResult::REJECTED;
+        }
+        UploadResult result = uploader->upload(payload);
+        if (result == UploadResult::DELIVERED)
+            std::cout << "Uploaded " << data.size() << " samples (" << payload.size() << " bytes)\n";
+        return result;
+    }
+
+    std::cout << "Uploading " << data.size() << " samples\n";
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        std::cout << "t=" << data.timestamps[i] << " ms";
+
+        // Print all polled parameters
+        for (auto paramType : config.getEnabledParameters())
+        {
+            if (data.masks[i] & parameterBit(paramType))
+            {
+                const auto &paramConfig = config.getParameterConfig(paramType);
+                std::cout << " " << paramConfig.name << "=" << data.column(paramType)[i]
+                          << paramConfig.unit;
+            }
+        }
+        std::cout << "\n";
+    }
+    return UploadResult::DELIVERED;
+}
+
+// Window statistics instead of raw samples, same delivery rules as publishBatch
+UploadResult publishAggregates(const std::vector<WindowAggregate> &windows, uint8_t slaveAddress,
+                               const PollingConfig &config, SampleEncoder &encoder, std::vector<uint8_t> &payload,
+                               Uploader *uploader, bool compress)
+{
+    if (uploader)
+    {
+        if (!encoder.encodeAggregates(windows, slaveAddress, payload, compress))
+        {
+            std::cerr << "Failed to encode " << windows.size() << " windows\n";
+            return UploadResult::REJECTED;
+        }
+        UploadResult result = uploader->upload(payload);
+        if (result == UploadResult::DELIVERED)
+            std::cout << "Uploaded " << windows.size() << " windows (" << payload.size() << " bytes)\n";
+        return result;
+    }
+
+    std::cout << "Uploading " << windows.size() << " windows\n";
+    for (const WindowAggregate &window : windows)
+    {
+        std::cout << "t=" << window.start << "-" << window.end << " ms, " << window.samples << " samples";
+        for (auto paramType : config.getEnabledParameters())
+        {
+            if (!window.hasValue(paramType))
+                continue;
+            size_t i = parameterIndex(paramType);
+            const auto &paramConfig = config.getParameterConfig(paramType);
+            std::cout << " " << paramConfig.name << "=" << window.mean[i] << paramConfig.unit << " [" << window.min[i]
+                      << ".." << window.max[i] << ", last " << window.last[i] << "]";
+        }
+        if (window.hasValue(ParameterType::OUTPUT_POWER))
+            std::cout << " Energy=" << window.energyWh << "Wh";
+        std::cout << "\n";
+    }
+    return UploadResult::DELIVERED;
+}
+
+void uploadLoop(FleetPoller &fleet, std::chrono::milliseconds upInt, const PollingConfig &config,
+                Uploader *uploader, bool compress, size_t maxBatchSamples)
+{
+    SampleBatch data; // Reused struct-of-arrays batch
+    std::vector<WindowAggregate> windows; // Reused aggregate batch
+    SampleEncoder encoder(config);
+    std::vector<uint8_t> payload; // Reused encoded batch
+    std::vector<uint64_t> reportedDrops(fleet.deviceCount(), 0);
+    while (true)
+    {
+        std::this_thread::sleep_for(upInt);
+
+        for (size_t d = 0; d < fleet.deviceCount(); ++d)
+        {
+            DeviceContext &device = fleet.device(d);
+            std::cout << "[slave 0x" << std::hex << static_cast<int>(device.slaveAddress) << std::dec << "] ";
+
+            uint64_t dropped = device.aggregator ? device.aggregator->droppedCount()
+                               : device.store  ? device.store->droppedCount()
+                                               : device.buffer.droppedCount();
+            if (dropped != reportedDrops[d])
+            {
+                if (device.aggregator)
+                    std::cerr << "Aggregate queue full: " << (dropped - reportedDrops[d]) << " windows dropped\n";
+                else if (device.store)
+                    std::cerr << "Store full: " << (dropped - reportedDrops[d]) << " oldest samples dropped\n";
+                else
+                    std::cerr << "Buffer full: " << (dropped - reportedDrops[d]) << " samples dropped ("
+                              << overflowPolicyName(device.buffer.policy()) << ")\n";
+                reportedDrops[d] = dropped;
+            }
+
+            // Closed windows are delivered once, best effort
+            bool sent = false;
+            if (device.aggregator && device.aggregator->drainInto(windows) > 0)
+            {
+                sent = true;
+                if (publishAggregates(windows, device.slaveAddress, config, encoder, payload, uploader, compress) !=
+                    UploadResult::DELIVERED)
+                    std::cerr << "Upload failed, " << windows.size() << " windows lost\n";
+            }
+
+            // In-memory samples (all of them without a store) are delivered once, best effort
+            if (device.buffer.drainInto(data) > 0)
+            {
+                sent = true;
+                if (publishBatch(data, device.slaveAddress, config, encoder, payload, uploader, compress) !=
+                    UploadResult::DELIVERED)
+                    std::cerr << "Upload failed, " << data.size() << " samples lost\n";
+            }
+
+            // Stored samples stay on disk until delivered, a backlog goes out in several batches.
+            // A batch whose payload was refused would be refused again and block the store,
+            // so it is dropped; any other failure keeps it.
+            if (device.store)
+            {
+                device.store->flush();
+                while (device.store->peek(data, maxBatchSamples) > 0)
+                {
+                    sent = true;
+                    UploadResult result = publishBatch(data, device.slaveAddress, config, encoder, payload, uploader,
+                                                       compress);
+                    if (result == UploadResult::FAILED)
+                    {
+                        std::cerr << "Upload failed, " << device.store->size() << " samples kept in store\n";
+                        break;
+                    }
+                    if (result == UploadResult::REJECTED)
+                        std::cerr << "Batch refused, " << data.size() << " stored samples dropped\n";
+                    device.store->commit();
+                }
+                if (data.empty())
+                    device.store->commit(); // Skips over corrupt records
+            }
+            device.reportBufferState();
+
+            if (!sent)
+                std::cout << "No data\n";
+        }
+    }
+}
+
+// Apply per-parameter polling periods and deadbands from the [POLLING] section
+void loadParameterSettings(PollingConfig &pollingConfig)
+{
+    Config &appConfig = Config::getInstance();
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+    {
+        auto param = static_cast<ParameterType>(i);
+        const std::string &name = pollingConfig.getParameterConfig(param).name;
+        long intervalMs = appConfig.getParameterIntervalMs(name);
+        if (intervalMs > 0)
+            pollingConfig.setParameterInterval(param, std::chrono::milliseconds(intervalMs));
+
+        std::string deadbandText = appConfig.getParameterDeadband(name);
+        if (deadbandText.empty())
+            continue;
+        Deadband deadband;
+        if (!parseDeadband(deadbandText, deadband))
+        {
+            std::cerr << "Warning: Ignoring invalid " << name << "_deadband '" << deadbandText << "'\n";
+            continue;
+        }
+        deadband.heartbeat = std::chrono::milliseconds(appConfig.getParameterHeartbeatMs(name));
+        pollingConfig.setParameterDeadband(param, deadband);
+    }
+}
+
+// ================= Main ==================
+int main()
+{
+    std::cout << "=== Inverter Communication Demo ===\n";
+
+    // Create Inverter instance (configuration loaded automatically)
+    Inverter inverter;
+
+    // Demo: write once
+    if (inverter.setExportPowerPercent(20))
+    {
+        std::cout << "Export power set to 20%\n";
+    }
+    else
+    {
+        std::cerr << "Failed to set export power percent\n";
+    }
+
+    // The demo reads accept values up to a second old: the first one refreshes
+    // the whole register block and the rest are served from the cache
+    const Inverter::MaxAge snapshotAge(1000);
+
+    // Demo: dynamic register read (temperature and export power percent)
+    float temperature;
+    int exportPercent;
+    if (inverter.getTemperature(temperature, snapshotAge) && inverter.getExportPowerPercent(exportPercent, snapshotAge))
+    {
+        std::cout << "Temperature: " << temperature << " C\n";
+        std::cout << "Export Power Percent: " << exportPercent << " %\n";
+    }
+    else
+    {
+        std::cerr << "Failed to read temperature and export power percent\n";
+    }
+
+    // Demo: comprehensive AC measurements
+    float acVoltage, acCurrent, acFrequency;
+    if (inverter.getACMeasurements(acVoltage, acCurrent, acFrequency, snapshotAge))
+    {
+        std::cout << "AC Measurements - Voltage: " << acVoltage << " V, Current: " << acCurrent << " A, Frequency: " << acFrequency << " Hz\n";
+    }
+    else
+    {
+        std::cerr << "Failed to read AC measurements\n";
+    }
+
+    // Demo: PV input measurements
+    float pv1Voltage, pv2Voltage, pv1Current, pv2Current;
+    if (inverter.getPVMeasurements(pv1Voltage, pv2Voltage, pv1Current, pv2Current, snapshotAge))
+    {
+        std::cout << "PV1 - Voltage: " << pv1Voltage << " V, Current: " << pv1Current << " A\n";
+        std::cout << "PV2 - Voltage: " << pv2Voltage << " V, Current: " << pv2Current << " A\n";
+    }
+    else
+    {
+        std::cerr << "Failed to read PV measurements\n";
+    }
+
+    // Demo: system status
+    int outputPower;
+    if (inverter.getSystemStatus(temperature, exportPercent, outputPower, snapshotAge))
+    {
+        std::cout << "System Status - Temperature: " << temperature << " C, Export: " << exportPercent << " %, Output Power: " << outputPower << " W\n";
+    }
+    else
+    {
+        std::cerr << "Failed to read system status\n";
+    }
+
+    // Demo: dynamic register read (voltage and current)
+    float voltage, current;
+    if (inverter.getACVoltage(voltage, snapshotAge) && inverter.getACCurrent(current, snapshotAge))
+    {
+        std::cout << "[Dynamic] Voltage: " << voltage << " V\n";
+        std::cout << "[Dynamic] Current: " << current << " A\n";
+    }
+    else
+    {
+        std::cerr << "Failed to read voltage and current registers dynamically\n";
+    }
+    std::cout << "Register cache: " << inverter.cacheHits() << " hits, " << inverter.cacheMisses()
+              << " device reads\n";
+
+    // ================= Dynamic Polling Configuration Demo ===================
+    std::cout << "\n=== Dynamic Polling Configuration ===\n";
+
+    // Create and configure polling parameters
+    PollingConfig pollingConfig;
+
+    // Configure to poll AC Voltage and Current only
+    std::cout << "\nConfiguring to poll AC voltage and AC current...\n";
+    pollingConfig.setParameters({ParameterType::AC_VOLTAGE, ParameterType::AC_CURRENT, ParameterType::AC_FREQUENCY});
+    loadParameterSettings(pollingConfig);
+    pollingConfig.printEnabledParameters();
+
+    // Start polling with the configured parameters
+    std::cout << "\n=== Starting Dynamic Polling ===\n";
+
+    Config &appConfig = Config::getInstance();
+
+    // Every configured inverter gets its own planner, scheduler and buffer
+    FleetPoller fleet(pollingConfig, std::chrono::milliseconds(appConfig.getPollIntervalMs()),
+                      appConfig.getFleetWorkerThreads(), appConfig.getBufferCapacity(),
+                      parseOverflowPolicy(appConfig.getBufferOverflowPolicy(), OverflowPolicy::DROP_NEWEST),
+                      appConfig.getPollMaxRegisterGap());
+    // Samples persist in the on-disk store so outages and restarts lose nothing
+    if (!appConfig.getStoreDirectory().empty())
+        fleet.setStore(appConfig.getStoreDirectory(), appConfig.getStoreRecordsPerSegment(),
+                       appConfig.getStoreMaxSegments());
+    // Per-window statistics replace raw samples when a window is configured
+    if (appConfig.getAggregationWindowMs() > 0)
+        fleet.setAggregation(std::chrono::milliseconds(appConfig.getAggregationWindowMs()));
+    for (const auto &deviceConfig : appConfig.getFleetDevices())
+    {
+        Endpoint endpoint{appConfig.getApiKey(), deviceConfig.readUrl, deviceConfig.writeUrl};
+        endpoint.transport = parseTransportType(deviceConfig.transport, TransportType::HTTP);
+        endpoint.host = deviceConfig.host;
+        endpoint.port = deviceConfig.port;
+        fleet.addDevice(deviceConfig.slaveAddress, endpoint);
+    }
+    std::cout << "Polling " << fleet.deviceCount() << " inverter(s) with "
+              << appConfig.getFleetWorkerThreads() << " worker thread(s)\n";
+    fleet.start();
+
+    // Counters and latency histograms, dumped and written for Prometheus periodically
+    MetricsExporter exporter(std::chrono::milliseconds(appConfig.getMetricsIntervalMs()),
+                             appConfig.getMetricsPrometheusFile(), appConfig.getMetricsTextDump());
+    exporter.start();
+
+    // Encoded batches go to [UPLOAD] url; without one they are printed
+    std::unique_ptr<Uploader> uploader;
+    if (!appConfig.getUploadUrl().empty())
+    {
+        RetrySettings uploadRetry = RetryPolicy::settingsFromConfig();
+        uploadRetry.maxAttempts = appConfig.getUploadMaxAttempts();
+        uploader.reset(new Uploader(appConfig.getUploadUrl(), appConfig.getApiKey(),
+                                    appConfig.getHttpTimeoutMs(), uploadRetry));
+    }
+
+    std::thread upT(uploadLoop, std::ref(fleet), std::chrono::milliseconds(appConfig.getUploadIntervalMs()),
+                    std::ref(pollingConfig), uploader.get(), appConfig.getUploadCompress(),
+                    appConfig.getUploadMaxBatchSamples());
+    upT.join();
+    return 0;
+}
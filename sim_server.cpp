@@ -0,0 +1,89 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include "InverterSimServer.h"
+
+// ================= Inverter SIM stand-in ==================
+// Usage: ./sim_server [--port N] [--modbus-tcp-port N] [--rtu-port N]
+//                     [--latency-ms N] [--jitter-ms N]
+//                     [--exception-rate R] [--exception-code C] [--crc-error-rate R]
+
+static std::atomic<bool> g_stop(false);
+
+static void onSignal(int)
+{
+    g_stop = true;
+}
+
+static void usage()
+{
+    std::cerr << "Usage: ./sim_server [--port N] [--modbus-tcp-port N] [--rtu-port N]\n"
+              << "                    [--latency-ms N] [--jitter-ms N]\n"
+              << "                    [--exception-rate R] [--exception-code C] [--crc-error-rate R]\n";
+}
+
+int main(int argc, char **argv)
+{
+    SimOptions options;
+    options.port = 8080;
+    options.modbusTcpPort = 5020;
+    options.rtuOverTcpPort = 5021;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            usage();
+            return 1;
+        }
+        const char *value = argv[++i];
+
+        if (std::strcmp(arg, "--port") == 0)
+            options.port = static_cast<uint16_t>(std::atoi(value));
+        else if (std::strcmp(arg, "--modbus-tcp-port") == 0)
+            options.modbusTcpPort = static_cast<uint16_t>(std::atoi(value));
+        else if (std::strcmp(arg, "--rtu-port") == 0)
+            options.rtuOverTcpPort = static_cast<uint16_t>(std::atoi(value));
+        else if (std::strcmp(arg, "--latency-ms") == 0)
+            options.latencyUs = static_cast<long>(std::atof(value) * 1000);
+        else if (std::strcmp(arg, "--jitter-ms") == 0)
+            options.jitterUs = static_cast<long>(std::atof(value) * 1000);
+        else if (std::strcmp(arg, "--exception-rate") == 0)
+            options.exceptionRate = std::atof(value);
+        else if (std::strcmp(arg, "--exception-code") == 0)
+            options.injectedException = static_cast<uint8_t>(std::strtoul(value, nullptr, 0));
+        else if (std::strcmp(arg, "--crc-error-rate") == 0)
+            options.crcErrorRate = std::atof(value);
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    InverterSimServer server(options);
+    if (!server.start())
+        return 1;
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    std::cout << "Inverter SIM listening on 127.0.0.1:" << server.port() << "\n"
+              << "  read_url=" << server.readUrl() << "\n"
+              << "  write_url=" << server.writeUrl() << "\n"
+              << "Modbus TCP on port " << server.modbusTcpPort()
+              << ", RTU over TCP on port " << server.rtuOverTcpPort() << std::endl;
+
+    while (!g_stop)
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    server.stop();
+    std::cout << "Served " << server.requestCount() << " requests on "
+              << server.connectionCount() << " connections" << std::endl;
+    return 0;
+}
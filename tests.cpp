@@ -30,7 +30,38 @@
 #include <string>
 #include <sstream>
 #include <streambuf>
+#include <thread>
+#include <cstring>
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include "Inverter.h"
 #include "ModbusHandler.h"
+#include "ModbusCRC.h"
+#include "ModbusFrame.h"
+#include "DataBuffer.h"
+#include "PollScheduler.h"
+#include "PollPlanner.h"
+#include "WorkerPool.h"
+#include "InverterSimServer.h"
+#include "Config.h"
+#include "Metrics.h"
+#include "RetryPolicy.h"
+#include "SampleEncoder.h"
+#include "Uploader.h"
+#include "SampleStore.h"
+#include "ModbusTcpSession.h"
+#include "TcpTransport.h"
+#include "RegisterMap.h"
+#include "RegisterCodec.h"
+#include "JsonFrame.h"
+#include "DeadbandFilter.h"
+#include "WindowAggregator.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
 
 // Helper class to capture stderr output
 class CaptureStderr
@@ -483,11 +514,1633 @@ void testSpecificErrorScenarios()
     }
 }
 
-int main()
+void testPollPlanner()
+{
+    std::cout << "\n=== Test 10: Poll Planner Register Coalescing ===" << std::endl;
+
+    PollingConfig config;
+    PollPlanner contiguous(config);
+    PollPlanner gapTolerant(config, 2);
+
+    // AC voltage, current and frequency are registers 0-2: one 3-register read
+    auto blocks = contiguous.plan({ParameterType::AC_VOLTAGE, ParameterType::AC_CURRENT, ParameterType::AC_FREQUENCY});
+    if (blocks.size() == 1 && blocks[0].startAddr == 0 && blocks[0].numRegs == 3)
+        std::cout << "SUCCESS: Adjacent registers merged into a single read" << std::endl;
+    else
+        std::cout << "FAILED: Expected one read of registers 0-2, got " << blocks.size() << " blocks" << std::endl;
+
+    // Registers 0 and 7 are too far apart for the gap-tolerant planner
+    blocks = gapTolerant.plan({ParameterType::AC_VOLTAGE, ParameterType::PV1_VOLTAGE, ParameterType::TEMPERATURE});
+    if (blocks.size() == 2 && blocks[0].numRegs == 4 && blocks[1].startAddr == 7)
+        std::cout << "SUCCESS: Gap of 2 registers bridged, distant register read separately" << std::endl;
+    else
+        std::cout << "FAILED: Unexpected gap-tolerant plan (" << blocks.size() << " blocks)" << std::endl;
+
+    // Decoding applies each parameter's gain at its offset in the block
+    Sample sample;
+    PollPlanner::decodeBlock(blocks[0], {2300, 0, 0, 3500}, sample);
+    if (sample.getValue(ParameterType::AC_VOLTAGE) == 230.0f && sample.getValue(ParameterType::PV1_VOLTAGE) == 350.0f)
+        std::cout << "SUCCESS: Block values decoded with per-parameter gain" << std::endl;
+    else
+        std::cout << "FAILED: Block decode produced wrong values" << std::endl;
+}
+
+void testCRCImplementations()
+{
+    std::cout << "\n=== Test 11: CRC Implementations Agree ===" << std::endl;
+
+    // Standard CRC-16/MODBUS check value for "123456789"
+    const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    if (ModbusCRC::table(check, sizeof(check)) == 0x4B37 && ModbusCRC::slicing8(check, sizeof(check)) == 0x4B37)
+        std::cout << "SUCCESS: Check value 0x4B37 reproduced" << std::endl;
+    else
+        std::cout << "FAILED: Check value mismatch" << std::endl;
+
+    // Every length exercises a different split between 8-byte chunks and the tail
+    std::vector<uint8_t> data(300);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = static_cast<uint8_t>(i * 131 + 17);
+    size_t mismatches = 0;
+    for (size_t len = 0; len <= data.size(); ++len)
+    {
+        uint16_t expected = ModbusCRC::bitwise(data.data(), len);
+        if (ModbusCRC::table(data.data(), len) != expected || ModbusCRC::slicing8(data.data(), len) != expected)
+            mismatches++;
+    }
+    if (mismatches == 0)
+        std::cout << "SUCCESS: Table and slicing-by-8 match bitwise CRC for all lengths" << std::endl;
+    else
+        std::cout << "FAILED: " << mismatches << " lengths produced a different CRC" << std::endl;
+}
+
+void testFrameCodec()
+{
+    std::cout << "\n=== Test 12: Frame Codec ===" << std::endl;
+
+    FrameBuffer frame;
+    HexFrame hex;
+    ModbusFrame::buildReadRequest(0x11, 0x0000, 0x0001, frame);
+    ModbusFrame::encodeHex(frame, hex);
+    std::cout << "Read request frame: " << hex.data << std::endl;
+
+    FrameBuffer decoded;
+    if (ModbusFrame::decodeHex(hex.data, hex.size, decoded) && decoded.size == frame.size &&
+        ModbusFrame::receivedCRC(decoded.data, decoded.size) == ModbusCRC::compute(decoded.data, decoded.size - 2))
+        std::cout << "SUCCESS: Hex round trip preserves frame and CRC" << std::endl;
+    else
+        std::cout << "FAILED: Hex round trip corrupted the frame" << std::endl;
+
+    // Upper-case input is accepted, non-hex characters and odd lengths are rejected
+    const std::string upper = "1103020904";
+    const std::string invalid = "11zz";
+    uint8_t bytes[8];
+    size_t len = 0;
+    bool upperOk = ModbusFrame::decodeHex(upper.data(), upper.size(), bytes, sizeof(bytes), len) && len == 5 && bytes[3] == 0x09;
+    bool invalidRejected = !ModbusFrame::decodeHex(invalid.data(), invalid.size(), bytes, sizeof(bytes), len) &&
+                           !ModbusFrame::decodeHex(upper.data(), 3, bytes, sizeof(bytes), len);
+    if (upperOk && invalidRejected)
+        std::cout << "SUCCESS: Malformed hex rejected" << std::endl;
+    else
+        std::cout << "FAILED: Hex decoder validation" << std::endl;
+
+    // Byte count must match the number of requested registers
+    uint16_t values[2] = {0, 0};
+    const uint8_t response[] = {0x11, 0x03, 0x02, 0x09, 0x04, 0x00, 0x00};
+    if (ModbusFrame::parseReadResponse(response, sizeof(response), 1, values) && values[0] == 0x0904 &&
+        !ModbusFrame::parseReadResponse(response, sizeof(response), 2, values))
+        std::cout << "SUCCESS: Read response parsed and length-checked" << std::endl;
+    else
+        std::cout << "FAILED: Read response parsing" << std::endl;
+}
+
+static Sample makeSample(long long timestamp)
+{
+    Sample s;
+    s.timestamp = timestamp;
+    s.setValue(ParameterType::AC_VOLTAGE, 230.0f);
+    return s;
+}
+
+void testDataBufferPolicies()
+{
+    std::cout << "\n=== Test 13: Data Buffer Overflow Policies ===" << std::endl;
+
+    DataBuffer dropNewest(3, OverflowPolicy::DROP_NEWEST);
+    DataBuffer dropOldest(3, OverflowPolicy::DROP_OLDEST);
+    for (long long t = 0; t < 5; ++t)
+    {
+        dropNewest.append(makeSample(t));
+        dropOldest.append(makeSample(t));
+    }
+
+    auto newest = dropNewest.flush();
+    auto oldest = dropOldest.flush();
+    if (newest.size() == 3 && newest.front().timestamp == 0 && newest.back().timestamp == 2 && dropNewest.droppedCount() == 2)
+        std::cout << "SUCCESS: drop_newest keeps the first samples and counts drops" << std::endl;
+    else
+        std::cout << "FAILED: drop_newest behaviour" << std::endl;
+    if (oldest.size() == 3 && oldest.front().timestamp == 2 && oldest.back().timestamp == 4 && dropOldest.droppedCount() == 2)
+        std::cout << "SUCCESS: drop_oldest keeps the latest samples and counts drops" << std::endl;
+    else
+        std::cout << "FAILED: drop_oldest behaviour" << std::endl;
+
+    // Capacities below 2 are raised to 2; nothing is overwritten and a full
+    // ring is reported as full instead of wrapping onto unconsumed slots
+    bool smallRings = true;
+    for (size_t requested : {size_t(0), size_t(1)})
+    {
+        SpscRingBuffer<int> spsc(requested);
+        MpscRingBuffer<int> mpsc(requested);
+        int a = -1, b = -1, c = -1;
+        smallRings = smallRings && spsc.capacity() == 2 && spsc.tryPush(1) && spsc.tryPush(2) && !spsc.tryPush(3) &&
+                     spsc.size() == 2 && spsc.tryPop(a) && spsc.tryPop(b) && !spsc.tryPop(c) && a == 1 && b == 2 &&
+                     mpsc.tryPush(1) && mpsc.tryPush(2) && !mpsc.tryPush(3) && mpsc.consume([](int &) {}) == 2;
+        DataBuffer tiny(requested, OverflowPolicy::DROP_OLDEST);
+        for (long long t = 0; t < 4; ++t)
+            tiny.append(makeSample(t));
+        auto kept = tiny.flush();
+        smallRings = smallRings && kept.size() == 2 && kept.back().timestamp == 3 && tiny.droppedCount() == 2;
+    }
+    if (smallRings)
+        std::cout << "SUCCESS: Rings of capacity 0 and 1 hold two items and never overwrite" << std::endl;
+    else
+        std::cout << "FAILED: Small ring capacities" << std::endl;
+
+    // Several producers into a shared buffer drained concurrently: nothing lost or duplicated
+    const int producers = 4;
+    const int perProducer = 5000;
+    SharedDataBuffer shared(64, OverflowPolicy::BLOCK);
+    std::vector<int> seen(producers * perProducer, 0);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; ++p)
+        threads.emplace_back([&shared, p, perProducer]()
+                             {
+                                 for (int i = 0; i < perProducer; ++i)
+                                     shared.append(makeSample(p * perProducer + i)); });
+    size_t received = 0;
+    while (received < seen.size())
+        received += shared.drain([&seen](Sample &s)
+                                 { seen[static_cast<size_t>(s.timestamp)]++; });
+    for (auto &t : threads)
+        t.join();
+
+    bool exactlyOnce = true;
+    for (int count : seen)
+        exactlyOnce = exactlyOnce && count == 1;
+    if (exactlyOnce && shared.droppedCount() == 0)
+        std::cout << "SUCCESS: " << seen.size() << " samples from " << producers << " producers delivered exactly once" << std::endl;
+    else
+        std::cout << "FAILED: Samples lost or duplicated in the shared buffer" << std::endl;
+}
+
+void testSampleLayout()
+{
+    std::cout << "\n=== Test 14: Compact Sample Layout ===" << std::endl;
+
+    Sample s;
+    s.timestamp = 1000;
+    s.setValue(ParameterType::AC_FREQUENCY, 50.0f);
+    s.setValue(ParameterType::OUTPUT_POWER, 1200.0f);
+    std::cout << "sizeof(Sample) = " << sizeof(Sample) << " bytes" << std::endl;
+
+    if (s.hasValue(ParameterType::AC_FREQUENCY) && !s.hasValue(ParameterType::AC_VOLTAGE) &&
+        s.getValue(ParameterType::OUTPUT_POWER) == 1200.0f && s.getValue(ParameterType::AC_VOLTAGE) == 0.0f)
+        std::cout << "SUCCESS: Presence mask tracks set parameters" << std::endl;
+    else
+        std::cout << "FAILED: Presence mask" << std::endl;
+
+    SampleBatch batch;
+    batch.append(s);
+    batch.append(Sample());
+    Sample back = batch.at(0);
+    if (batch.size() == 2 && back.present == s.present && back.timestamp == 1000 &&
+        batch.column(ParameterType::OUTPUT_POWER)[0] == 1200.0f && batch.masks[1] == 0)
+        std::cout << "SUCCESS: Struct-of-arrays batch round trip" << std::endl;
+    else
+        std::cout << "FAILED: Batch round trip" << std::endl;
+}
+
+void testPollScheduler()
+{
+    std::cout << "\n=== Test 15: Deadline Poll Scheduler ===" << std::endl;
+
+    PollingConfig config;
+    config.setParameters({ParameterType::AC_FREQUENCY, ParameterType::TEMPERATURE});
+    config.setParameterInterval(ParameterType::AC_FREQUENCY, std::chrono::milliseconds(1000));
+    config.setParameterInterval(ParameterType::TEMPERATURE, std::chrono::milliseconds(3000));
+
+    auto start = PollScheduler::Clock::now();
+    PollScheduler scheduler(config, std::chrono::milliseconds(1000), start);
+
+    // Simulate six ticks that each finish well within the period
+    int frequencyPolls = 0, temperaturePolls = 0;
+    bool evenlySpaced = true;
+    for (int tick = 0; tick < 6; ++tick)
+    {
+        auto deadline = scheduler.nextDeadline();
+        evenlySpaced = evenlySpaced && scheduler.elapsedMs(deadline) == tick * 1000;
+        ParameterMask due = scheduler.takeDue();
+        frequencyPolls += (due & parameterBit(ParameterType::AC_FREQUENCY)) ? 1 : 0;
+        temperaturePolls += (due & parameterBit(ParameterType::TEMPERATURE)) ? 1 : 0;
+        scheduler.complete(deadline + std::chrono::milliseconds(300));
+    }
+    if (evenlySpaced && frequencyPolls == 6 && temperaturePolls == 2)
+        std::cout << "SUCCESS: Deadlines evenly spaced, per-parameter periods honoured" << std::endl;
+    else
+        std::cout << "FAILED: frequency polled " << frequencyPolls << "x, temperature " << temperaturePolls << "x" << std::endl;
+
+    // A tick taking 2.5 periods overruns and skips to the next deadline on the grid
+    CaptureStderr capture;
+    auto deadline = scheduler.nextDeadline();
+    scheduler.takeDue();
+    bool onTime = scheduler.complete(deadline + std::chrono::milliseconds(2500));
+    if (!onTime && scheduler.overrunCount() == 1 && scheduler.elapsedMs(scheduler.nextDeadline()) == 9000)
+        std::cout << "SUCCESS: Overrun detected and phase preserved" << std::endl;
+    else
+        std::cout << "FAILED: Overrun handling" << std::endl;
+
+    // Sample timestamps are wall-clock epoch milliseconds on the same grid, so
+    // samples persisted across a restart keep an absolute, increasing time base
+    long long now = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        std::chrono::system_clock::now().time_since_epoch())
+                        .count();
+    long long startMs = scheduler.epochMs(start);
+    if (std::llabs(startMs - now) < 1000 &&
+        scheduler.epochMs(scheduler.nextDeadline()) - startMs == scheduler.elapsedMs(scheduler.nextDeadline()))
+        std::cout << "SUCCESS: Sample timestamps in epoch milliseconds on the deadline grid" << std::endl;
+    else
+        std::cout << "FAILED: Epoch timestamp " << startMs << " vs wall clock " << now << std::endl;
+}
+
+void testWorkerPool()
+{
+    std::cout << "\n=== Test 16: Fleet Worker Pool ===" << std::endl;
+
+    // Tasks from many devices run concurrently on a fixed set of threads
+    std::atomic<int> completed(0);
+    std::atomic<int> running(0);
+    std::atomic<int> peak(0);
+    {
+        WorkerPool pool(4);
+        for (int i = 0; i < 16; ++i)
+        {
+            pool.submit([&]()
+                        {
+                            int now = ++running;
+                            int seen = peak.load();
+                            while (now > seen && !peak.compare_exchange_weak(seen, now))
+                                ;
+                            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                            --running;
+                            ++completed; });
+        }
+        pool.shutdown(); // Drains the queue before joining
+
+        if (pool.submit([]() {}))
+            std::cout << "FAILED: Task accepted after shutdown" << std::endl;
+    }
+
+    if (completed == 16 && peak > 1 && peak <= 4)
+        std::cout << "SUCCESS: 16 tasks completed, at most " << peak << " in parallel" << std::endl;
+    else
+        std::cout << "FAILED: completed " << completed << ", peak concurrency " << peak << std::endl;
+}
+
+void testSimServer()
+{
+    std::cout << "\n=== Test 17: Local Inverter SIM ===" << std::endl;
+
+    InverterSimServer sim;
+    if (!sim.start())
+    {
+        std::cout << "FAILED: Could not start local SIM" << std::endl;
+        return;
+    }
+    ModbusHandler handler(Endpoint{"test-key", sim.readUrl(), sim.writeUrl()});
+    std::vector<uint16_t> values;
+
+    // Register bank round trip over HTTP keep-alive
+    bool readOk = handler.readRegisters(0, 10, values) && values.size() == 10 && values[0] == sim.getRegister(0);
+    bool writeOk = handler.writeRegister(InverterSimServer::WRITABLE_REGISTER, 55) &&
+                   sim.getRegister(InverterSimServer::WRITABLE_REGISTER) == 55;
+    if (readOk && writeOk)
+        std::cout << "SUCCESS: Read and write served by local SIM" << std::endl;
+    else
+        std::cout << "FAILED: Read ok=" << readOk << ", write ok=" << writeOk << std::endl;
+
+    // Documented error behaviour
+    {
+        CaptureStderr capture;
+        bool readOnly = handler.writeRegister(0, 0x1234);
+        bool tooMany = handler.readRegisters(0, 200, values);
+        std::string errors = capture.getOutput();
+        if (!readOnly && !tooMany && errors.find("Code 0x2") != std::string::npos &&
+            errors.find("Code 0x3") != std::string::npos)
+            std::cout << "SUCCESS: Illegal address and value exceptions returned" << std::endl;
+        else
+            std::cout << "FAILED: Exception codes not returned" << std::endl;
+    }
+
+    // Fault injection
+    {
+        CaptureStderr capture;
+        sim.setExceptionRate(1.0, 0x06);
+        bool busy = handler.readRegisters(0, 1, values);
+        sim.setExceptionRate(0.0);
+        sim.setCrcErrorRate(1.0);
+        bool corrupted = handler.readRegisters(0, 1, values);
+        sim.setCrcErrorRate(0.0);
+        std::string errors = capture.getOutput();
+        if (!busy && !corrupted && errors.find("Code 0x6") != std::string::npos &&
+            errors.find("CRC error") != std::string::npos)
+            std::cout << "SUCCESS: Injected exceptions and CRC corruption detected" << std::endl;
+        else
+            std::cout << "FAILED: Fault injection not observed" << std::endl;
+    }
+
+    // Latency injection
+    sim.setLatency(20000, 0);
+    auto start = std::chrono::steady_clock::now();
+    handler.readRegisters(0, 1, values);
+    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    if (elapsedMs >= 20)
+        std::cout << "SUCCESS: Request delayed by " << elapsedMs << " ms" << std::endl;
+    else
+        std::cout << "FAILED: Latency not applied (" << elapsedMs << " ms)" << std::endl;
+}
+
+void testMetrics()
+{
+    std::cout << "\n=== Test 18: Metrics Instrumentation ===" << std::endl;
+
+    LatencyHistogram histogram;
+    for (uint64_t us = 1; us <= 1000; ++us)
+        histogram.record(us);
+    if (histogram.count() == 1000 && histogram.percentileUs(0.5) == 512 && histogram.percentileUs(0.99) == 1024)
+        std::cout << "SUCCESS: Histogram buckets and percentiles" << std::endl;
+    else
+        std::cout << "FAILED: p50=" << histogram.percentileUs(0.5) << " p99=" << histogram.percentileUs(0.99) << std::endl;
+
+    // Attempt outcomes are classified per slave and request type
+    InverterSimServer sim;
+    if (!sim.start())
+    {
+        std::cout << "FAILED: Could not start local SIM" << std::endl;
+        return;
+    }
+    ModbusHandler handler(Endpoint{"test-key", sim.readUrl(), sim.writeUrl()});
+    Metrics &metrics = Metrics::getInstance();
+    metrics.reset();
+    std::vector<uint16_t> values;
+    {
+        CaptureStderr capture;
+        handler.readRegisters(0, 2, values, 0x21);
+        sim.setCrcErrorRate(1.0);
+        handler.readRegisters(0, 2, values, 0x21);
+        sim.setCrcErrorRate(0.0);
+        handler.writeRegister(0, 1, 0x21);
+    }
+    const SlaveMetrics *slave = metrics.find(0x21);
+    const RequestStats *reads = slave ? &slave->requests[static_cast<size_t>(RequestType::READ)] : nullptr;
+    const RequestStats *writes = slave ? &slave->requests[static_cast<size_t>(RequestType::WRITE)] : nullptr;
+    if (reads && reads->requests == 2 && reads->failures == 1 &&
+        reads->attempts[static_cast<size_t>(AttemptOutcome::SUCCESS)] == 1 &&
+        reads->attempts[static_cast<size_t>(AttemptOutcome::CRC_ERROR)] == 3 &&
+        writes->attempts[static_cast<size_t>(AttemptOutcome::MODBUS_EXCEPTION)] == 1)
+        std::cout << "SUCCESS: Attempts counted by outcome" << std::endl;
+    else
+        std::cout << "FAILED: Attempt counters" << std::endl;
+
+    metrics.setBufferState(0x21, 3, 30, 2);
+    std::string prom = metrics.renderPrometheus();
+    if (prom.find("ecowatt_modbus_attempts_total{slave=\"0x21\",type=\"read\",outcome=\"crc_error\"} 3") != std::string::npos &&
+        prom.find("ecowatt_buffer_dropped_samples_total{slave=\"0x21\"} 2") != std::string::npos &&
+        prom.find("ecowatt_modbus_request_latency_seconds_count{slave=\"0x21\",type=\"read\"} 2") != std::string::npos)
+        std::cout << "SUCCESS: Prometheus exposition rendered" << std::endl;
+    else
+        std::cout << "FAILED: Prometheus exposition" << std::endl;
+}
+
+void testRetryPolicy()
+{
+    std::cout << "\n=== Test 19: Retry Policy and Circuit Breaker ===" << std::endl;
+
+    RetrySettings settings;
+    settings.maxAttempts = 4;
+    settings.initialBackoff = std::chrono::milliseconds(10);
+    settings.backoffMultiplier = 2.0;
+    settings.maxBackoff = std::chrono::milliseconds(30);
+    settings.jitter = 0.0;
+    settings.deadline = std::chrono::milliseconds(0);
+    RetryPolicy policy(settings);
+
+    bool classified = !policy.isRetryable(AttemptOutcome::MODBUS_EXCEPTION, 0x02) &&
+                      !policy.isRetryable(AttemptOutcome::MODBUS_EXCEPTION, 0x03) &&
+                      policy.isRetryable(AttemptOutcome::MODBUS_EXCEPTION, 0x06) &&
+                      policy.isRetryable(AttemptOutcome::CRC_ERROR, 0) &&
+                      policy.isRetryable(AttemptOutcome::TRANSPORT_FAILURE, 0);
+    bool backoff = policy.backoff(1).count() == 10 && policy.backoff(2).count() == 20 &&
+                   policy.backoff(3).count() == 30 && policy.backoff(5).count() == 30;
+    if (classified && backoff)
+        std::cout << "SUCCESS: Fatal exceptions not retried, backoff grows and is capped" << std::endl;
+    else
+        std::cout << "FAILED: Classification or backoff" << std::endl;
+
+    // An overall deadline stops retries that would end too late
+    settings.deadline = std::chrono::milliseconds(25);
+    RetryPolicy bounded(settings);
+    std::chrono::milliseconds delay;
+    auto started = std::chrono::steady_clock::now();
+    bool first = bounded.nextRetry(1, AttemptOutcome::CRC_ERROR, 0, started, delay);
+    bool second = bounded.nextRetry(2, AttemptOutcome::CRC_ERROR, 0, started - std::chrono::milliseconds(10), delay);
+    if (first && !second)
+        std::cout << "SUCCESS: Deadline bounds the retry budget" << std::endl;
+    else
+        std::cout << "FAILED: Deadline not enforced" << std::endl;
+
+    // A busy device is retried with backoff, then the breaker opens and fails fast
+    InverterSimServer sim;
+    if (!sim.start())
+    {
+        std::cout << "FAILED: Could not start local SIM" << std::endl;
+        return;
+    }
+    ModbusHandler handler(Endpoint{"test-key", sim.readUrl(), sim.writeUrl()});
+    settings.maxAttempts = 3;
+    settings.deadline = std::chrono::milliseconds(0);
+    handler.setRetryPolicy(std::make_shared<RetryPolicy>(settings));
+    handler.setCircuitBreaker(2, std::chrono::milliseconds(100));
+
+    std::vector<uint16_t> values;
+    CaptureStderr capture;
+    sim.setExceptionRate(1.0, 0x06);
+    auto busyStart = std::chrono::steady_clock::now();
+    handler.readRegisters(0, 1, values, 0x31);
+    auto busyMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - busyStart).count();
+    uint64_t served = sim.requestCount();
+    handler.readRegisters(0, 1, values, 0x31); // Second failure opens the breaker
+    bool open = handler.isCircuitOpen(0x31);
+    uint64_t beforeRejected = sim.requestCount();
+    bool rejected = !handler.readRegisters(0, 1, values, 0x31) && sim.requestCount() == beforeRejected;
+    if (served == 3 && busyMs >= 30 && open && rejected)
+        std::cout << "SUCCESS: Busy device backed off (" << busyMs << " ms), breaker opened and failed fast" << std::endl;
+    else
+        std::cout << "FAILED: served=" << served << " busyMs=" << busyMs << " open=" << open << std::endl;
+
+    // After the cooldown a single probe closes the breaker again
+    sim.setExceptionRate(0.0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(120));
+    bool recovered = handler.readRegisters(0, 1, values, 0x31) && !handler.isCircuitOpen(0x31);
+
+    // The asynchronous path backs off through delayed submissions as well
+    sim.setCrcErrorRate(1.0);
+    uint64_t asyncBefore = sim.requestCount();
+    bool asyncOk = handler.readRegistersAsync(0, 1, 0x32).get().ok;
+    sim.setCrcErrorRate(0.0);
+    if (recovered && !asyncOk && sim.requestCount() - asyncBefore == 3)
+        std::cout << "SUCCESS: Breaker closed after cooldown, async retries honoured" << std::endl;
+    else
+        std::cout << "FAILED: recovered=" << recovered << " async attempts=" << sim.requestCount() - asyncBefore << std::endl;
+}
+
+void testSampleUpload()
+{
+    std::cout << "\n=== Test 20: Binary Batch Encoding and Upload ===" << std::endl;
+
+    PollingConfig config;
+    SampleEncoder encoder(config);
+
+    // Periodic samples with slowly drifting values, one parameter only in every other sample
+    SampleBatch batch;
+    for (int i = 0; i < 30; ++i)
+    {
+        Sample sample;
+        sample.timestamp = 1700000000000LL + i * 5000 + (i % 3);
+        sample.setValue(ParameterType::AC_VOLTAGE, 230.0f + (i % 4) * 0.1f);
+        sample.setValue(ParameterType::AC_CURRENT, 5.2f + (i % 2) * 0.1f);
+        sample.setValue(ParameterType::OUTPUT_POWER, 1200.0f + i);
+        if (i % 2 == 0)
+            sample.setValue(ParameterType::TEMPERATURE, 42.5f);
+        batch.append(sample);
+    }
+
+    std::vector<uint8_t> plain, compressed;
+    SampleBatch decoded, decodedCompressed;
+    uint8_t deviceId = 0, deviceIdCompressed = 0;
+    bool encoded = encoder.encode(batch, 0x11, plain, false) && encoder.encode(batch, 0x11, compressed, true);
+    bool roundTrip = encoded && encoder.decode(plain.data(), plain.size(), decoded, deviceId) &&
+                     encoder.decode(compressed.data(), compressed.size(), decodedCompressed, deviceIdCompressed) &&
+                     deviceId == 0x11 && deviceIdCompressed == 0x11 && decoded.size() == batch.size() &&
+                     decodedCompressed.size() == batch.size();
+    for (size_t i = 0; roundTrip && i < batch.size(); ++i)
+    {
+        roundTrip = decoded.timestamps[i] == batch.timestamps[i] && decoded.masks[i] == batch.masks[i] &&
+                    decodedCompressed.timestamps[i] == batch.timestamps[i];
+        for (size_t p = 0; roundTrip && p < PARAMETER_COUNT; ++p)
+            roundTrip = std::fabs(decoded.columns[p][i] - batch.columns[p][i]) < 0.01f &&
+                        decodedCompressed.columns[p][i] == decoded.columns[p][i];
+    }
+
+    // Same samples as the text the upload loop prints
+    size_t textSize = 0;
+    for (size_t i = 0; i < batch.size(); ++i)
+        textSize += ("t=" + std::to_string(batch.timestamps[i]) +
+                     " AC_Voltage=230.1V AC_Current=5.3A Output_Power=1229W Temperature=42.5C\n").size();
+    bool corrupt = !encoder.decode(plain.data(), plain.size() - 1, decoded, deviceId);
+    if (roundTrip && corrupt && plain.size() * 10 < textSize)
+        std::cout << "SUCCESS: " << batch.size() << " samples round-trip in " << plain.size() << " bytes ("
+                  << compressed.size() << " compressed, " << textSize << " as text)" << std::endl;
+    else
+        std::cout << "FAILED: roundTrip=" << roundTrip << " corrupt=" << corrupt << " size=" << plain.size() << std::endl;
+
+    // Upload with retry: the sink answers 503 twice before accepting the batch
+    InverterSimServer sim;
+    if (!sim.start())
+    {
+        std::cout << "FAILED: Could not start local SIM" << std::endl;
+        return;
+    }
+    RetrySettings settings;
+    settings.initialBackoff = std::chrono::milliseconds(5);
+    settings.jitter = 0.0;
+    Uploader uploader(sim.uploadUrl(), "test-key", 2000, settings);
+
+    CaptureStderr capture;
+    sim.failNextUploads(2);
+    bool retried = uploader.upload(compressed) == UploadResult::DELIVERED;
+    std::string received = sim.lastUpload();
+    bool intact = received.size() == compressed.size() &&
+                  std::memcmp(received.data(), compressed.data(), compressed.size()) == 0;
+    sim.failNextUploads(3);
+    bool givenUp = uploader.upload(compressed) == UploadResult::FAILED;
+    if (retried && intact && givenUp && sim.uploadCount() == 1 && uploader.uploadedBatches() == 1 &&
+        uploader.failedBatches() == 1)
+        std::cout << "SUCCESS: Upload retried past 503s and gave up after max attempts" << std::endl;
+    else
+        std::cout << "FAILED: retried=" << retried << " intact=" << intact << " givenUp=" << givenUp << std::endl;
+
+    // A refused payload is reported as permanent on the first answer instead of retried
+    sim.rejectNextUploads(1);
+    bool rejected = uploader.upload(compressed) == UploadResult::REJECTED;
+    bool nextDelivered = uploader.upload(compressed) == UploadResult::DELIVERED;
+    if (rejected && nextDelivered && uploader.rejectedBatches() == 1 && uploader.failedBatches() == 2 &&
+        sim.uploadCount() == 2)
+        std::cout << "SUCCESS: 413 reported as a permanent rejection without retries" << std::endl;
+    else
+        std::cout << "FAILED: rejected=" << rejected << " nextDelivered=" << nextDelivered
+                  << " rejectedBatches=" << uploader.rejectedBatches() << std::endl;
+
+    // Wrong credentials or URL are not the payload's fault: the stored backlog
+    // stays put under the upload loop's rule (commit unless FAILED)
+    char dirTemplate[] = "/tmp/ecowatt-upload-XXXXXX";
+    if (!mkdtemp(dirTemplate))
+    {
+        std::cout << "FAILED: Could not create a temporary directory" << std::endl;
+        return;
+    }
+    std::string dir = dirTemplate;
+    bool kept = true;
+    {
+        SampleStore store(dir, 16, 4);
+        kept = store.open();
+        for (size_t i = 0; i < batch.size() && kept; ++i)
+        {
+            Sample sample;
+            sample.timestamp = batch.timestamps[i];
+            sample.setValue(ParameterType::AC_VOLTAGE, batch.column(ParameterType::AC_VOLTAGE)[i]);
+            kept = store.append(sample);
+        }
+        store.flush();
+        size_t stored = store.size();
+        const int statuses[] = {401, 404};
+        for (int status : statuses)
+        {
+            SampleBatch peeked;
+            std::vector<uint8_t> payload;
+            sim.rejectNextUploads(1, status);
+            kept = kept && store.peek(peeked, 8) > 0 && encoder.encode(peeked, 0x11, payload, false);
+            UploadResult result = uploader.upload(payload);
+            if (result != UploadResult::FAILED)
+                store.commit();
+            kept = kept && result == UploadResult::FAILED && store.size() == stored;
+        }
+    }
+    std::system(("rm -rf " + dir).c_str());
+    if (kept)
+        std::cout << "SUCCESS: 401 and 404 keep the stored backlog for a later attempt" << std::endl;
+    else
+        std::cout << "FAILED: Stored samples lost on an authentication or URL error" << std::endl;
+}
+
+void testSampleStore()
+{
+    std::cout << "\n=== Test 21: Persistent Sample Store ===" << std::endl;
+
+    char dirTemplate[] = "/tmp/ecowatt-store-XXXXXX";
+    if (!mkdtemp(dirTemplate))
+    {
+        std::cout << "FAILED: Could not create a temporary directory" << std::endl;
+        return;
+    }
+    std::string dir = dirTemplate;
+
+    auto makeSample = [](int i)
+    {
+        Sample sample;
+        sample.timestamp = 1000LL * i;
+        sample.setValue(ParameterType::AC_VOLTAGE, 230.0f + i);
+        return sample;
+    };
+
+    // Rollover across small segments, then a partial commit
+    SampleBatch batch;
+    bool appended = true, firstBatch = false;
+    {
+        SampleStore store(dir, 4, 8);
+        appended = store.open();
+        for (int i = 0; i < 10 && appended; ++i)
+            appended = store.append(makeSample(i));
+        firstBatch = store.peek(batch, 6) == 6 && batch.timestamps[5] == 5000 && store.commit() &&
+                     store.size() == 4 && store.segmentCount() == 2;
+        store.peek(batch, 2); // Peeked but never committed, as if the upload failed before a crash
+    }
+
+    // Reopening resumes at the persisted cursor
+    bool resumed = false;
+    {
+        SampleStore store(dir, 4, 8);
+        resumed = store.open() && store.size() == 4 && store.peek(batch, 10) == 4 &&
+                  batch.timestamps[0] == 6000 && batch.column(ParameterType::AC_VOLTAGE)[3] == 239.0f;
+    }
+    if (appended && firstBatch && resumed)
+        std::cout << "SUCCESS: Samples roll over segments and resume at the cursor after reopen" << std::endl;
+    else
+        std::cout << "FAILED: appended=" << appended << " firstBatch=" << firstBatch << " resumed=" << resumed << std::endl;
+
+    // A torn last record is discarded and overwritten by the next append
+    {
+        FILE *segment = std::fopen((dir + "/seg-0000000000000002.dat").c_str(), "r+b");
+        if (segment)
+        {
+            std::fseek(segment, static_cast<long>(SampleStore::HEADER_SIZE + SampleStore::RECORD_SIZE + 20), SEEK_SET);
+            std::fputc(0x5A, segment);
+            std::fclose(segment);
+        }
+    }
+    bool torn = false;
+    {
+        SampleStore store(dir, 4, 8);
+        torn = store.open() && store.size() == 3 && store.append(makeSample(42)) &&
+               store.peek(batch, 10) == 4 && batch.timestamps[3] == 42000;
+    }
+
+    // The segment cap bounds disk use by dropping the oldest unsent samples
+    std::string cappedDir = dir + "/capped";
+    SampleStore capped(cappedDir, 4, 2);
+    bool bounded = capped.open();
+    for (int i = 0; i < 20 && bounded; ++i)
+        bounded = capped.append(makeSample(i));
+    bounded = bounded && capped.size() == 8 && capped.droppedCount() == 12 && capped.segmentCount() == 2 &&
+              capped.peek(batch, 1) == 1 && batch.timestamps[0] == 12000;
+    capped.close();
+
+    // A peek spanning the front segment survives that segment being dropped at
+    // the cap: its commit still consumes the records read from the next one
+    std::string spanDir = dir + "/span";
+    SampleStore span(spanDir, 4, 2);
+    bool spanning = span.open();
+    for (int i = 0; i < 8 && spanning; ++i)
+        spanning = span.append(makeSample(i));
+    spanning = spanning && span.peek(batch, 6) == 6 && span.append(makeSample(8)) && span.commit() &&
+               span.droppedCount() == 0 && span.size() == 3 && span.peek(batch, 10) == 3 &&
+               batch.timestamps[0] == 6000;
+    span.close();
+
+    if (torn && bounded && spanning)
+        std::cout << "SUCCESS: Torn record discarded on recovery, segment cap enforced" << std::endl;
+    else
+        std::cout << "FAILED: torn=" << torn << " bounded=" << bounded << " spanning=" << spanning << std::endl;
+
+    std::system(("rm -rf " + dir).c_str());
+}
+
+void testTcpTransports()
+{
+    std::cout << "\n=== Test 22: Modbus TCP and RTU-over-TCP Transports ===" << std::endl;
+
+    InverterSimServer sim;
+    if (!sim.start())
+    {
+        std::cout << "FAILED: Could not start local SIM" << std::endl;
+        return;
+    }
+
+    // Frame lengths of raw RTU streams come from the function code
+    const uint8_t readHead[] = {0x11, 0x03, 0x14};
+    const uint8_t exceptionHead[] = {0x11, 0x83, 0x02};
+    const uint8_t writeMultipleHead[] = {0x11, 0x10, 0x00, 0x08, 0x00, 0x02, 0x04};
+    size_t readLength, exceptionLength, partialLength, writeMultipleLength;
+    bool framing = ModbusFrame::rtuResponseLength(readHead, 3, readLength) && readLength == 25 &&
+                   ModbusFrame::rtuResponseLength(exceptionHead, 3, exceptionLength) && exceptionLength == 5 &&
+                   ModbusFrame::rtuRequestLength(writeMultipleHead, 6, partialLength) && partialLength == 0 &&
+                   ModbusFrame::rtuRequestLength(writeMultipleHead, 7, writeMultipleLength) && writeMultipleLength == 13;
+    if (framing)
+        std::cout << "SUCCESS: RTU frame lengths derived from function code" << std::endl;
+    else
+        std::cout << "FAILED: RTU frame length detection" << std::endl;
+
+    const TransportType types[] = {TransportType::MODBUS_TCP, TransportType::RTU_OVER_TCP};
+    for (TransportType type : types)
+    {
+        sim.resetRegisters();
+        uint64_t connectionsBefore = sim.connectionCount();
+        ModbusHandler handler(sim.endpoint(type));
+        handler.setRetryPolicy(std::make_shared<RetryPolicy>(RetrySettings()));
+
+        std::vector<uint16_t> values;
+        bool read = handler.readRegisters(0, 10, values, 0x11) && values.size() == 10 && values[0] == 2300;
+        bool written = handler.writeRegister(8, 55, 0x11) && sim.getRegister(8) == 55;
+        ReadResult async = handler.readRegistersAsync(8, 1, 0x11).get();
+        bool asyncRead = async.ok && async.values.size() == 1 && async.values[0] == 55;
+
+        CaptureStderr capture;
+        uint64_t requestsBefore = sim.requestCount();
+        bool rejected = !handler.readRegisters(9, 5, values, 0x11) && sim.requestCount() == requestsBefore + 1;
+        // One persistent connection carried every request
+        bool persistent = sim.connectionCount() == connectionsBefore + 1;
+
+        if (read && written && asyncRead && rejected && persistent)
+            std::cout << "SUCCESS: " << transportTypeName(type)
+                      << " read, write, async read and exception over one connection" << std::endl;
+        else
+            std::cout << "FAILED: " << transportTypeName(type) << " read=" << read << " written=" << written
+                      << " async=" << asyncRead << " rejected=" << rejected << " persistent=" << persistent << std::endl;
+    }
+
+    // RTU frames keep their CRC on the wire, so corruption is still caught
+    ModbusHandler rtu(sim.endpoint(TransportType::RTU_OVER_TCP));
+    RetrySettings settings;
+    settings.initialBackoff = std::chrono::milliseconds(1);
+    rtu.setRetryPolicy(std::make_shared<RetryPolicy>(settings));
+    std::vector<uint16_t> values;
+    CaptureStderr capture;
+    sim.setCrcErrorRate(1.0);
+    uint64_t before = sim.requestCount();
+    bool corrupt = !rtu.readRegisters(0, 1, values, 0x11) && sim.requestCount() - before == 3;
+    sim.setCrcErrorRate(0.0);
+
+    // An unreachable gateway is a transport failure, not a hang
+    Endpoint closed = sim.endpoint(TransportType::MODBUS_TCP);
+    closed.port = 1;
+    ModbusHandler unreachable(closed);
+    unreachable.setRetryPolicy(std::make_shared<RetryPolicy>(settings));
+    bool refused = !unreachable.readRegisters(0, 1, values, 0x11);
+    if (corrupt && refused)
+        std::cout << "SUCCESS: RTU CRC errors retried, unreachable gateway fails fast" << std::endl;
+    else
+        std::cout << "FAILED: corrupt=" << corrupt << " refused=" << refused << std::endl;
+}
+
+void testPipelinedModbusTcp()
+{
+    std::cout << "\n=== Test 23: Pipelined Modbus TCP Transactions ===" << std::endl;
+
+    InverterSimServer sim;
+    if (!sim.start())
+    {
+        std::cout << "FAILED: Could not start local SIM" << std::endl;
+        return;
+    }
+    sim.resetRegisters();
+
+    // Every read takes 20-40 ms of device think time, answered in random order
+    sim.setLatency(20000, 20000);
+    uint64_t connectionsBefore = sim.connectionCount();
+    TcpTransport transport(TransportType::MODBUS_TCP, "127.0.0.1", sim.modbusTcpPort(), 2000, 4);
+
+    const uint16_t count = 16;
+    std::mutex mutex;
+    std::condition_variable doneWake;
+    uint16_t completed = 0;
+    uint16_t matched = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint16_t i = 0; i < count; ++i)
+    {
+        uint16_t addr = i % 10;
+        FrameBuffer request;
+        ModbusFrame::buildReadRequest(0x11, addr, 1, request);
+        transport.transactAsync(RequestType::READ, request, [&, addr](bool ok, const FrameBuffer &response)
+                                {
+                                    uint16_t value = 0;
+                                    bool valid = ok && ModbusFrame::parseReadResponse(response.data, response.size, 1, &value) &&
+                                                 value == sim.getRegister(addr);
+                                    std::lock_guard<std::mutex> lock(mutex);
+                                    matched += valid ? 1 : 0;
+                                    completed++;
+                                    doneWake.notify_one(); });
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        doneWake.wait_for(lock, std::chrono::seconds(5), [&]()
+                          { return completed == count; });
+    }
+    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+
+    // Lockstep would need at least 16 x 20 ms; a window of 4 needs about a quarter
+    const ModbusTcpSession &session = *transport.session();
+    if (matched == count && session.peakInFlight() == 4 && elapsedMs < 250 &&
+        sim.connectionCount() == connectionsBefore + 1)
+        std::cout << "SUCCESS: " << count << " transactions matched by id, window of "
+                  << session.peakInFlight() << " on one connection (" << elapsedMs << " ms)" << std::endl;
+    else
+        std::cout << "FAILED: matched=" << matched << "/" << count << " peak=" << session.peakInFlight()
+                  << " elapsed=" << elapsedMs << " ms" << std::endl;
+
+    // Transports to the same gateway share the session
+    TcpTransport other(TransportType::MODBUS_TCP, "127.0.0.1", sim.modbusTcpPort(), 2000, 4);
+    if (other.session() == transport.session())
+        std::cout << "SUCCESS: Transports to one gateway share a pipelined session" << std::endl;
+    else
+        std::cout << "FAILED: Separate sessions for the same gateway" << std::endl;
+
+    // A transaction past its deadline fails on its own, without waiting for the device
+    TcpTransport shortTimeout(TransportType::MODBUS_TCP, "localhost", sim.modbusTcpPort(), 50, 4);
+    sim.setLatency(300000, 0);
+    FrameBuffer request, response;
+    ModbusFrame::buildReadRequest(0x11, 0, 1, request);
+    start = std::chrono::steady_clock::now();
+    bool timedOut = !shortTimeout.transact(RequestType::READ, request, response);
+    elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    sim.setLatency(0, 0);
+    bool recovered = shortTimeout.transact(RequestType::READ, request, response) && response.size == 7;
+    if (timedOut && elapsedMs < 200 && shortTimeout.session()->timeoutCount() == 1 && recovered)
+        std::cout << "SUCCESS: Per-transaction timeout after " << elapsedMs << " ms, next transaction succeeds" << std::endl;
+    else
+        std::cout << "FAILED: timedOut=" << timedOut << " elapsed=" << elapsedMs << " ms recovered=" << recovered << std::endl;
+}
+
+void testMultipleRegisterWrites()
+{
+    std::cout << "\n=== Test 24: Write Multiple (FC16) and Read/Write Multiple (FC23) ===" << std::endl;
+
+    // Frame layout and protocol limits
+    const uint16_t values[] = {0x0102, 0x0304};
+    FrameBuffer fc16, fc23, rejected;
+    size_t fc16Length, fc23Length;
+    bool built = ModbusFrame::buildWriteMultipleRequest(0x11, 0x0008, values, 2, fc16) && fc16.size == 13 &&
+                 fc16.data[1] == 0x10 && fc16.data[5] == 2 && fc16.data[6] == 4 && fc16.data[7] == 0x01 &&
+                 fc16.data[10] == 0x04 && ModbusFrame::rtuRequestLength(fc16.data, fc16.size, fc16Length) &&
+                 fc16Length == fc16.size &&
+                 ModbusFrame::buildReadWriteMultipleRequest(0x11, 7, 3, 8, values, 1, fc23) && fc23.size == 15 &&
+                 fc23.data[1] == 0x17 && fc23.data[9] == 1 && fc23.data[10] == 2 &&
+                 ModbusFrame::rtuRequestLength(fc23.data, fc23.size, fc23Length) && fc23Length == fc23.size &&
+                 !ModbusFrame::buildWriteMultipleRequest(0x11, 0, values, 0, rejected) &&
+                 !ModbusFrame::buildWriteMultipleRequest(0x11, 0, values, MODBUS_MAX_WRITE_REGISTERS + 1, rejected) &&
+                 !ModbusFrame::buildReadWriteMultipleRequest(0x11, 0, MODBUS_MAX_READ_REGISTERS + 1, 8, values, 1, rejected);
+    if (built)
+        std::cout << "SUCCESS: FC16/FC23 frames built with byte counts, limits enforced" << std::endl;
+    else
+        std::cout << "FAILED: FC16/FC23 frame layout" << std::endl;
+
+    InverterSimServer sim;
+    if (!sim.start())
+    {
+        std::cout << "FAILED: Could not start local SIM" << std::endl;
+        return;
+    }
+    sim.setWritable(5, true);
+    sim.setWritable(6, true);
+    sim.setWritable(7, true);
+
+    const TransportType types[] = {TransportType::HTTP, TransportType::MODBUS_TCP, TransportType::RTU_OVER_TCP};
+    for (TransportType type : types)
+    {
+        sim.resetRegisters();
+        Inverter inverter(0x11, sim.endpoint(type));
+        ModbusHandler &handler = inverter.getModbusHandler();
+
+        // Four setpoints in one round trip
+        uint64_t before = sim.requestCount();
+        bool written = inverter.setRegisters(5, {81, 82, 430, 40}) && sim.requestCount() == before + 1 &&
+                       sim.getRegister(5) == 81 && sim.getRegister(6) == 82 && sim.getRegister(7) == 430 &&
+                       sim.getRegister(8) == 40;
+
+        // One invalid value rejects the whole block
+        bool atomic;
+        {
+            CaptureStderr capture;
+            before = sim.requestCount();
+            atomic = !handler.writeRegisters(7, {500, 150}) && sim.requestCount() == before + 1 &&
+                     sim.getRegister(7) == 430 && sim.getRegister(8) == 40;
+        }
+
+        // Write and read back in one transaction; the device writes first
+        float temperature = 0.0f;
+        int exportPercent = 0, outputPower = 0;
+        before = sim.requestCount();
+        bool readWrite = inverter.setExportPowerPercentAndGetStatus(65, temperature, exportPercent, outputPower) &&
+                         sim.requestCount() == before + 1 && exportPercent == 65 && temperature == 43.0f &&
+                         outputPower == 1200;
+
+        std::promise<bool> done;
+        handler.writeRegistersAsync(5, {91, 92}, [&done](bool ok)
+                                    { done.set_value(ok); });
+        bool async = done.get_future().get() && sim.getRegister(5) == 91 && sim.getRegister(6) == 92;
+
+        if (written && atomic && readWrite && async)
+            std::cout << "SUCCESS: " << transportTypeName(type)
+                      << " block write, all-or-nothing rejection, write+read and async block write" << std::endl;
+        else
+            std::cout << "FAILED: " << transportTypeName(type) << " written=" << written << " atomic=" << atomic
+                      << " readWrite=" << readWrite << " async=" << async << std::endl;
+    }
+}
+
+void testRegisterMap()
+{
+    std::cout << "\n=== Test 25: Register map descriptors ===" << std::endl;
+
+    // The built-in map is the SIM layout the fixed getters always used
+    RegisterMap builtin;
+    const RegisterDescriptor *voltage = builtin.find("AC_Voltage");
+    const RegisterDescriptor *frequency = builtin.find("AC_Frequency");
+    const RegisterDescriptor *exportReg = builtin.find("Export_Power_Percent");
+    const RegisterDescriptor *power = builtin.find("Output_Power");
+    PollingConfig defaults(builtin);
+    bool builtinOk = builtin.size() == PARAMETER_COUNT && voltage && voltage->address == 0 && voltage->gain == 10.0f &&
+                     frequency && frequency->address == 2 && frequency->gain == 100.0f && exportReg &&
+                     exportReg->writable() && power && power->address == 9 && !power->writable() &&
+                     defaults.getParameterConfig(ParameterType::TEMPERATURE).registerAddress == 7 &&
+                     defaults.getParameterConfig(ParameterType::TEMPERATURE).available;
+    if (builtinOk)
+        std::cout << "SUCCESS: Built-in map matches the SIM register layout" << std::endl;
+    else
+        std::cout << "FAILED: Built-in register map" << std::endl;
+
+    // Word order and sign handling of the value formats
+    uint16_t words[2];
+    bool formats = RegisterMap::encodeRaw(RegisterFormat::S32, -2, words) && words[0] == 0xFFFF &&
+                   words[1] == 0xFFFE && RegisterMap::rawValue(RegisterFormat::S32, words) == -2 &&
+                   RegisterMap::encodeRaw(RegisterFormat::U32, 70000, words) && words[0] == 1 &&
+                   RegisterMap::rawValue(RegisterFormat::U32, words) == 70000 &&
+                   RegisterMap::rawValue(RegisterFormat::S16, words + 1) == 70000 - 65536 &&
+                   !RegisterMap::encodeRaw(RegisterFormat::U16, 70000, words) &&
+                   !RegisterMap::encodeRaw(RegisterFormat::S16, 40000, words);
+    if (formats)
+        std::cout << "SUCCESS: u16/s16/u32/s32 encode and decode, out-of-range values rejected" << std::endl;
+    else
+        std::cout << "FAILED: Register value formats" << std::endl;
+
+    // Another model: AC block moved up, signed temperature, 32-bit output power
+    RegisterMap model;
+    std::istringstream descriptor("# name  address  format  gain  unit  access\n"
+                                  "Temperature           0  s16  10  C  r\n"
+                                  "Export_Power_Percent  1  u16  1   %  rw  # setpoint\n"
+                                  "\n"
+                                  "Output_Power          2  u32  1   W  r\n"
+                                  "AC_Voltage            4  u16  10  V  r\n"
+                                  "AC_Current            5  u16  10  A  r\n");
+    bool loaded = model.load(descriptor, "model") && model.size() == 5;
+
+    // Invalid descriptors are rejected as a whole
+    const char *invalid[] = {"AC_Voltage 0 u16 10 V r\nAC_Voltage 1 u16 10 V r\n",
+                             "AC_Voltage 0 f32 10 V r\n",
+                             "AC_Voltage 0 u16 10 V\n",
+                             "AC_Voltage 0 u16 0 V r\n",
+                             "Output_Power 0xFFFF u32 1 W r\n",
+                             "# nothing\n"};
+    bool rejected = true;
+    {
+        CaptureStderr capture;
+        for (const char *text : invalid)
+        {
+            std::istringstream in(text);
+            rejected = rejected && !model.load(in, "invalid");
+        }
+    }
+    rejected = rejected && model.size() == 5 && model.find("Output_Power")->format == RegisterFormat::U32;
+    if (loaded && rejected)
+        std::cout << "SUCCESS: Descriptor parsed, invalid descriptors leave the map unchanged" << std::endl;
+    else
+        std::cout << "FAILED: Descriptor parsing loaded=" << loaded << " rejected=" << rejected << std::endl;
+
+    // Parameters the model lacks cannot be enabled; block reads honour value widths
+    PollingConfig config(model);
+    bool unavailable;
+    {
+        CaptureStderr capture;
+        config.setParameters({ParameterType::TEMPERATURE, ParameterType::OUTPUT_POWER, ParameterType::AC_VOLTAGE,
+                              ParameterType::AC_CURRENT, ParameterType::PV1_VOLTAGE});
+        unavailable = config.getEnabledParameters().size() == 4 &&
+                      !config.getParameterConfig(ParameterType::PV1_VOLTAGE).available;
+    }
+    PollPlanner planner(config);
+    const std::vector<ReadBlock> &blocks = planner.currentPlan();
+    bool planned = unavailable && blocks.size() == 2 && blocks[0].startAddr == 0 && blocks[0].numRegs == 1 &&
+                   blocks[1].startAddr == 2 && blocks[1].numRegs == 4;
+
+    InverterSimServer sim;
+    if (!sim.start())
+    {
+        std::cout << "FAILED: Could not start local SIM" << std::endl;
+        return;
+    }
+    sim.setRegister(0, static_cast<uint16_t>(-125)); // -12.5 C
+    sim.setRegister(1, 40);
+    sim.setRegister(2, 0x0001); // 65538 W
+    sim.setRegister(3, 0x0002);
+    sim.setRegister(4, 2301);
+    sim.setRegister(5, 52);
+    sim.setWritable(1, true);
+
+    Inverter inverter(0x11, sim.endpoint(TransportType::MODBUS_TCP), model);
+    Sample sample;
+    bool decoded = planner.execute(inverter, sample) && sample.getValue(ParameterType::TEMPERATURE) == -12.5f &&
+                   sample.getValue(ParameterType::OUTPUT_POWER) == 65538.0f &&
+                   std::fabs(sample.getValue(ParameterType::AC_VOLTAGE) - 230.1f) < 0.01f &&
+                   std::fabs(sample.getValue(ParameterType::AC_CURRENT) - 5.2f) < 0.01f;
+    if (planned && decoded)
+        std::cout << "SUCCESS: Planner split blocks by width and decoded signed and 32-bit values" << std::endl;
+    else
+        std::cout << "FAILED: Planner with custom map planned=" << planned << " decoded=" << decoded << std::endl;
+
+    // The typed getters follow the map too
+    float temperature = 0.0f, pv1 = 0.0f;
+    int exportPercent = 0, outputPower = 0;
+    uint64_t before = sim.requestCount();
+    bool status = inverter.getSystemStatus(temperature, exportPercent, outputPower) &&
+                  sim.requestCount() == before + 1 && temperature == -12.5f && exportPercent == 40 &&
+                  outputPower == 65538;
+    bool written = inverter.setExportPowerPercentAndGetStatus(75, temperature, exportPercent, outputPower) &&
+                   sim.getRegister(1) == 75 && exportPercent == 75;
+    bool guarded;
+    {
+        CaptureStderr capture;
+        before = sim.requestCount();
+        guarded = !inverter.getPV1Voltage(pv1) && !inverter.writeParameter(ParameterType::OUTPUT_POWER, 10.0f) &&
+                  sim.requestCount() == before;
+    }
+    if (status && written && guarded)
+        std::cout << "SUCCESS: Inverter reads and writes through the custom map, unmapped access refused" << std::endl;
+    else
+        std::cout << "FAILED: Inverter with custom map status=" << status << " written=" << written
+                  << " guarded=" << guarded << std::endl;
+}
+
+// Checks one FixedRegister against the runtime descriptor of the same name
+template <typename R>
+static bool fixedMatches(const RegisterMap &map)
+{
+    const RegisterDescriptor *reg = map.find(parameterName(R::PARAMETER));
+    return reg && reg->address == R::ADDRESS && reg->format == R::FORMAT && reg->gain == R::GAIN;
+}
+
+void testRegisterCodec()
+{
+    std::cout << "\n=== Test 26: Specialised register decoders ===" << std::endl;
+
+    static_assert(SimRegisterLayout::START == 0 && SimRegisterLayout::COUNT == 10 &&
+                      SimRegisterLayout::MASK == (1u << PARAMETER_COUNT) - 1,
+                  "SIM layout spans registers 0-9");
+    RegisterMap builtin;
+    bool layout = fixedMatches<FixedRegister<ParameterType::AC_FREQUENCY, 2, RegisterFormat::U16, 100>>(builtin) &&
+                  fixedMatches<FixedRegister<ParameterType::TEMPERATURE, 7, RegisterFormat::U16, 10>>(builtin) &&
+                  fixedMatches<FixedRegister<ParameterType::OUTPUT_POWER, 9, RegisterFormat::U16, 1>>(builtin);
+
+    // The planned block decode and the build-time layout agree with raw / gain
+    PollingConfig config(builtin);
+    for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+        config.addParameter(static_cast<ParameterType>(i));
+    PollPlanner planner(config);
+    const std::vector<ReadBlock> &blocks = planner.currentPlan();
+    std::vector<uint16_t> registers = {2301, 52, 5002, 3505, 3498, 81, 79, 431, 100, 1187};
+    Sample planned, fixed;
+    bool decoded = blocks.size() == 1 && blocks[0].runs.size() == 1 && blocks[0].runs[0].count == PARAMETER_COUNT;
+    if (decoded)
+    {
+        PollPlanner::decodeBlock(blocks[0], registers, planned);
+        SimRegisterLayout::decode(registers.data(), fixed);
+        for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+        {
+            ParameterType param = static_cast<ParameterType>(i);
+            float expected = registers[i] / config.getParameterConfig(param).gain;
+            decoded = decoded && planned.hasValue(param) && fixed.hasValue(param) &&
+                      std::fabs(planned.getValue(param) - expected) <= expected * 1e-6f &&
+                      planned.getValue(param) == fixed.getValue(param);
+        }
+    }
+    if (layout && decoded)
+        std::cout << "SUCCESS: Fixed SIM layout matches the built-in map; one batch run decodes all 10 registers" << std::endl;
+    else
+        std::cout << "FAILED: Built-in layout decode layout=" << layout << " decoded=" << decoded << std::endl;
+
+    // A format change or a gap in the Sample slots starts a new run
+    RegisterMap model;
+    std::istringstream descriptor("AC_Voltage    0  u16  10  V  r\n"
+                                  "AC_Current    1  u16  10  A  r\n"
+                                  "Temperature   2  s16  10  C  r\n"
+                                  "Output_Power  3  s32  1   W  r\n");
+    bool split = model.load(descriptor, "model");
+    PollingConfig mixedConfig(model);
+    mixedConfig.setParameters({ParameterType::AC_VOLTAGE, ParameterType::AC_CURRENT, ParameterType::TEMPERATURE,
+                               ParameterType::OUTPUT_POWER});
+    PollPlanner mixedPlanner(mixedConfig);
+    const std::vector<ReadBlock> &mixed = mixedPlanner.currentPlan();
+    split = split && mixed.size() == 1 && mixed[0].numRegs == 5 && mixed[0].runs.size() == 3 &&
+            mixed[0].runs[0].count == 2 && mixed[0].runs[2].format == RegisterFormat::S32;
+
+    // A short response yields only the values it fully contains
+    Sample partial;
+    bool truncated = false;
+    if (split)
+    {
+        PollPlanner::decodeBlock(mixed[0], {2301, 52, static_cast<uint16_t>(-105), 0xFFFF}, partial);
+        truncated = partial.getValue(ParameterType::TEMPERATURE) == -10.5f &&
+                    partial.hasValue(ParameterType::AC_CURRENT) && !partial.hasValue(ParameterType::OUTPUT_POWER);
+    }
+    if (split && truncated)
+        std::cout << "SUCCESS: Runs split on format and slot changes, short responses decoded up to the last whole value" << std::endl;
+    else
+        std::cout << "FAILED: Mixed layout runs split=" << split << " truncated=" << truncated << std::endl;
+}
+
+void testRegisterCache()
+{
+    std::cout << "\n=== Test 27: Register cache with staleness budgets ===" << std::endl;
+
+    InverterSimServer sim;
+    if (!sim.start())
+    {
+        std::cout << "FAILED: Could not start local SIM" << std::endl;
+        return;
+    }
+    Inverter inverter(0x11, sim.endpoint(TransportType::MODBUS_TCP));
+    const Inverter::MaxAge second(1000);
+
+    // One miss refreshes the whole block; every other parameter is then served from memory
+    float temperature = 0.0f, voltage = 0.0f, current = 0.0f, frequency = 0.0f;
+    float pv1Voltage, pv2Voltage, pv1Current, pv2Current;
+    int exportPercent = 0, outputPower = 0;
+    uint64_t before = sim.requestCount();
+    bool coalesced = inverter.getTemperature(temperature, second) &&
+                     inverter.getACMeasurements(voltage, current, frequency, second) &&
+                     inverter.getPVMeasurements(pv1Voltage, pv2Voltage, pv1Current, pv2Current, second) &&
+                     inverter.getSystemStatus(temperature, exportPercent, outputPower, second) &&
+                     sim.requestCount() == before + 1 && inverter.cacheMisses() == 1 && inverter.cacheHits() == 3 &&
+                     temperature == sim.getRegister(7) / 10.0f && outputPower == sim.getRegister(9);
+    if (coalesced)
+        std::cout << "SUCCESS: Four reads within budget cost one block read" << std::endl;
+    else
+        std::cout << "FAILED: Cached reads took " << sim.requestCount() - before << " requests" << std::endl;
+
+    // A zero budget always reads; an expired entry is refreshed
+    before = sim.requestCount();
+    bool uncached = inverter.getACVoltage(voltage) && sim.requestCount() == before + 1;
+    sim.setRegister(7, 512);
+    bool cachedOld = inverter.getTemperature(temperature, second) && temperature != 51.2f;
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    bool refreshed = inverter.getTemperature(temperature, Inverter::MaxAge(20)) && temperature == 51.2f;
+    if (uncached && cachedOld && refreshed)
+        std::cout << "SUCCESS: Zero budget bypasses the cache, entries older than the budget are re-read" << std::endl;
+    else
+        std::cout << "FAILED: Budgets uncached=" << uncached << " cachedOld=" << cachedOld
+                  << " refreshed=" << refreshed << std::endl;
+
+    // Writes invalidate what they touched; poll cycles fill the cache
+    bool written = inverter.setExportPowerPercent(35) && inverter.getExportPowerPercent(exportPercent, second) &&
+                   exportPercent == 35;
+    inverter.invalidateCache();
+    PollingConfig config;
+    config.setParameters({ParameterType::AC_VOLTAGE, ParameterType::AC_CURRENT});
+    PollPlanner planner(config);
+    Sample sample;
+    bool polled = planner.execute(inverter, sample);
+    before = sim.requestCount();
+    polled = polled && inverter.getACCurrent(current, second) && sim.requestCount() == before &&
+             current == sample.getValue(ParameterType::AC_CURRENT);
+    if (written && polled)
+        std::cout << "SUCCESS: Writes invalidate cached registers, planner polls feed the cache" << std::endl;
+    else
+        std::cout << "FAILED: Cache coherence written=" << written << " polled=" << polled << std::endl;
+
+    // A read that began before a write and completes after it must not re-cache the old value
+    Sample stale;
+    stale.setValue(ParameterType::EXPORT_POWER_PERCENT, 35.0f);
+    stale.setValue(ParameterType::OUTPUT_POWER, 1000.0f);
+    uint64_t readStarted = inverter.writeGeneration();
+    bool rewritten = inverter.setExportPowerPercent(60);
+    inverter.cacheValues(stale, stale.present, readStarted);
+    before = sim.requestCount();
+    bool kept = inverter.getOutputPower(outputPower, second) && outputPower == 1000 && sim.requestCount() == before;
+    bool dropped = rewritten && inverter.getExportPowerPercent(exportPercent, second) && exportPercent == 60 &&
+                   sim.requestCount() == before + 1;
+    if (dropped && kept)
+        std::cout << "SUCCESS: Reads started before a write do not re-cache the written registers" << std::endl;
+    else
+        std::cout << "FAILED: Stale read dropped=" << dropped << " kept=" << kept << std::endl;
+}
+
+void testReadCoalescing()
+{
+    std::cout << "\n=== Test 28: Single-flight register reads ===" << std::endl;
+
+    InverterSimServer sim;
+    if (!sim.start())
+    {
+        std::cout << "FAILED: Could not start local SIM" << std::endl;
+        return;
+    }
+    sim.setLatency(20000, 0); // Keeps the first read in flight while the others arrive
+    ModbusHandler handler(sim.endpoint(TransportType::MODBUS_TCP));
+    handler.setReadCoalescing(true);
+
+    // Concurrent readers of covered ranges share one request
+    const int readers = 6;
+    std::atomic<int> correct(0);
+    uint64_t before = sim.requestCount();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < readers; ++i)
+    {
+        threads.emplace_back([&, i]()
+                             {
+                                 if (i > 0)
+                                     std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                                 uint16_t start = static_cast<uint16_t>(i == 0 ? 0 : i % 4);
+                                 uint16_t count = static_cast<uint16_t>(i == 0 ? 10 : 3);
+                                 std::vector<uint16_t> values;
+                                 if (handler.readRegisters(start, count, values) && values.size() == count &&
+                                     values[0] == sim.getRegister(start) &&
+                                     values[count - 1] == sim.getRegister(start + count - 1))
+                                     correct++; });
+    }
+    for (auto &t : threads)
+        t.join();
+    bool shared = correct == readers && sim.requestCount() == before + 1 &&
+                  handler.readCoalescer().joinedCount() == static_cast<uint64_t>(readers - 1);
+    if (shared)
+        std::cout << "SUCCESS: " << readers << " concurrent readers served by one request" << std::endl;
+    else
+        std::cout << "FAILED: Shared read correct=" << correct << " requests=" << sim.requestCount() - before << std::endl;
+
+    // Reads overlapping an in-flight one queue behind it and merge into one superset read
+    before = sim.requestCount();
+    uint64_t mergedBefore = handler.readCoalescer().mergedCount();
+    std::future<ReadResult> first = handler.readRegistersAsync(0, 4);
+    std::future<ReadResult> overlap = handler.readRegistersAsync(2, 4);
+    std::future<ReadResult> adjoining = handler.readRegistersAsync(6, 2);
+    std::future<ReadResult> extended = handler.readRegistersAsync(8, 2);
+    ReadResult r1 = first.get(), r2 = overlap.get(), r3 = adjoining.get(), r4 = extended.get();
+    bool merged = r1.ok && r2.ok && r3.ok && r4.ok && r2.values.size() == 4 && r2.values[0] == sim.getRegister(2) &&
+                  r3.values.size() == 2 && r3.values[1] == sim.getRegister(7) && r4.values[1] == sim.getRegister(9) &&
+                  sim.requestCount() == before + 2 && handler.readCoalescer().mergedCount() == mergedBefore + 2;
+
+    // Disjoint ranges go out at once
+    before = sim.requestCount();
+    std::future<ReadResult> low = handler.readRegistersAsync(0, 2);
+    std::future<ReadResult> high = handler.readRegistersAsync(5, 2);
+    bool disjoint = low.get().ok && high.get().ok && sim.requestCount() == before + 2;
+    if (merged && disjoint)
+        std::cout << "SUCCESS: Overlapping reads merged into one superset read, disjoint reads not delayed" << std::endl;
+    else
+        std::cout << "FAILED: Merging merged=" << merged << " disjoint=" << disjoint << std::endl;
+
+    // A read issued after a write does not join a read launched before it. The
+    // write is answered at once while the earlier read's old values are delayed.
+    uint16_t exportBefore = sim.getRegister(8);
+    uint16_t exportAfter = static_cast<uint16_t>(exportBefore == 40 ? 45 : 40);
+    std::future<ReadResult> launchedBefore = handler.readRegistersAsync(0, 10);
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    sim.setLatency(0, 0);
+    bool wrote = handler.writeRegister(8, exportAfter);
+    std::future<ReadResult> issuedAfter = handler.readRegistersAsync(8, 1);
+    ReadResult stale = launchedBefore.get(), fresh = issuedAfter.get();
+    sim.setLatency(20000, 0);
+    if (wrote && stale.ok && stale.values[8] == exportBefore && fresh.ok && fresh.values.size() == 1 &&
+        fresh.values[0] == exportAfter)
+        std::cout << "SUCCESS: Writes fence in-flight reads, the next read sees the written value" << std::endl;
+    else
+        std::cout << "FAILED: Read after write ok=" << fresh.ok << " value="
+                  << (fresh.values.empty() ? -1 : fresh.values[0]) << " expected " << exportAfter << std::endl;
+
+    // Without coalescing every caller sends its own frame
+    handler.setReadCoalescing(false);
+    before = sim.requestCount();
+    std::vector<std::future<ReadResult>> separate;
+    for (int i = 0; i < 4; ++i)
+        separate.push_back(handler.readRegistersAsync(0, 10));
+    bool allOk = true;
+    for (auto &f : separate)
+        allOk = f.get().ok && allOk;
+    if (allOk && sim.requestCount() == before + 4)
+        std::cout << "SUCCESS: Coalescing can be disabled" << std::endl;
+    else
+        std::cout << "FAILED: Uncoalesced reads sent " << sim.requestCount() - before << " requests" << std::endl;
+    sim.setLatency(0, 0);
+}
+
+void testJsonFrame()
+{
+    std::cout << "\n=== Test 29: Streaming JSON frame extraction ===" << std::endl;
+
+    FrameBuffer request;
+    ModbusFrame::buildReadRequest(0x11, 0, 2, request);
+    JsonFrameBody body;
+    body.build(request);
+    bool built = std::string(body.data, body.size) == "{\"frame\":\"110300000002c69b\"}" &&
+                 body.data[body.size] == '\0';
+
+    // Every split of the response into two chunks, including inside the key
+    // and between the two digits of a byte, decodes the same frame
+    const std::string response = "{\"status\": \"ok\", \"frame\" :  \"1103040904001402FD\", \"frame_count\": 1}";
+    const uint8_t expected[] = {0x11, 0x03, 0x04, 0x09, 0x04, 0x00, 0x14, 0x02, 0xFD};
+    bool streamed = true;
+    for (size_t split = 0; split <= response.size() && streamed; ++split)
+    {
+        FrameBuffer frame;
+        JsonFrameExtractor extractor(frame);
+        extractor.feed(response.data(), split);
+        extractor.feed(response.data() + split, response.size() - split);
+        streamed = extractor.valid() && frame.size == sizeof(expected) &&
+                   std::memcmp(frame.data, expected, sizeof(expected)) == 0;
+    }
+    FrameBuffer byteWise;
+    JsonFrameExtractor extractor(byteWise);
+    for (char c : response)
+        extractor.feed(&c, 1);
+    streamed = streamed && extractor.valid() && byteWise.size == sizeof(expected);
+
+    if (built && streamed)
+        std::cout << "SUCCESS: Body built in place, frame decoded identically for every chunk split" << std::endl;
+    else
+        std::cout << "FAILED: Body built=" << built << " streamed=" << streamed << std::endl;
+
+    // Missing or non-string fields are transport failures, bad hex a blank frame
+    auto parse = [](const std::string &text, FrameBuffer &frame)
+    {
+        JsonFrameExtractor parser(frame);
+        parser.feed(text.data(), text.size());
+        return parser;
+    };
+    FrameBuffer frame;
+    bool missing = !parse("{\"error\":\"frame missing\"}", frame).found() &&
+                   !parse("{\"frame\":\"1103", frame).found();
+    bool skipped = parse("{\"note\":\"frame\",\"frame\":null,\"frame\":\"0102\"}", frame).valid() &&
+                   frame.size == 2 && frame.data[1] == 0x02;
+    JsonFrameExtractor odd = parse("{\"frame\":\"110\"}", frame);
+    bool oddBlank = odd.found() && !odd.valid() && frame.size == 0;
+    JsonFrameExtractor digit = parse("{\"frame\":\"11G3\"}", frame);
+    bool digitBlank = digit.found() && !digit.valid() && frame.size == 0;
+    JsonFrameExtractor oversized = parse("{\"frame\":\"" + std::string(MODBUS_MAX_ADU * 2 + 2, 'A') + "\"}", frame);
+    bool overflowBlank = oversized.found() && !oversized.valid() && frame.size == 0;
+    if (missing && skipped && oddBlank && digitBlank && overflowBlank)
+        std::cout << "SUCCESS: Missing, non-string, malformed and oversized frames handled" << std::endl;
+    else
+        std::cout << "FAILED: Malformed responses missing=" << missing << " skipped=" << skipped
+                  << " odd=" << oddBlank << " digit=" << digitBlank << " overflow=" << overflowBlank << std::endl;
+
+    // One-shot post_json against the local SIM
+    InverterSimServer sim;
+    if (!sim.start())
+    {
+        std::cout << "FAILED: Could not start local SIM" << std::endl;
+        return;
+    }
+    FrameBuffer reply;
+    uint16_t values[2];
+    bool posted = post_json(sim.readUrl(), "test-key", request, reply) &&
+                  ModbusFrame::parseReadResponse(reply.data, reply.size, 2, values) &&
+                  values[0] == sim.getRegister(0) && values[1] == sim.getRegister(1);
+    if (posted)
+        std::cout << "SUCCESS: post_json decoded the SIM response into a binary frame" << std::endl;
+    else
+        std::cout << "FAILED: post_json round trip" << std::endl;
+}
+
+void testDeadbandFilter()
+{
+    std::cout << "\n=== Test 30: Report-by-exception sampling ===" << std::endl;
+
+    Deadband parsed;
+    bool parsing = parseDeadband("0.5", parsed) && parsed.mode == DeadbandMode::ABSOLUTE && parsed.threshold == 0.5f &&
+                   parseDeadband("2%", parsed) && parsed.mode == DeadbandMode::PERCENT && parsed.threshold == 2.0f &&
+                   !parseDeadband("abc", parsed) && !parseDeadband("-1", parsed) && !parseDeadband("1.5x", parsed) &&
+                   !parseDeadband("%", parsed);
+
+    PollingConfig config;
+    config.setParameters({ParameterType::AC_VOLTAGE, ParameterType::TEMPERATURE, ParameterType::OUTPUT_POWER});
+    Deadband temperature;
+    temperature.mode = DeadbandMode::ABSOLUTE;
+    temperature.threshold = 0.5f;
+    temperature.heartbeat = std::chrono::milliseconds(60000);
+    config.setParameterDeadband(ParameterType::TEMPERATURE, temperature);
+    Deadband power;
+    power.mode = DeadbandMode::PERCENT;
+    power.threshold = 2.0f;
+    config.setParameterDeadband(ParameterType::OUTPUT_POWER, power);
+
+    DeadbandFilter filter(config);
+    auto poll = [&filter](long long timestamp, float temp, float watts, bool withVoltage, Sample &sample)
+    {
+        sample = Sample();
+        sample.timestamp = timestamp;
+        if (withVoltage)
+            sample.setValue(ParameterType::AC_VOLTAGE, 230.0f);
+        sample.setValue(ParameterType::TEMPERATURE, temp);
+        sample.setValue(ParameterType::OUTPUT_POWER, watts);
+        return filter.apply(sample);
+    };
+
+    // Drift is measured from the last kept value, so 0.2 + 0.2 + 0.1 reports
+    Sample s;
+    bool absolute = poll(0, 40.0f, 1000.0f, true, s) && s.hasValue(ParameterType::TEMPERATURE) &&
+                    poll(1000, 40.2f, 1000.0f, true, s) && s.hasValue(ParameterType::AC_VOLTAGE) &&
+                    !s.hasValue(ParameterType::TEMPERATURE) && !s.hasValue(ParameterType::OUTPUT_POWER) &&
+                    !poll(2000, 40.4f, 1000.0f, false, s) && s.present == 0 &&
+                    poll(3000, 40.5f, 1000.0f, false, s) && s.getValue(ParameterType::TEMPERATURE) == 40.5f;
+    // Silent past the heartbeat: reported even without a change
+    bool heartbeat = !poll(62000, 40.5f, 1000.0f, false, s) && poll(63000, 40.5f, 1000.0f, false, s) &&
+                     s.hasValue(ParameterType::TEMPERATURE) && !s.hasValue(ParameterType::OUTPUT_POWER);
+    // 2% of the last kept 1000 W is 20 W; from 0 W any change counts
+    bool percent = !poll(64000, 40.5f, 1015.0f, false, s) && poll(65000, 40.5f, 1020.0f, false, s) &&
+                   s.getValue(ParameterType::OUTPUT_POWER) == 1020.0f && poll(66000, 40.5f, 0.0f, false, s) &&
+                   !poll(67000, 40.5f, 0.0f, false, s) && poll(68000, 40.5f, 1.0f, false, s);
+    if (parsing && absolute && heartbeat && percent)
+        std::cout << "SUCCESS: Absolute and percent deadbands, heartbeat and pass-through parameters" << std::endl;
+    else
+        std::cout << "FAILED: Deadband parsing=" << parsing << " absolute=" << absolute << " heartbeat=" << heartbeat
+                  << " percent=" << percent << std::endl;
+
+    // An hour of 1 Hz temperature (slow swing plus sensor noise) and export
+    // percent (a few setpoint steps)
+    PollingConfig slowConfig;
+    slowConfig.setParameters({ParameterType::TEMPERATURE, ParameterType::EXPORT_POWER_PERCENT});
+    temperature.heartbeat = std::chrono::milliseconds(300000);
+    slowConfig.setParameterDeadband(ParameterType::TEMPERATURE, temperature);
+    Deadband exportPercent;
+    exportPercent.mode = DeadbandMode::ABSOLUTE;
+    exportPercent.threshold = 1.0f;
+    exportPercent.heartbeat = std::chrono::milliseconds(600000);
+    slowConfig.setParameterDeadband(ParameterType::EXPORT_POWER_PERCENT, exportPercent);
+    DeadbandFilter slowFilter(slowConfig);
+    uint32_t noise = 12345;
+    size_t stored = 0;
+    const size_t polls = 3600;
+    for (size_t t = 0; t < polls; ++t)
+    {
+        noise = noise * 1103515245u + 12345u;
+        Sample sample;
+        sample.timestamp = static_cast<long long>(t) * 1000;
+        sample.setValue(ParameterType::TEMPERATURE,
+                        45.0f + 3.0f * std::sin(6.2831853f * t / polls) + (static_cast<int>((noise >> 16) % 11) - 5) * 0.01f);
+        sample.setValue(ParameterType::EXPORT_POWER_PERCENT, t < 1200 ? 100.0f : (t < 2400 ? 60.0f : 80.0f));
+        if (slowFilter.apply(sample))
+            stored++;
+    }
+    double kept = static_cast<double>(slowFilter.passedCount()) / (2 * polls);
+    if (kept < 0.1 && stored < polls / 10 && slowFilter.passedCount() + slowFilter.suppressedCount() == 2 * polls)
+        std::cout << "SUCCESS: Slow-moving values: " << stored << " of " << polls << " samples stored ("
+                  << slowFilter.passedCount() << " of " << 2 * polls << " values)" << std::endl;
+    else
+        std::cout << "FAILED: " << stored << " of " << polls << " samples stored, value ratio " << kept << std::endl;
+}
+
+void testWindowAggregator()
+{
+    std::cout << "\n=== Test 31: Windowed aggregation ===" << std::endl;
+
+    // 1 Hz polls at a constant 1200 W: 20 Wh per minute, the segment crossing
+    // each boundary counted in the window it leaves
+    WindowAggregator aggregator(std::chrono::milliseconds(60000), 8);
+    for (long long t = 0; t < 150000; t += 1000)
+    {
+        Sample sample;
+        sample.timestamp = t;
+        sample.setValue(ParameterType::AC_VOLTAGE, 230.0f + static_cast<float>((t / 1000) % 10));
+        sample.setValue(ParameterType::OUTPUT_POWER, 1200.0f);
+        aggregator.add(sample);
+    }
+    std::vector<WindowAggregate> windows;
+    bool closing = aggregator.drainInto(windows) == 2;
+    aggregator.flush();
+    std::vector<WindowAggregate> tail;
+    closing = closing && aggregator.drainInto(tail) == 1 && tail[0].samples == 30 && tail[0].end == 180000;
+    bool stats = closing && windows[0].start == 0 && windows[0].end == 60000 && windows[0].samples == 60 &&
+                 windows[1].start == 60000 && windows[0].min[0] == 230.0f && windows[0].max[0] == 239.0f &&
+                 std::fabs(windows[0].mean[0] - 234.5f) < 1e-4f && windows[0].last[0] == 239.0f &&
+                 !windows[0].hasValue(ParameterType::AC_CURRENT);
+    bool energy = closing && std::fabs(windows[0].energyWh - 20.0) < 1e-9 && std::fabs(windows[1].energyWh - 20.0) < 1e-9 &&
+                  std::fabs(tail[0].energyWh - 1200.0 * 29 / 3600) < 1e-9;
+    if (stats && energy)
+        std::cout << "SUCCESS: Per-window min/max/mean/last and 20 Wh per minute at 1200 W" << std::endl;
+    else
+        std::cout << "FAILED: Window closing=" << closing << " stats=" << stats << " energy=" << energy << std::endl;
+
+    // A linear ramp (P = 10 W/s * t) polled every 7 s off the window grid is
+    // integrated exactly, boundary segments split at the interpolated power
+    WindowAggregator ramp(std::chrono::milliseconds(60000), 8);
+    for (long long t = 0; t <= 126000; t += 7000)
+    {
+        Sample sample;
+        sample.timestamp = t;
+        sample.setValue(ParameterType::OUTPUT_POWER, 10.0f * t / 1000);
+        ramp.add(sample);
+    }
+    ramp.flush();
+    ramp.drainInto(windows);
+    double total = 0.0;
+    for (const WindowAggregate &window : windows)
+        total += window.energyWh;
+    bool exact = windows.size() == 3 && std::fabs(windows[0].energyWh - 5.0) < 1e-3 &&
+                 std::fabs(windows[1].energyWh - 15.0) < 1e-3 && std::fabs(total - 5.0 * 126 * 126 / 3600) < 1e-3;
+
+    // Readings further apart than a window are not integrated; a full queue drops windows
+    WindowAggregator sparse(std::chrono::milliseconds(60000), 2);
+    Sample later;
+    later.setValue(ParameterType::OUTPUT_POWER, 1000.0f);
+    for (long long t : {0LL, 200000LL, 300000LL, 400000LL})
+    {
+        later.timestamp = t;
+        sparse.add(later);
+    }
+    sparse.drainInto(windows);
+    bool gap = windows.size() == 2 && windows[0].energyWh == 0.0 && windows[1].energyWh == 0.0 &&
+               sparse.droppedCount() == 1;
+    if (exact && gap)
+        std::cout << "SUCCESS: Ramp integrated exactly across boundaries (" << total << " Wh), gaps not integrated" << std::endl;
+    else
+        std::cout << "FAILED: Ramp energy exact=" << exact << " total=" << total << " gap=" << gap << std::endl;
+
+    // An hour at 1 Hz of all ten parameters, raw versus 1-minute aggregates
+    PollingConfig config;
+    config.setComprehensiveProfile();
+    SampleEncoder encoder(config);
+    SampleBatch raw;
+    WindowAggregator minute(std::chrono::milliseconds(60000), 64);
+    uint32_t noise = 777;
+    for (long long t = 0; t < 3600000; t += 1000)
+    {
+        Sample sample;
+        sample.timestamp = t;
+        for (size_t i = 0; i < PARAMETER_COUNT; ++i)
+        {
+            noise = noise * 1103515245u + 12345u;
+            sample.setValue(static_cast<ParameterType>(i), 50.0f + static_cast<float>((noise >> 16) % 200) / 10.0f);
+        }
+        raw.append(sample);
+        minute.add(sample);
+    }
+    minute.flush();
+    minute.drainInto(windows);
+    std::vector<uint8_t> rawPayload, aggregatePayload;
+    std::vector<WindowAggregate> decoded;
+    SampleBatch notSamples;
+    uint8_t device = 0;
+    bool roundTrip = encoder.encode(raw, 0x11, rawPayload, true) &&
+                     encoder.encodeAggregates(windows, 0x11, aggregatePayload, true) &&
+                     encoder.decodeAggregates(aggregatePayload.data(), aggregatePayload.size(), decoded, device) &&
+                     !encoder.decode(aggregatePayload.data(), aggregatePayload.size(), notSamples, device) &&
+                     device == 0x11 && decoded.size() == 60;
+    // Statistics travel as raw register values, so they are exact to half a register step
+    for (size_t w = 0; roundTrip && w < decoded.size(); ++w)
+    {
+        roundTrip = decoded[w].start == windows[w].start && decoded[w].samples == 60 &&
+                    decoded[w].present == windows[w].present &&
+                    std::fabs(decoded[w].energyWh - windows[w].energyWh) < 1e-3;
+        for (size_t p = 0; p < PARAMETER_COUNT; ++p)
+        {
+            float step = 0.5f / config.getParameterConfig(static_cast<ParameterType>(p)).gain + 1e-3f;
+            roundTrip = roundTrip && std::fabs(decoded[w].mean[p] - windows[w].mean[p]) <= step &&
+                        std::fabs(decoded[w].min[p] - windows[w].min[p]) <= 2 * step &&
+                        std::fabs(decoded[w].max[p] - windows[w].max[p]) <= 2 * step &&
+                        std::fabs(decoded[w].last[p] - windows[w].last[p]) <= 2 * step;
+        }
+    }
+    if (roundTrip && aggregatePayload.size() * 10 < rawPayload.size())
+        std::cout << "SUCCESS: 1 h at 1 Hz uploads as " << aggregatePayload.size() << " bytes of 1-minute aggregates vs "
+                  << rawPayload.size() << " bytes raw" << std::endl;
+    else
+        std::cout << "FAILED: Aggregate round trip=" << roundTrip << " bytes " << aggregatePayload.size() << " vs "
+                  << rawPayload.size() << std::endl;
+}
+
+int main(int argc, char **argv)
 {
     std::cout << "Modbus Handler Test Suite" << std::endl;
     std::cout << "=========================" << std::endl;
 
+    // --offline runs the API scenarios against the embedded SIM instead of config.ini
+    InverterSimServer offlineSim;
+    if (argc > 1 && std::strcmp(argv[1], "--offline") == 0)
+    {
+        if (!offlineSim.start())
+            return 1;
+        Config &config = Config::getInstance();
+        config.setValue("API", "api_key", "offline");
+        config.setValue("ENDPOINTS", "read_url", offlineSim.readUrl());
+        config.setValue("ENDPOINTS", "write_url", offlineSim.writeUrl());
+        std::cout << "Offline mode: local SIM on port " << offlineSim.port() << std::endl;
+    }
+
     // Run all tests based on API documentation scenarios
     testInvalidFrame();            // Test 1: Invalid frame -> blank response
     testWriteToReadOnlyRegister(); // Test 2: Valid frame, invalid address -> error 0x02
@@ -498,6 +2151,28 @@ int main()
     testSuccessfulWrite();         // Test 7: Try to find writable register
     testErrorMessages();           // Test 8: Error code meanings
     testSpecificErrorScenarios();  // Test 9: Specific error scenarios
+    testPollPlanner();             // Test 10: Register coalescing
+    testCRCImplementations();      // Test 11: CRC variants agree
+    testFrameCodec();              // Test 12: Frame build/parse
+    testDataBufferPolicies();      // Test 13: Ring buffer overflow policies
+    testSampleLayout();            // Test 14: Compact sample representation
+    testPollScheduler();           // Test 15: Deadline scheduling
+    testWorkerPool();              // Test 16: Fleet worker pool
+    testSimServer();               // Test 17: Local Inverter SIM
+    testMetrics();                 // Test 18: Metrics instrumentation
+    testRetryPolicy();             // Test 19: Retry backoff and circuit breaker
+    testSampleUpload();            // Test 20: Binary batch encoding and upload
+    testSampleStore();             // Test 21: Crash-safe sample store
+    testTcpTransports();           // Test 22: Raw socket transports
+    testPipelinedModbusTcp();      // Test 23: Transaction-id matched pipelining
+    testMultipleRegisterWrites();  // Test 24: FC16 / FC23
+    testRegisterMap();             // Test 25: Declarative register layouts
+    testRegisterCodec();           // Test 26: Batch and build-time decoders
+    testRegisterCache();           // Test 27: Inverter register cache
+    testReadCoalescing();          // Test 28: Single-flight reads
+    testJsonFrame();               // Test 29: Streaming JSON frame extraction
+    testDeadbandFilter();          // Test 30: Report-by-exception sampling
+    testWindowAggregator();        // Test 31: Windowed aggregation and energy
 
     std::cout << "\nAll tests completed!" << std::endl;
     return 0;